@@ -0,0 +1,97 @@
+#include <idbuffer.hpp>
+
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+/**
+ * Measures IdBuffer::render on a large grid, without any window or GPU. Its correctness is checked by idbuffertest.
+ * Usage: idbufferbenchmark [grid side]
+ * The matrix is the identity: x and y are already normalised device coordinates and the depth grows with z.
+ * Times are in milliseconds.
+ */
+
+static const double IDENTITY[16] = {1, 0, 0, 0,
+                                    0, 1, 0, 0,
+                                    0, 0, 1, 0,
+                                    0, 0, 0, 1};
+
+static double measure(const std::function<void()> &task)
+{
+    auto start = std::chrono::steady_clock::now();
+    task();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static vtkIdType addPoint(vtkPoints* points, double x, double y, double z)
+{
+    return points->InsertNextPoint(x, y, z);
+}
+
+static void addTriangle(vtkCellArray* polys, vtkIdType v0, vtkIdType v1, vtkIdType v2)
+{
+    vtkIdType ids[3] = {v0, v1, v2};
+    polys->InsertNextCell(3, ids);
+}
+
+static vtkSmartPointer<vtkPolyData> makeSurface(vtkPoints* points, vtkCellArray* polys)
+{
+    auto surface = vtkSmartPointer<vtkPolyData>::New();
+    surface->SetPoints(points);
+    surface->SetPolys(polys);
+    return surface;
+}
+
+//Grid of side x side vertices filling the view, with a depth ripple so that the depth test is exercised
+static vtkSmartPointer<vtkPolyData> makeGrid(unsigned int side)
+{
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    auto polys = vtkSmartPointer<vtkCellArray>::New();
+    for(unsigned int i = 0; i < side; i++)
+        for(unsigned int j = 0; j < side; j++)
+            addPoint(points, 2.0 * j / (side - 1) - 1, 2.0 * i / (side - 1) - 1, ((i + j) % 2) * 0.1);
+    for(unsigned int i = 0; i + 1 < side; i++)
+        for(unsigned int j = 0; j + 1 < side; j++)
+        {
+            vtkIdType v = static_cast<vtkIdType>(i) * side + j;
+            addTriangle(polys, v, v + 1, v + side + 1);
+            addTriangle(polys, v, v + side + 1, v + side);
+        }
+    return makeSurface(points, polys);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int side = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 1001;
+    if(side < 2)
+    {
+        std::cerr << "The grid side must be at least 2" << std::endl;
+        return 1;
+    }
+    auto grid = makeGrid(side);
+    std::cout << "Grid of " << 2 * static_cast<size_t>(side - 1) * (side - 1) << " triangles at 1920x1080" << std::endl;
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    for(unsigned int threads : {1u, cores})
+    {
+        IdBuffer buffer;
+        buffer.setThreadsNumber(threads);
+        buffer.render(grid, IDENTITY, 1920, 1080);      //The triangles are read once per geometry
+        double time = measure([&buffer, &grid]()
+        {
+            buffer.render(grid, IDENTITY, 1920, 1080);
+        });
+        std::cout << "  " << threads << " threads: " << time << " ms" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <plyasciireader.hpp>
+#include <drawabletrianglemesh.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <QDir>
+
+using namespace std;
+using namespace Drawables;
+
+/**
+ * Compares DrawableTriangleMesh::load with PLYAsciiReader on an ASCII PLY file.
+ * Usage: plyasciibenchmark [file.ply]
+ * Without a file, a grid of about 10M vertices (20M triangles) is written to the temporary directory first.
+ */
+
+static double measure(const std::function<void()> &task)
+{
+    auto start = std::chrono::steady_clock::now();
+    task();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool writeGrid(const std::string &filename, unsigned int side)
+{
+    FILE* out = fopen(filename.c_str(), "w");
+    if(out == nullptr)
+        return false;
+    size_t verticesNumber = static_cast<size_t>(side) * side;
+    size_t trianglesNumber = 2 * static_cast<size_t>(side - 1) * (side - 1);
+    fprintf(out, "ply\nformat ascii 1.0\nelement vertex %zu\nproperty float x\nproperty float y\nproperty float z\n"
+                 "element face %zu\nproperty list uchar int vertex_indices\nend_header\n", verticesNumber, trianglesNumber);
+    for(unsigned int i = 0; i < side; i++)
+        for(unsigned int j = 0; j < side; j++)
+            fprintf(out, "%.6f %.6f %.6f\n", 0.5 * i, 0.5 * j, std::sin(0.01 * i) * std::cos(0.01 * j) * 10);
+    for(unsigned int i = 0; i + 1 < side; i++)
+        for(unsigned int j = 0; j + 1 < side; j++)
+        {
+            unsigned int v = i * side + j;
+            fprintf(out, "3 %u %u %u\n3 %u %u %u\n", v, v + side, v + 1, v + 1, v + side, v + side + 1);
+        }
+    return fclose(out) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filename;
+    bool generated = false;
+    if(argc > 1)
+        filename = argv[1];
+    else
+    {
+        filename = QDir::temp().filePath("plyasciibenchmark.ply").toStdString();
+        std::cout << "Writing a 10M vertices grid to " << filename << "..." << std::endl;
+        if(!writeGrid(filename, 3163))
+        {
+            std::cerr << "Unable to write " << filename << std::endl;
+            return 1;
+        }
+        generated = true;
+    }
+
+    double libraryTime = measure([&filename]()
+    {
+        DrawableTriangleMesh mesh;
+        mesh.load(filename);
+        std::cout << "DrawableTriangleMesh::load: " << mesh.getVerticesNumber() << " vertices" << std::endl;
+    });
+    std::cout << "  " << libraryTime << " s" << std::endl;
+
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    for(unsigned int threads : {1u, cores})
+    {
+        PLYAsciiReader reader;
+        reader.setThreadsNumber(threads);
+        bool read = false;
+        double readerTime = measure([&reader, &filename, &read](){ read = reader.read(filename); });
+        if(!read)
+        {
+            std::cerr << "PLYAsciiReader could not read " << filename << std::endl;
+            return 1;
+        }
+        std::cout << "PLYAsciiReader, " << threads << " threads: " << readerTime << " s (" << libraryTime / readerTime << "x)" << std::endl;
+    }
+
+    //What MeshLoader does: parallel parsing, binary copy, library load of the copy
+    std::string binaryFilename = QDir::temp().filePath("plyasciibenchmark.binary.ply").toStdString();
+    double loaderTime = measure([&filename, &binaryFilename]()
+    {
+        PLYAsciiReader reader;
+        if(reader.read(filename) && reader.hasOnlyGeometry() && reader.writeBinary(binaryFilename))
+        {
+            DrawableTriangleMesh mesh;
+            mesh.load(binaryFilename);
+        }
+    });
+    std::cout << "Parallel parsing and binary load: " << loaderTime << " s (" << libraryTime / loaderTime << "x)" << std::endl;
+
+    std::remove(binaryFilename.c_str());
+    if(generated)
+        std::remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,256 @@
+#include <binaryannotationfilemanager.hpp>
+#include <cellpalette.hpp>
+#include <scenecache.hpp>
+
+#include <drawableannotation.hpp>
+#include <drawabletrianglemesh.hpp>
+#include <semanticsfilemanager.hpp>
+
+#include <vtkCamera.h>
+#include <vtkPropAssembly.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Drawables;
+
+/**
+ * Measures the rendering of the viewer without showing any window: the scene is kept by a SceneCache, as in
+ * MainWindow::slotRender, and drawn in an offscreen render window.
+ * Usage: renderbenchmark file.ply [annotations file] [frames per phase]
+ * The scripted phases are a camera orbit, triangle selection toggles, annotation visibility toggles and full
+ * rebuilds (everything marked as dirty, as every view update did before the cache). For each phase the time spent
+ * bringing the scene up to date and the time of the frame are reported as percentiles, in milliseconds, as JSON on
+ * the standard output. Progress goes to the standard error.
+ * Without a GPU, run it against a VTK built with OSMesa or EGL, or with Mesa's software rasteriser
+ * (e.g. LIBGL_ALWAYS_SOFTWARE=1).
+ */
+
+struct Samples
+{
+    std::vector<double> rebuild;
+    std::vector<double> frame;
+};
+
+static double measure(const std::function<void()> &task)
+{
+    auto start = std::chrono::steady_clock::now();
+    task();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double percentile(std::vector<double> values, double p)
+{
+    if(values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+//JSON string contents: quotes, backslashes and control characters are escaped
+static std::string escape(const std::string &value)
+{
+    std::string escaped;
+    for(char c : value)
+    {
+        switch(c)
+        {
+            case '"':   escaped += "\\\""; break;
+            case '\\':  escaped += "\\\\"; break;
+            case '\n':  escaped += "\\n"; break;
+            case '\r':  escaped += "\\r"; break;
+            case '\t':  escaped += "\\t"; break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20)
+                {
+                    char code[7];
+                    snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(c)));
+                    escaped += code;
+                } else
+                    escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static void writeStatistics(const std::string &name, const std::vector<double> &values, bool last)
+{
+    double sum = 0;
+    for(auto value : values)
+        sum += value;
+    std::cout << "      \"" << name << "\": {\"count\": " << values.size()
+              << ", \"mean\": " << (values.empty() ? 0 : sum / values.size())
+              << ", \"p50\": " << percentile(values, 0.5)
+              << ", \"p90\": " << percentile(values, 0.9)
+              << ", \"p99\": " << percentile(values, 0.99)
+              << ", \"max\": " << percentile(values, 1.0) << "}" << (last ? "" : ",") << std::endl;
+}
+
+static void render(const vtkSmartPointer<vtkRenderWindow> &window)
+{
+    window->Render();
+    //The frame is over once the GL queue has been drained, not when the commands have been issued: reading a
+    //pixel back waits for it
+    delete[] window->GetPixelData(0, 0, 0, 0, 0);
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2)
+    {
+        std::cerr << "Usage: renderbenchmark file.ply [annotations file] [frames per phase]" << std::endl;
+        return 1;
+    }
+    std::string meshFilename = argv[1];
+    std::string annotationsFilename = argc > 2 ? argv[2] : "";
+    unsigned int frames = argc > 3 ? static_cast<unsigned int>(std::max(1, std::atoi(argv[3]))) : 120;
+
+    std::cerr << "Loading " << meshFilename << "..." << std::endl;
+    auto mesh = std::make_shared<DrawableTriangleMesh>();
+    mesh->load(meshFilename);
+    if(mesh->getTrianglesNumber() == 0)
+    {
+        std::cerr << "Unable to load " << meshFilename << std::endl;
+        return 1;
+    }
+    if(!annotationsFilename.empty())
+    {
+        std::cerr << "Loading " << annotationsFilename << "..." << std::endl;
+        if(BinaryAnnotationFileManager::isBinaryAnnotationFile(annotationsFilename))
+        {
+            BinaryAnnotationFileManager manager;
+            manager.setMesh(mesh);
+            auto read = manager.readAnnotations(annotationsFilename);
+            if(!manager.getError().empty())
+            {
+                std::cerr << "Unable to load " << annotationsFilename << ": " << manager.getError() << std::endl;
+                return 1;
+            }
+            for(auto annotation : read)
+                mesh->addAnnotation(annotation);
+        } else
+        {
+            SemantisedTriangleMesh::SemanticsFileManager manager;
+            manager.setMesh(mesh);
+            mesh->setAnnotations(manager.readAndStoreAnnotations(annotationsFilename));
+        }
+    }
+    auto annotations = mesh->getAnnotations();
+
+    auto window = vtkSmartPointer<vtkRenderWindow>::New();
+    window->SetOffScreenRendering(1);
+    window->SetSize(1280, 720);
+    auto renderer = vtkSmartPointer<vtkRenderer>::New();
+    renderer->SetBackground(1, 1, 1);
+    window->AddRenderer(renderer);
+    auto canvas = vtkSmartPointer<vtkPropAssembly>::New();
+    renderer->AddActor(canvas);
+
+    auto palette = std::make_shared<CellPalette>();
+    SceneCache sceneCache;
+    sceneCache.setPalette(palette);
+    sceneCache.setAssembly(canvas);
+    sceneCache.setRenderer(renderer);
+    sceneCache.setMesh(mesh);
+
+    double buildTime = measure([&sceneCache](){ sceneCache.update(); });
+    renderer->ResetCamera();
+    double firstFrameTime = measure([&window](){ render(window); });
+
+    std::vector<std::pair<std::string, Samples> > phases;
+
+    std::cerr << "Orbit..." << std::endl;
+    Samples orbit;
+    for(unsigned int i = 0; i < frames; i++)
+    {
+        renderer->GetActiveCamera()->Azimuth(360.0 / frames);
+        renderer->ResetCameraClippingRange();
+        orbit.rebuild.push_back(measure([&sceneCache](){ sceneCache.update(); }));
+        orbit.frame.push_back(measure([&window](){ render(window); }));
+    }
+    phases.push_back(std::make_pair("orbit", orbit));
+
+    //What the triangle selection does: a block of triangles is highlighted and then restored
+    std::cerr << "Selection toggles..." << std::endl;
+    Samples selection;
+    unsigned char red[3] = {255, 0, 0};
+    vtkIdType trianglesNumber = static_cast<vtkIdType>(mesh->getTrianglesNumber());
+    vtkIdType blockSize = std::max(static_cast<vtkIdType>(1), std::min(static_cast<vtkIdType>(10000), trianglesNumber / 100));
+    for(unsigned int i = 0; i < frames; i++)
+    {
+        vtkIdType first = (static_cast<vtkIdType>(i) * 7919 * blockSize) % std::max(static_cast<vtkIdType>(1), trianglesNumber - blockSize);
+        selection.rebuild.push_back(measure([&]()
+        {
+            if(i % 2 == 0)
+                for(vtkIdType t = first; t < first + blockSize && t < trianglesNumber; t++)
+                    palette->highlight(t, red);
+            else
+                palette->restoreAll();
+            sceneCache.update();
+        }));
+        selection.frame.push_back(measure([&window](){ render(window); }));
+    }
+    palette->restoreAll();
+    sceneCache.update();
+    phases.push_back(std::make_pair("selection", selection));
+
+    std::cerr << "Annotation visibility toggles..." << std::endl;
+    Samples visibility;
+    for(unsigned int i = 0; i < frames && !annotations.empty(); i++)
+    {
+        auto annotation = std::dynamic_pointer_cast<DrawableAnnotation>(annotations[(i / 2) % annotations.size()]);
+        if(annotation == nullptr)
+            continue;
+        visibility.rebuild.push_back(measure([&]()
+        {
+            annotation->setDrawAnnotation(i % 2 == 1);
+            sceneCache.markAnnotationViewDirty(annotation->getId());
+            sceneCache.update();
+        }));
+        visibility.frame.push_back(measure([&window](){ render(window); }));
+    }
+    phases.push_back(std::make_pair("visibility", visibility));
+
+    std::cerr << "Full rebuilds..." << std::endl;
+    Samples rebuild;
+    for(unsigned int i = 0; i < std::max(1u, frames / 10); i++)
+    {
+        rebuild.rebuild.push_back(measure([&sceneCache]()
+        {
+            sceneCache.markAllDirty();
+            sceneCache.update();
+        }));
+        rebuild.frame.push_back(measure([&window](){ render(window); }));
+    }
+    phases.push_back(std::make_pair("full_rebuild", rebuild));
+
+    std::cout << "{" << std::endl;
+    std::cout << "  \"mesh\": \"" << escape(meshFilename) << "\"," << std::endl;
+    std::cout << "  \"triangles\": " << trianglesNumber << "," << std::endl;
+    std::cout << "  \"annotations\": " << annotations.size() << "," << std::endl;
+    std::cout << "  \"chunks\": " << sceneCache.getChunkedSurface()->getChunksNumber() << "," << std::endl;
+    std::cout << "  \"scene_build_ms\": " << buildTime << "," << std::endl;
+    std::cout << "  \"first_frame_ms\": " << firstFrameTime << "," << std::endl;
+    std::cout << "  \"phases\": {" << std::endl;
+    for(size_t i = 0; i < phases.size(); i++)
+    {
+        std::cout << "    \"" << phases[i].first << "\": {" << std::endl;
+        writeStatistics("rebuild_ms", phases[i].second.rebuild, false);
+        writeStatistics("frame_ms", phases[i].second.frame, true);
+        std::cout << "    }" << (i + 1 < phases.size() ? "," : "") << std::endl;
+    }
+    std::cout << "  }" << std::endl;
+    std::cout << "}" << std::endl;
+    return 0;
+}
@@ -3,6 +3,7 @@
 
 
 #include <drawabletrianglemesh.hpp>
+#include <meshsidecarcache.hpp>
 #include <annotation.hpp>
 
 #include <vtkSmartPointer.h>
@@ -45,10 +46,13 @@ public:
 
     const std::shared_ptr<Drawables::DrawableTriangleMesh> &getMesh() const;
     void setMesh(const std::shared_ptr<Drawables::DrawableTriangleMesh> &newMesh);
+    const std::shared_ptr<MeshSidecarCache> &getMeshCache() const;
+    void setMeshCache(const std::shared_ptr<MeshSidecarCache> &newMeshCache);           //Set before the mesh it belongs to
 
 
 signals:
     void updateView();
+    void annotationViewChanged(std::string id);          //Its selection changed, the actors have to be rebuilt
 
 protected:
 
@@ -60,6 +64,7 @@ protected:
     QVTKOpenGLNativeWidget * qvtkWidget;
 
     std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+    std::shared_ptr<MeshSidecarCache> meshCache;
     double tolerance;
     vtkIdType reachedID;
 };
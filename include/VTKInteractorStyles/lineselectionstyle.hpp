@@ -2,7 +2,12 @@
 #define LINESELECTIONSTYLE_H
 
 #include <drawabletrianglemesh.hpp>
+#include <meshsidecarcache.hpp>
 #include <drawablelineannotation.hpp>
+#include <meshiddataset.hpp>
+#include <selectionmarkers.hpp>
+#include <selectionset.hpp>
+#include <meshindex.hpp>
 #include <map>
 #include <vtkSmartPointer.h>
 #include <vtkInteractorStyleRubberBandPick.h>
@@ -30,13 +35,12 @@ public:
     void modifySelectedLines();
     void resetSelection();
     void defineSelection(std::vector<std::vector<std::shared_ptr<SemantisedTriangleMesh::Vertex> > > polylines);
-    void finalizeAnnotation(std::string id, std::string tag, unsigned char color[]);
+    void finalizeAnnotation(AnnotationIndex id, std::string tag, unsigned char color[]);
     void draw();
 
     vtkSmartPointer<vtkActor> getSplineActor() const;
     void setSplineActor(const vtkSmartPointer<vtkActor> &value);
-    vtkSmartPointer<vtkPropAssembly> getSphereAssembly() const;
-    void setSphereAssembly(const vtkSmartPointer<vtkPropAssembly> &value);
+    const std::shared_ptr<SelectionMarkers> &getMarkers() const;
     vtkSmartPointer<vtkPropAssembly> getAssembly() const;
     void setAssembly(const vtkSmartPointer<vtkPropAssembly> &value);
     vtkSmartPointer<vtkRenderer> getRen() const;
@@ -49,8 +53,8 @@ public:
     void setPointsSelectionStatus(std::map<unsigned long, bool> *value);
     vtkSmartPointer<vtkCellPicker> getCellPicker() const;
     void setCellPicker(const vtkSmartPointer<vtkCellPicker> &value);
-    vtkSmartPointer<vtkPolyData> getPoints() const;
-    void setPoints(const vtkSmartPointer<vtkPolyData> &value);
+    const std::shared_ptr<MeshIdDataset> &getIdDataset() const;
+    void setIdDataset(const std::shared_ptr<MeshIdDataset> &newIdDataset);
 
     double getSphereRadius() const;
     void setSphereRadius(double value);
@@ -72,6 +76,8 @@ public:
 
     const std::shared_ptr<Drawables::DrawableTriangleMesh> &getMesh() const;
     void setMesh(const std::shared_ptr<Drawables::DrawableTriangleMesh> &newMesh);
+    const std::shared_ptr<MeshSidecarCache> &getMeshCache() const;
+    void setMeshCache(const std::shared_ptr<MeshSidecarCache> &newMeshCache);           //Set before the mesh it belongs to
 
 signals:
     void updateView();
@@ -80,11 +86,12 @@ protected:
     std::map<unsigned long, bool>* pointsSelectionStatus;
     vtkSmartPointer<vtkCellArray> polyLineSegments;
     vtkSmartPointer<vtkPoints> polylinePoints;
-    vtkSmartPointer<vtkPolyData> points;
+    std::shared_ptr<MeshIdDataset> idDataset;
     vtkSmartPointer<vtkParametricSpline> spline;
     vtkSmartPointer<vtkRenderer> ren;
     vtkSmartPointer<vtkPropAssembly> assembly;          //Assembly of actors
-    vtkSmartPointer<vtkPropAssembly> sphereAssembly;    //Assembly of spheres
+    std::shared_ptr<SelectionMarkers> markers;          //A sphere on each vertex picked by the user
+    SelectionSet selectedEdges;
     vtkSmartPointer<vtkActor> splineActor;
     QVTKOpenGLNativeWidget* qvtkwidget;
     std::vector<std::shared_ptr<SemantisedTriangleMesh::Vertex> > polyLine;
@@ -92,6 +99,7 @@ protected:
     std::shared_ptr<SemantisedTriangleMesh::Vertex> firstVertex;
     std::shared_ptr<SemantisedTriangleMesh::Vertex> lastVertex;
     std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+    std::shared_ptr<MeshSidecarCache> meshCache;
     std::shared_ptr<Drawables::DrawableLineAnnotation> annotation;
     double sphereRadius;
     double tolerance;
@@ -3,6 +3,8 @@
 
 #include <drawableattribute.hpp>
 #include <drawabletrianglemesh.hpp>
+#include <meshsidecarcache.hpp>
+#include <meshindex.hpp>
 
 #include <vtkInteractorStyleTrackballCamera.h>
 #include <QVTKOpenGLNativeWidget.h>
@@ -42,6 +44,8 @@ public:
     //Getters and setters
     std::shared_ptr<Drawables::DrawableTriangleMesh> getMesh() const;
     void setMesh(std::shared_ptr<Drawables::DrawableTriangleMesh> value);
+    const std::shared_ptr<MeshSidecarCache> &getMeshCache() const;
+    void setMeshCache(const std::shared_ptr<MeshSidecarCache> &newMeshCache);           //Set before the mesh it belongs to
     QVTKOpenGLNativeWidget *getQvtkwidget() const;
     void setQvtkwidget(QVTKOpenGLNativeWidget *value);
     vtkSmartPointer<vtkRenderer> getMeshRenderer() const;
@@ -65,6 +69,7 @@ signals:
     void updateView();
 protected:
     std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+    std::shared_ptr<MeshSidecarCache> meshCache;
     QVTKOpenGLNativeWidget* qvtkwidget;
     vtkSmartPointer<vtkCellPicker> cellPicker;
     vtkSmartPointer<vtkRenderer> meshRenderer;
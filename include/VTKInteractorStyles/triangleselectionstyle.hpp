@@ -2,15 +2,24 @@
 #define TRIANGLESELECTIONSTYLE_H
 
 #include <drawabletrianglemesh.hpp>
+#include <meshsidecarcache.hpp>
 #include <drawablesurfaceannotation.hpp>
+#include <meshiddataset.hpp>
+#include <selectionmarkers.hpp>
+#include <cellpalette.hpp>
+#include <selectionset.hpp>
+#include <meshindex.hpp>
+#include <screenlasso.hpp>
 
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
 
 #include <vtkSmartPointer.h>
 #include <vtkCellPicker.h>
 #include <vtkActor.h>
+#include <vtkActor2D.h>
 #include <vtkInteractorStyleRubberBandPick.h>
 #include <vtkSpline.h>
 #include <vtkRenderer.h>
@@ -30,7 +39,8 @@ public:
     enum class SelectionType{
         RECTANGLE_AREA,
         LASSO_AREA,
-        PAINTED_LINE
+        PAINTED_LINE,
+        FREEHAND_LASSO              //A polygon dragged on the screen, no path is searched on the mesh
     };
     constexpr static double TOLERANCE = 5e-2;
     constexpr static double RADIUS_RATIO = 100;
@@ -43,10 +53,9 @@ public:
     void OnMouseMove() override;
     void OnLeftButtonDown() override;
     void OnLeftButtonUp() override;
-    void SetTriangles(vtkSmartPointer<vtkPolyData> triangles);
     void resetSelection();
-    void defineSelection(std::vector<std::string> selected);
-    void finalizeAnnotation(std::string id, std::string tag, unsigned char color[]);
+    void defineSelection(const std::vector<TriangleIndex> &selected);
+    void finalizeAnnotation(AnnotationIndex id, std::string tag, unsigned char color[]);
     void draw();
 
     std::shared_ptr<SemantisedTriangleMesh::Annotation> getAnnotation() const;
@@ -72,20 +81,33 @@ public:
 
     const std::shared_ptr<Drawables::DrawableTriangleMesh> &getMesh() const;
     void setMesh(const std::shared_ptr<Drawables::DrawableTriangleMesh> &newMesh);
+    const std::shared_ptr<MeshSidecarCache> &getMeshCache() const;
+    void setMeshCache(const std::shared_ptr<MeshSidecarCache> &newMeshCache);           //Set before the mesh it belongs to
 
     const std::vector<std::shared_ptr<SemantisedTriangleMesh::Vertex> > &getPolygonContour() const;
     void setPolygonContour(const std::vector<std::shared_ptr<SemantisedTriangleMesh::Vertex> > &newPolygonContour);
 
+    const std::shared_ptr<MeshIdDataset> &getIdDataset() const;
+    void setIdDataset(const std::shared_ptr<MeshIdDataset> &newIdDataset);
+
     SelectionType getSelectionType() const;
     void setSelectionType(SelectionType newSelectionType);
 
+    const std::shared_ptr<CellPalette> &getPalette() const;
+    void setPalette(const std::shared_ptr<CellPalette> &newPalette);          //Set before the mesh
+    const std::shared_ptr<ScreenLasso> &getFreehandLasso() const;
+
 signals:
     void updateView();
 private:
         vtkSmartPointer<vtkPropAssembly> assembly;          //Assembly of actors
-        vtkSmartPointer<vtkPropAssembly> sphereAssembly;    //Assembly of spheres
-        vtkSmartPointer<vtkPolyData> triangles;
+        std::shared_ptr<SelectionMarkers> markers;          //A sphere on each vertex picked by the user
+        std::shared_ptr<CellPalette> palette;               //Colours of the surface, selected triangles are highlighted in it
+        SelectionSet selectedTriangles;
+        std::shared_ptr<MeshIdDataset> idDataset;
         vtkSmartPointer<vtkActor> splineActor;
+        std::shared_ptr<ScreenLasso> freehandLasso;         //The polygon being dragged, in the pixels of the viewport
+        vtkSmartPointer<vtkActor2D> freehandActor;
         vtkSmartPointer<vtkCellPicker> cellPicker;      //The cell picker
         vtkSmartPointer<vtkPoints> splinePoints;
         vtkSmartPointer<vtkRenderer> ren;
@@ -96,14 +118,20 @@ private:
         bool showSelectedTriangles;
         bool alreadyStarted;
         bool lasso_started;
+        bool freehandStarted;
         SelectionType selectionType;
         std::shared_ptr<SemantisedTriangleMesh::Annotation> annotation;
         std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+        std::shared_ptr<MeshSidecarCache> meshCache;
         std::shared_ptr<SemantisedTriangleMesh::Vertex> firstVertex;
         std::shared_ptr<SemantisedTriangleMesh::Vertex> lastVertex;
         std::shared_ptr<SemantisedTriangleMesh::Vertex> innerVertex;
         std::vector<std::shared_ptr<SemantisedTriangleMesh::Vertex>> polygonContour;
 
+        void addFreehandPoint();
+        void drawFreehandPath();
+        void selectFreehand();
+
 };
 
 #endif // TRIANGLESELECTIONSTYLE_H
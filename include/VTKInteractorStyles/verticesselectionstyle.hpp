@@ -2,7 +2,12 @@
 #define VERTICESSELECTIONSTYLE_H
 
 #include <drawabletrianglemesh.hpp>
+#include <meshsidecarcache.hpp>
 #include <drawablepointannotation.hpp>
+#include <meshiddataset.hpp>
+#include <selectionmarkers.hpp>
+#include <selectionset.hpp>
+#include <meshindex.hpp>
 
 #include <vector>
 #include <map>
@@ -40,14 +45,15 @@ public:
 
 	void resetSelection();
 
-    void defineSelection(std::vector<std::shared_ptr<SemantisedTriangleMesh::Vertex> > selected);
+    void defineSelection(const std::vector<VertexIndex> &selected);
+    void defineSelection(const std::vector<std::shared_ptr<SemantisedTriangleMesh::Vertex> > &selected);
 
     void draw();
 
-    void finalizeAnnotation(std::string id, std::string tag, unsigned char color[]);
+    void finalizeAnnotation(AnnotationIndex id, std::string tag, unsigned char color[]);
 
-    vtkSmartPointer<vtkPolyData> getPoints() const;
-    void setPoints(const vtkSmartPointer<vtkPolyData>& value);
+    const std::shared_ptr<MeshIdDataset> &getIdDataset() const;
+    void setIdDataset(const std::shared_ptr<MeshIdDataset> &newIdDataset);
     std::map<unsigned long, bool>* getSelectedPoints() const;
 	vtkSmartPointer<vtkPointPicker> getPointPicker() const;
 	void setPointPicker(const vtkSmartPointer<vtkPointPicker>& value);
@@ -64,6 +70,8 @@ public:
 
     const std::shared_ptr<Drawables::DrawableTriangleMesh> &getMesh() const;
     void setMesh(const std::shared_ptr<Drawables::DrawableTriangleMesh> &newMesh);
+    const std::shared_ptr<MeshSidecarCache> &getMeshCache() const;
+    void setMeshCache(const std::shared_ptr<MeshSidecarCache> &newMeshCache);           //Set before the mesh it belongs to
 
 
     vtkSmartPointer<vtkRenderer> getRenderer() const;
@@ -76,8 +84,9 @@ private:
     constexpr static double RADIUS_RATIO = 1000;
 
     vtkSmartPointer<vtkPropAssembly> assembly;          //Assembly of actors
-    vtkSmartPointer<vtkPropAssembly> sphereAssembly;    //Assembly of spheres
-    vtkSmartPointer<vtkPolyData> points;
+    std::shared_ptr<SelectionMarkers> markers;          //A sphere on each selected vertex
+    SelectionSet selectedVertices;
+    std::shared_ptr<MeshIdDataset> idDataset;
     vtkSmartPointer<vtkPointPicker> pointPicker;        //The point picker
     vtkSmartPointer<vtkRenderer> ren;
     QVTKOpenGLNativeWidget* qvtkwidget;
@@ -86,6 +95,7 @@ private:
     bool leftPressed;
     double sphereRadius;
     std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+    std::shared_ptr<MeshSidecarCache> meshCache;
     std::shared_ptr<Drawables::DrawablePointAnnotation> annotation;
 
 };
@@ -0,0 +1,94 @@
+#ifndef ANNOTATIONJOURNAL_H
+#define ANNOTATIONJOURNAL_H
+
+#include <binaryannotationfilemanager.hpp>
+#include <drawabletrianglemesh.hpp>
+#include <annotation.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The AnnotationJournal class records every change to the annotations of a binary annotation file in an
+ * append-only journal (<file>.journal), so that nothing is lost between two saves and saving only costs the
+ * changes. Each record carries its length and a checksum: a record truncated by a crash is ignored on replay.
+ * A background thread compacts the journal into the main file, keeping the records appended in the meantime. It
+ * never touches the mesh: the chunks of the main file that the journal does not change are copied byte for byte,
+ * and only the others are encoded again from their decoded records.
+ * Records are idempotent (annotations and relationships are replaced by id), so replaying a journal that has
+ * already been compacted is harmless.
+ */
+class AnnotationJournal
+{
+public:
+    constexpr static uint64_t COMPACTION_THRESHOLD = 4 * 1024 * 1024;        //Journal size triggering a compaction
+
+    enum class RecordType : uint8_t
+    {
+        ANNOTATION = 1,                 //Whole annotation, attributes included, replacing the one with the same id
+        ANNOTATION_REMOVAL = 2,
+        RELATIONSHIP = 3
+    };
+
+    AnnotationJournal();
+    ~AnnotationJournal();
+
+    /**
+     * @brief attach starts journaling the changes to a binary annotation file
+     * @param mainFilename the .bant file the journal is compacted into
+     * @param keepExisting false if the main file has just been written in full, and a previous journal is obsolete
+     */
+    bool attach(const std::string &mainFilename, const std::shared_ptr<Drawables::DrawableTriangleMesh> &mesh, bool keepExisting);
+    void detach();
+    bool isAttached() const;
+
+    bool recordAnnotation(const std::shared_ptr<SemantisedTriangleMesh::Annotation> &annotation);
+    bool recordAnnotationRemoval(const std::string &id);
+    bool recordRelationship(const BinaryAnnotationFileManager::RelationshipRecord &relationship);
+
+    /**
+     * @brief replay applies the annotation records of the journal to the mesh
+     * @param relationships the journaled relationships, replacing the ones with the same id
+     */
+    void replay(std::vector<BinaryAnnotationFileManager::RelationshipRecord> &relationships);
+
+    /**
+     * @brief compact merges the journal into the main file on a background thread (nothing happens if a compaction is running)
+     */
+    void compact();
+    bool isCompacting() const;
+
+    const std::string &getMainFilename() const;
+    const std::string &getJournalFilename() const;
+
+private:
+    struct Record
+    {
+        RecordType type;
+        std::string payload;
+    };
+
+    std::string mainFilename;
+    std::string journalFilename;
+    std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+    FILE* journal;
+    uint64_t journalSize;
+    std::thread compaction;
+    std::atomic<bool> compacting;
+    mutable std::mutex journalMutex;
+
+    bool append(RecordType type, const std::string &payload);
+    bool openJournal(bool truncate);
+    void closeJournal();
+    void runCompaction(uint64_t compactedSize);
+
+    static std::vector<Record> readRecords(const std::string &filename, uint64_t to, uint64_t *validSize = nullptr);
+    static uint32_t checksum(const std::string &payload);
+    static void putRelationship(std::vector<BinaryAnnotationFileManager::RelationshipRecord> &relationships, const BinaryAnnotationFileManager::RelationshipRecord &relationship);
+};
+
+#endif // ANNOTATIONJOURNAL_H
@@ -0,0 +1,57 @@
+#ifndef ANNOTATIONLOADER_H
+#define ANNOTATIONLOADER_H
+
+#include <binaryannotationfilemanager.hpp>
+#include <drawabletrianglemesh.hpp>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <QThread>
+
+/**
+ * @brief The AnnotationLoader class reads a binary annotation file on a worker thread and hands the decoded
+ * records to the GUI thread in batches, as soon as they are ready. Batches grow geometrically, so that the
+ * first annotations show up immediately while the number of redraws stays logarithmic in the file size.
+ * The worker never touches the mesh: the receiver of batchLoaded builds the annotations from the records of
+ * takeBatch (see BinaryAnnotationFileManager::buildAnnotations) and adds them to the mesh.
+ */
+class AnnotationLoader : public QThread
+{
+    Q_OBJECT
+public:
+    constexpr static size_t FIRST_BATCH_SIZE = 64;
+
+    explicit AnnotationLoader(QObject *parent = nullptr);
+    ~AnnotationLoader() override;
+
+    void load(const std::string &filename, const std::shared_ptr<Drawables::DrawableTriangleMesh> &mesh);
+
+    bool getCanceled() const;
+    std::vector<BinaryAnnotationFileManager::AnnotationRecord> takeBatch();
+    std::vector<BinaryAnnotationFileManager::RelationshipRecord> takeRelationships();  //Available once the thread finished
+
+    const std::string &getFilename() const;
+    std::shared_ptr<Drawables::DrawableTriangleMesh> getMesh() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void batchLoaded();
+    void progressChanged(int);
+    void loadingFailed(QString);
+
+protected:
+    void run() override;
+
+private:
+    std::string filename;
+    std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+    std::vector<BinaryAnnotationFileManager::AnnotationRecord> batch;
+    std::vector<BinaryAnnotationFileManager::RelationshipRecord> relationships;
+    mutable std::mutex batchMutex;
+};
+
+#endif // ANNOTATIONLOADER_H
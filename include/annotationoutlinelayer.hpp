@@ -0,0 +1,78 @@
+#ifndef ANNOTATIONOUTLINELAYER_H
+#define ANNOTATIONOUTLINELAYER_H
+
+#include <drawableannotation.hpp>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <vtkActor.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+
+/**
+ * @brief The AnnotationOutlineLayer class draws the outlines of the surface annotations and the polylines of the
+ * line annotations of a mesh with a single actor, in place of the canvas of each annotation. All of them are packed
+ * in one polydata, one polyline cell per outline, with the id and the colour of their annotation as cell arrays; the
+ * cells of an annotation are contiguous. Hiding, showing or selecting an annotation only writes the visibility mask
+ * (ghost array, hidden cells are not drawn) and the colours of its own cells: the polydata is packed again only
+ * when annotations are added, removed or changed.
+ */
+class AnnotationOutlineLayer
+{
+public:
+    constexpr static const char* IDS_ARRAY_NAME = "AnnotationIds";
+    constexpr static const char* COLORS_ARRAY_NAME = "Colors";
+
+    AnnotationOutlineLayer();
+
+    /**
+     * @brief isLayered tells whether the annotation is drawn by the layer instead of by its own canvas
+     */
+    static bool isLayered(const std::shared_ptr<SemantisedTriangleMesh::Annotation> &annotation);
+
+    void add(const std::shared_ptr<Drawables::DrawableAnnotation> &annotation);
+    void remove(SemantisedTriangleMesh::Annotation* annotation);
+    void markGeometryDirty(SemantisedTriangleMesh::Annotation* annotation);
+    /**
+     * @brief updateView writes the visibility and the colour of the cells of the annotation
+     */
+    void updateView(SemantisedTriangleMesh::Annotation* annotation);
+    void clear();
+
+    /**
+     * @brief update packs the polydata again if its geometry changed, or flags the written arrays as modified
+     */
+    void update();
+
+    vtkSmartPointer<vtkActor> getActor() const;
+    size_t getAnnotationsNumber() const;
+
+    const unsigned char* getSelectionColor() const;
+    void setSelectionColor(const unsigned char newSelectionColor[3]);
+
+private:
+    struct Range
+    {
+        std::shared_ptr<Drawables::DrawableAnnotation> annotation;
+        vtkIdType begin;
+        vtkIdType end;
+    };
+
+    vtkSmartPointer<vtkPolyData> outlines;
+    vtkSmartPointer<vtkUnsignedCharArray> colors;
+    vtkSmartPointer<vtkUnsignedCharArray> mask;
+    vtkSmartPointer<vtkActor> actor;
+    std::vector<SemantisedTriangleMesh::Annotation*> order;                 //Packing order of the annotations
+    std::map<SemantisedTriangleMesh::Annotation*, Range> ranges;
+    unsigned char selectionColor[3];
+    bool geometryDirty;
+    bool viewDirty;
+
+    void pack();
+    void writeView(const Range &range);
+};
+
+#endif // ANNOTATIONOUTLINELAYER_H
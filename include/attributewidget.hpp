@@ -3,6 +3,7 @@
 
 #include <QPushButton>
 #include <QTextEdit>
+#include <QTimer>
 #include <QTreeWidget>
 #include <annotation.hpp>
 
@@ -15,6 +16,8 @@ class AttributeWidget : public QTreeWidget
     Q_OBJECT
 
 public:
+    constexpr static int TEXT_SETTLE_TIME = 500;                //Milliseconds without typing before a text change is reported
+
     explicit AttributeWidget(QWidget* parent);
     ~AttributeWidget();
 
@@ -26,10 +29,13 @@ public:
 signals:
     void updateSignal();
     void updateViewSignal();
+    void attributesChanged();
+    void attributeViewChanged(unsigned int attributeId);
 private slots:
     void measureButtonClickedSlot();
     void deletionButtonClickedSlot();
     void textEdited();
+    void textSettled();
 
 private:
     std::map<QPushButton*, std::shared_ptr<SemantisedTriangleMesh::Attribute> >  buttonMeasureMap;
@@ -37,6 +43,7 @@ private:
     Ui::AttributeWidget *ui;
     std::shared_ptr<SemantisedTriangleMesh::Annotation> annotation;
     QTreeWidgetItem* m_pItem;
+    QTimer textSettleTimer;                 //Reports typed text once, not on every keystroke
 };
 
 #endif // ATTRIBUTEWIDGET_H
@@ -0,0 +1,197 @@
+#ifndef BINARYANNOTATIONFILEMANAGER_H
+#define BINARYANNOTATIONFILEMANAGER_H
+
+#include <binarystream.hpp>
+#include <mappedfile.hpp>
+#include <drawabletrianglemesh.hpp>
+#include <annotation.hpp>
+#include <semanticattribute.hpp>
+#include <geometricattribute.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The BinaryAnnotationFileManager class reads and writes the annotations of a mesh in the binary .bant format.
+ * A .bant file is a fixed header (magic and version) followed by typed sections (type, byte length, content).
+ * Readers skip the sections they do not know, so new sections can be added without breaking older files.
+ * Surface annotations store their outlines, so that loading them does not need to recompute the boundaries; their
+ * triangles, as delta coded runs of consecutive ids, are stored only when they have no outlines. Annotations are written in chunks: each chunk is an
+ * annotations section followed by the attribute sections of its annotations, so that a chunk can be decoded and
+ * handed over as soon as it has been read (see readNextChunk).
+ * Decoding is split in two steps: the content is read into plain records (ids, colours, attributes), which needs
+ * no mesh and can run on any thread, and the records are turned into annotations of the mesh by buildAnnotations,
+ * on the thread owning the mesh.
+ */
+class BinaryAnnotationFileManager
+{
+public:
+    constexpr static const char* EXTENSION = "bant";
+    constexpr static uint32_t VERSION = 1;
+    constexpr static size_t CHUNK_SIZE = 256;
+
+    enum class SectionType : uint32_t
+    {
+        ANNOTATIONS = 1,
+        SEMANTIC_ATTRIBUTES = 2,
+        GEOMETRIC_ATTRIBUTES = 3,
+        RELATIONSHIPS = 4
+    };
+
+    /**
+     * @brief The RelationshipRecord struct is a relationship as stored in the files: the subjects are annotation ids,
+     * resolved to the annotations only when the relationship is added to the mesh
+     */
+    struct RelationshipRecord
+    {
+        unsigned int id;
+        std::string type;
+        double weight;
+        double minValue;
+        double maxValue;
+        bool directed;
+        std::vector<uint32_t> subjects;
+    };
+
+    //Codes written in the files, independent from the values of the library enums
+    enum class AnnotationKind : uint8_t
+    {
+        POINT = 0,
+        LINE = 1,
+        SURFACE = 2
+    };
+
+    enum class GeometricKind : uint8_t
+    {
+        EUCLIDEAN = 0,
+        GEODESIC = 1,
+        BOUNDING = 2
+    };
+
+    /**
+     * @brief The AttributeRecord struct is an attribute as stored in the files: a key-value pair for the semantic
+     * attributes, the measured vertices (and for bounding measures the plane) for the geometric ones
+     */
+    struct AttributeRecord
+    {
+        unsigned int id;
+        bool geometric;
+        std::string key;
+        std::string value;
+        GeometricKind kind;
+        bool drawValue;
+        std::vector<uint32_t> points;
+        double origin[3];
+        double direction[3];
+    };
+
+    /**
+     * @brief The AnnotationRecord struct is an annotation as stored in the files, with vertex and triangle ids in
+     * place of the elements of the mesh
+     */
+    struct AnnotationRecord
+    {
+        uint32_t id;
+        std::string tag;
+        unsigned char color[3];
+        AnnotationKind kind;
+        std::vector<std::vector<uint32_t> > polylines;      //The points, the polylines or the outlines
+        std::vector<uint32_t> triangles;                    //Surface annotations stored without outlines
+        std::vector<AttributeRecord> attributes;
+    };
+
+    BinaryAnnotationFileManager();
+
+    bool writeAnnotations(const std::string &filename);
+    bool writeAnnotations(const std::string &filename, const std::vector<std::shared_ptr<SemantisedTriangleMesh::Annotation> > &annotations);
+    /**
+     * @brief writeSections writes a file made of the header, already encoded annotation sections and the relationships
+     */
+    bool writeSections(const std::string &filename, const std::string &sections);
+    std::vector<std::shared_ptr<SemantisedTriangleMesh::Annotation> > readAnnotations(const std::string &filename);
+
+    /**
+     * @brief open prepares a file for being read one chunk at a time
+     * @return false if the file cannot be opened or is not a binary annotation file
+     */
+    bool open(const std::string &filename);
+    /**
+     * @brief readNextChunk decodes the next chunk of the opened file, attributes included
+     * @return the annotations of the chunk, empty when the file is over or malformed (see getError)
+     */
+    std::vector<std::shared_ptr<SemantisedTriangleMesh::Annotation> > readNextChunk();
+    /**
+     * @brief readNextRecords decodes the next chunk of the opened file into records, without touching the mesh
+     * @param sections if given, receives the annotation and attribute sections of the chunk as they are in the file
+     * @return the records of the chunk, empty when the file is over or malformed (see getError)
+     */
+    std::vector<AnnotationRecord> readNextRecords(std::string *sections = nullptr);
+    bool hasNextChunk() const;
+    int getProgress() const;                                //Percentage of the opened file read so far
+    void close();
+
+    /**
+     * @brief encodeAnnotations appends the sections describing the annotations (and their attributes) to a writer
+     */
+    void encodeAnnotations(const std::vector<std::shared_ptr<SemantisedTriangleMesh::Annotation> > &annotations, BinaryWriter &writer) const;
+    /**
+     * @brief encodeRecords appends the sections describing records to a writer
+     * @param firstIndex position in the file of the first record, which the attribute sections refer to
+     */
+    void encodeRecords(const std::vector<AnnotationRecord> &records, size_t firstIndex, BinaryWriter &writer) const;
+    /**
+     * @brief decodeAnnotations reads the annotation sections from the current position of a reader to its end.
+     * @return the decoded annotations, empty if the content is malformed
+     */
+    std::vector<std::shared_ptr<SemantisedTriangleMesh::Annotation> > decodeAnnotations(BinaryReader &reader);
+    /**
+     * @brief decodeRecords reads the annotation sections from the current position of a reader to its end into records
+     * @return false if the content is malformed
+     */
+    bool decodeRecords(BinaryReader &reader, std::vector<AnnotationRecord> &records);
+    /**
+     * @brief buildAnnotations turns records into annotations of the mesh, ready to be drawn
+     * @return the annotations, empty if a record refers to elements that are not in the mesh (see getError)
+     */
+    std::vector<std::shared_ptr<SemantisedTriangleMesh::Annotation> > buildAnnotations(const std::vector<AnnotationRecord> &records) const;
+
+    static void encodeRelationship(const RelationshipRecord &relationship, BinaryWriter &writer);
+    static RelationshipRecord decodeRelationship(BinaryReader &reader);
+
+    static bool isBinaryAnnotationFile(const std::string &filename);
+
+    /**
+     * @brief getRelationships returns the relationships read so far, setRelationships sets the ones to be written
+     */
+    const std::vector<RelationshipRecord> &getRelationships() const;
+    void setRelationships(const std::vector<RelationshipRecord> &newRelationships);
+
+    std::shared_ptr<Drawables::DrawableTriangleMesh> getMesh() const;
+    void setMesh(const std::shared_ptr<Drawables::DrawableTriangleMesh> &newMesh);
+
+    const std::string &getError() const;
+
+private:
+    std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+    std::shared_ptr<MappedFile> file;
+    std::shared_ptr<BinaryReader> fileReader;
+    size_t decodedAnnotations;
+    std::vector<RelationshipRecord> relationships;
+    mutable std::string error;
+
+    bool decodeChunk(BinaryReader &reader, size_t firstIndex, std::vector<AnnotationRecord> &chunk, std::string *sections = nullptr);
+    void encodeAnnotation(const std::shared_ptr<SemantisedTriangleMesh::Annotation> &annotation, BinaryWriter &writer) const;
+    void encodeRecord(const AnnotationRecord &record, BinaryWriter &writer) const;
+    bool decodeAnnotation(BinaryReader &reader, AnnotationRecord &record) const;
+    void encodeSemanticAttributes(const std::vector<std::shared_ptr<SemantisedTriangleMesh::Annotation> > &annotations, size_t begin, size_t end, BinaryWriter &writer) const;
+    bool decodeSemanticAttributes(BinaryReader &reader, std::vector<AnnotationRecord> &chunk, size_t firstIndex) const;
+    void encodeGeometricAttributes(const std::vector<std::shared_ptr<SemantisedTriangleMesh::Annotation> > &annotations, size_t begin, size_t end, BinaryWriter &writer) const;
+    bool decodeGeometricAttributes(BinaryReader &reader, std::vector<AnnotationRecord> &chunk, size_t firstIndex) const;
+    std::shared_ptr<SemantisedTriangleMesh::Annotation> buildAnnotation(const AnnotationRecord &record) const;
+    std::shared_ptr<SemantisedTriangleMesh::Attribute> buildAttribute(const AttributeRecord &record) const;
+
+    std::vector<std::shared_ptr<SemantisedTriangleMesh::Vertex> > toVertices(const std::vector<uint32_t> &ids) const;
+};
+
+#endif // BINARYANNOTATIONFILEMANAGER_H
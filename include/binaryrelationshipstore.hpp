@@ -0,0 +1,99 @@
+#ifndef BINARYRELATIONSHIPSTORE_H
+#define BINARYRELATIONSHIPSTORE_H
+
+#include <binaryannotationfilemanager.hpp>
+#include <binarystream.hpp>
+#include <drawabletrianglemesh.hpp>
+#include <relationship.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The BinaryRelationshipStore class holds the relationships between the annotations of a mesh in columns:
+ * ids, subjects (annotation ids, with an offsets column for relationships among more than two annotations), type
+ * indices in an interned table of type names, weights, minimum and maximum values and directions.
+ * Relationships are resolved lazily: the Relationship object, with its annotations, is built and added to the mesh
+ * the first time it is asked for (see getRelationship), so that opening a large file costs only its decoding.
+ * The columns are written in the binary .brel format, made of typed sections like the .bant one.
+ */
+class BinaryRelationshipStore
+{
+public:
+    constexpr static const char* EXTENSION = "brel";
+    constexpr static uint32_t VERSION = 1;
+
+    enum class SectionType : uint32_t
+    {
+        TYPES = 1,
+        COLUMNS = 2
+    };
+
+    BinaryRelationshipStore();
+
+    /**
+     * @brief addRelationship appends a relationship, unresolved
+     * @return its index in the store
+     */
+    size_t addRelationship(const BinaryAnnotationFileManager::RelationshipRecord &record);
+    /**
+     * @brief importRelationships adds the relationships the mesh already knows (e.g. read from a text file) and the
+     * store does not, as resolved. An id already taken in the store is replaced by a new one
+     * @return the indices of the added relationships
+     */
+    std::vector<size_t> importRelationships(const std::vector<std::shared_ptr<SemantisedTriangleMesh::Relationship> > &relationships);
+    BinaryAnnotationFileManager::RelationshipRecord getRecord(size_t index) const;
+    std::vector<BinaryAnnotationFileManager::RelationshipRecord> getRecords() const;
+
+    /**
+     * @brief getRelationship returns a relationship, resolving its annotations and adding it to the mesh on first access
+     */
+    std::shared_ptr<SemantisedTriangleMesh::Relationship> getRelationship(size_t index);
+    void resolveAll();
+    bool isResolved(size_t index) const;
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+
+    uint32_t getId(size_t index) const;
+    uint32_t getNextId() const;                                 //One past the greatest id in the store
+    const std::string &getType(size_t index) const;
+    std::vector<uint32_t> getSubjects(size_t index) const;
+    const std::vector<std::string> &getTypes() const;
+
+    /**
+     * @brief read appends the relationships of a .brel file to the store
+     */
+    bool read(const std::string &filename);
+    bool write(const std::string &filename) const;
+
+    static bool isBinaryRelationshipFile(const std::string &filename);
+
+    std::shared_ptr<Drawables::DrawableTriangleMesh> getMesh() const;
+    void setMesh(const std::shared_ptr<Drawables::DrawableTriangleMesh> &newMesh);
+
+    const std::string &getError() const;
+
+private:
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> subjectOffsets;           //size() + 1 offsets in subjects
+    std::vector<uint32_t> subjects;
+    std::vector<uint32_t> types;
+    std::vector<double> weights;
+    std::vector<double> minValues;
+    std::vector<double> maxValues;
+    std::vector<uint8_t> directed;
+    std::vector<std::string> typeTable;
+    std::map<std::string, uint32_t> typeIndices;
+    std::vector<std::shared_ptr<SemantisedTriangleMesh::Relationship> > resolved;
+    std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+    mutable std::string error;
+
+    uint32_t internType(const std::string &type);
+    bool decodeColumns(BinaryReader &reader, const std::vector<uint32_t> &typesMap);
+};
+
+#endif // BINARYRELATIONSHIPSTORE_H
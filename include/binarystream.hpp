@@ -0,0 +1,83 @@
+#ifndef BINARYSTREAM_H
+#define BINARYSTREAM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The BinaryWriter class serialises little endian values and LEB128 varints into a growing buffer
+ */
+class BinaryWriter
+{
+public:
+    BinaryWriter();
+
+    void writeUInt8(uint8_t value);
+    void writeUInt32(uint32_t value);
+    void writeUInt64(uint64_t value);
+    void writeDouble(double value);
+    void writeVarUInt(uint64_t value);
+    void writeVarInt(int64_t value);            //Zigzag encoded
+    void writeString(const std::string &value);
+    void writeBytes(const char *data, size_t size);
+
+    /**
+     * @brief writeSortedIds writes a set of ids as runs of consecutive values, each one delta coded from the previous run
+     * @param ids the ids, sorted in increasing order and without repetitions
+     */
+    void writeSortedIds(const std::vector<uint32_t> &ids);
+    /**
+     * @brief writeIdSequence writes an ordered sequence of ids, each one delta coded from the previous
+     */
+    void writeIdSequence(const std::vector<uint32_t> &ids);
+
+    size_t beginSection(uint32_t type);
+    void endSection(size_t section);
+
+    const std::string &getBuffer() const;
+    void clear();
+
+private:
+    std::string buffer;
+};
+
+/**
+ * @brief The BinaryReader class reads what a BinaryWriter wrote from a memory region.
+ * Reading past the end of the region sets the failed flag instead of throwing: every following read returns zero.
+ */
+class BinaryReader
+{
+public:
+    BinaryReader(const char *data, size_t size);
+
+    uint8_t readUInt8();
+    uint32_t readUInt32();
+    uint64_t readUInt64();
+    double readDouble();
+    uint64_t readVarUInt();
+    int64_t readVarInt();
+    std::string readString();
+    const char *readBytes(size_t size);
+    std::vector<uint32_t> readSortedIds();
+    std::vector<uint32_t> readIdSequence();
+
+    bool readSection(uint32_t &type, BinaryReader &content);
+    bool peekSectionType(uint32_t &type) const;
+
+    bool getFailed() const;
+    bool atEnd() const;
+    size_t getPosition() const;
+    size_t getSize() const;
+    const char *getData() const;
+
+private:
+    const char *data;
+    size_t size;
+    size_t position;
+    bool failed;
+
+    bool available(size_t bytes);
+};
+
+#endif // BINARYSTREAM_H
@@ -0,0 +1,87 @@
+#ifndef CELLPALETTE_H
+#define CELLPALETTE_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <chunkedsurface.hpp>
+
+#include <vtkActor.h>
+#include <vtkLookupTable.h>
+#include <vtkScalarsToColors.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTypeUInt16Array.h>
+
+/**
+ * @brief The CellPalette class colours the triangles of a surface through a per cell array of palette indices,
+ * mapped by a lookup table. When an actor is set, the colours of its cells are interned in the palette and every
+ * cell gets the index of its own colour; the mapper is then switched to the index array. Highlighting a cell or
+ * restoring its colour only writes its index, so it costs nothing proportional to the size of the mesh: the array is
+ * flagged as modified once per frame, on update(), if any index was written.
+ * VTK uploads a modified array as a whole. Only when the surface is drawn in chunks does the upload shrink: the
+ * chunks holding the written cells are told, and copy their indices again on update().
+ */
+class CellPalette
+{
+public:
+    constexpr static const char* ARRAY_NAME = "PaletteIndices";
+    constexpr static size_t MAX_COLORS = 65536;
+
+    CellPalette();
+
+    /**
+     * @brief setActor captures the colours of the cells of the actor and makes its mapper use the palette.
+     * Highlighted cells keep their colour: the actor can be set again after it has been rebuilt.
+     */
+    void setActor(const vtkSmartPointer<vtkActor> &newActor);
+    vtkSmartPointer<vtkActor> getActor() const;
+    /**
+     * @brief clear detaches the palette from the actor, whose mapper gets back its own colouring, and forgets the
+     * highlighted cells
+     */
+    void clear();
+
+    void highlight(vtkIdType cell, const unsigned char color[3]);
+    void restore(vtkIdType cell);
+    /**
+     * @brief restoreAll gives back their own colour to the highlighted cells, visiting only them
+     */
+    void restoreAll();
+    bool isHighlighted(vtkIdType cell) const;
+
+    /**
+     * @brief update flags the indices written since the previous call as modified, if any
+     */
+    void update();
+
+    size_t getColorsNumber() const;
+
+    std::shared_ptr<ChunkedSurface> getChunks() const;
+    void setChunks(const std::shared_ptr<ChunkedSurface> &newChunks);
+
+private:
+    vtkSmartPointer<vtkActor> actor;
+    vtkSmartPointer<vtkPolyData> surface;
+    vtkSmartPointer<vtkTypeUInt16Array> indices;
+    vtkSmartPointer<vtkLookupTable> lookupTable;
+    std::shared_ptr<ChunkedSurface> chunks;
+    //Colouring of the mapper before the palette
+    int scalarMode;
+    int colorMode;
+    bool useLookupTableScalarRange;
+    vtkSmartPointer<vtkScalarsToColors> mapperLookupTable;
+    std::vector<uint16_t> baseIndices;                          //Index of the own colour of each cell
+    std::vector<uint32_t> colors;                               //Packed RGB colour of each index
+    std::unordered_map<uint32_t, uint16_t> colorIndices;
+    std::unordered_map<vtkIdType, uint16_t> highlighted;
+    bool indicesChanged;
+    bool lookupTableChanged;
+
+    uint16_t internColor(uint32_t color);
+    void setIndex(vtkIdType cell, uint16_t index);
+    void updateLookupTable();
+};
+
+#endif // CELLPALETTE_H
@@ -0,0 +1,94 @@
+#ifndef CHUNKEDSURFACE_H
+#define CHUNKEDSURFACE_H
+
+#include <vector>
+
+#include <vtkActor.h>
+#include <vtkCellPicker.h>
+#include <vtkDataSet.h>
+#include <vtkPolyData.h>
+#include <vtkPropAssembly.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+
+/**
+ * @brief The ChunkedSurface class draws the surface of a large mesh as a set of spatial chunks, in place of its
+ * single actor. Triangles are bucketed on a grid by their centroid; every chunk has its own polydata, holding only
+ * the points its triangles use, its own actor and its own bounds. Before each render the chunks outside the view
+ * frustum of the camera are hidden, so that only the visible part of the mesh reaches the GPU.
+ * Chunks copy the cell data and the colouring of the mapper of the surface: when the colours of some triangles
+ * change, only the chunks containing them are copied again (see markCellModified and update).
+ * Each chunk stores in the GLOBAL_IDS_ARRAY_NAME cell array the id of its triangles in the surface, so that picks on
+ * a chunk can be mapped back to the triangles of the mesh (see toGlobalCellId).
+ */
+class ChunkedSurface
+{
+public:
+    constexpr static vtkIdType MIN_TRIANGLES = 500000;           //Smaller surfaces are drawn by their own actor
+    constexpr static vtkIdType TRIANGLES_PER_CHUNK = 65536;
+    constexpr static const char* GLOBAL_IDS_ARRAY_NAME = "GlobalCellIds";
+
+    ChunkedSurface();
+    ~ChunkedSurface();
+
+    static bool needsChunks(const vtkSmartPointer<vtkActor> &surfaceActor);
+    /**
+     * @brief toGlobalCellId maps a cell of a picked dataset to the triangle of the surface it comes from. Cells of
+     * datasets which are not chunks are returned as they are.
+     */
+    static vtkIdType toGlobalCellId(vtkDataSet* dataset, vtkIdType cell);
+
+    /**
+     * @brief build splits the surface drawn by the actor in chunks. The actor itself is left untouched: it is up to
+     * the caller to hide it and to add the canvas of the chunks in its place
+     */
+    void build(const vtkSmartPointer<vtkActor> &newSurfaceActor);
+    void clear();
+    bool isBuilt() const;
+
+    void markCellModified(vtkIdType cell);
+    void markAllModified();
+    /**
+     * @brief update copies again the cell data of the chunks having modified cells
+     */
+    void update();
+
+    /**
+     * @brief cull hides the chunks outside the view frustum of the active camera of the renderer
+     */
+    void cull(vtkRenderer* currentRenderer);
+
+    void addToPickList(const vtkSmartPointer<vtkCellPicker> &picker) const;
+
+    vtkSmartPointer<vtkActor> getSurfaceActor() const;
+    vtkSmartPointer<vtkPropAssembly> getCanvas() const;
+    size_t getChunksNumber() const;
+    size_t getVisibleChunksNumber() const;
+
+    vtkSmartPointer<vtkRenderer> getRenderer() const;
+    void setRenderer(const vtkSmartPointer<vtkRenderer> &newRenderer);      //The chunks are culled before each render of it
+
+private:
+    struct Chunk
+    {
+        vtkSmartPointer<vtkPolyData> polydata;
+        vtkSmartPointer<vtkActor> actor;
+        std::vector<vtkIdType> cells;                        //Ids in the surface of the triangles of the chunk
+        double bounds[6];
+        bool modified;
+    };
+
+    vtkSmartPointer<vtkActor> surfaceActor;
+    vtkSmartPointer<vtkPolyData> surface;
+    vtkSmartPointer<vtkPropAssembly> canvas;
+    vtkSmartPointer<vtkRenderer> renderer;
+    unsigned long renderObserver;
+    std::vector<Chunk> chunks;
+    std::vector<unsigned int> cellChunks;                    //Chunk of each triangle of the surface
+    bool anyModified;
+
+    void copyCellData(Chunk &chunk);
+    void copyColoring(Chunk &chunk);
+};
+
+#endif // CHUNKEDSURFACE_H
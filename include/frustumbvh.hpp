@@ -0,0 +1,76 @@
+#ifndef FRUSTUMBVH_H
+#define FRUSTUMBVH_H
+
+#include <cstdint>
+#include <vector>
+
+#include <vtkPlanes.h>
+#include <vtkPoints.h>
+#include <vtkType.h>
+
+/**
+ * @brief The FrustumBVH class is a bounding volume hierarchy over the points of a surface, built once and queried
+ * with the frustum of a rubber band selection. Each node bounds a contiguous range of the (reordered) points, so
+ * that the subtrees entirely inside the frustum are reported without visiting their points and those entirely
+ * outside are skipped. Only the points of the leaves crossing the frustum are tested, one by one.
+ * The subtrees below the first levels are queried in parallel.
+ * Points are stored in single precision as offsets from the minimum corner of their bounds, and the planes are
+ * moved into the same frame, so that georeferenced coordinates keep the precision of the extent of the surface.
+ */
+class FrustumBVH
+{
+public:
+    constexpr static unsigned int LEAF_SIZE = 32;
+    constexpr static vtkIdType MIN_PARALLEL_POINTS = 100000;        //Smaller trees are queried by the calling thread
+
+    FrustumBVH();
+
+    void build(vtkPoints* points);
+    void clear();
+    bool isBuilt() const;
+    vtkIdType getPointsNumber() const;
+
+    /**
+     * @brief query returns the ids of the points inside the frustum (where none of its planes is positive), in no
+     * particular order. The planes are those of vtkPlanes: their normals point outwards.
+     */
+    std::vector<vtkIdType> query(vtkPlanes* frustum) const;
+
+    unsigned int getThreadsNumber() const;
+    void setThreadsNumber(unsigned int newThreadsNumber);           //0 means one per core
+
+private:
+    struct Node
+    {
+        double min[3];
+        double max[3];
+        uint32_t first;                 //Range of the points of the subtree
+        uint32_t count;
+        uint32_t right;                 //Index of the right child, the left one follows the node; 0 for leaves
+    };
+
+    struct Plane
+    {
+        double normal[3];
+        double offset;
+    };
+
+    enum class Side
+    {
+        OUTSIDE,
+        CROSSING,
+        INSIDE
+    };
+
+    std::vector<Node> nodes;
+    double origin[3];                               //Minimum corner of the points, the frame of nodes and coordinates
+    std::vector<float> coordinates;                 //Reordered as the leaves, 3 per point
+    std::vector<vtkIdType> ids;                     //Original id of each reordered point
+    unsigned int threadsNumber;
+
+    uint32_t buildNode(std::vector<vtkIdType> &order, const std::vector<float> &source, uint32_t first, uint32_t count);
+    Side classify(const Node &node, const std::vector<Plane> &planes) const;
+    void collect(uint32_t index, const std::vector<Plane> &planes, std::vector<vtkIdType> &selected) const;
+};
+
+#endif // FRUSTUMBVH_H
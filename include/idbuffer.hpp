@@ -0,0 +1,78 @@
+#ifndef IDBUFFER_H
+#define IDBUFFER_H
+
+#include <cstdint>
+#include <vector>
+
+#include <vtkPolyData.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+/**
+ * @brief The IdBuffer class tells which triangles of a surface are visible from a camera, rasterising their ids
+ * on the CPU in a buffer as large as the viewport (nearest triangle of each pixel, sampled at the pixel centres).
+ * The rows of the buffer are split in bands, each rasterised by its own thread. Nothing is drawn with OpenGL, so it
+ * works in headless sessions and without a GPU: render() only needs the world to normalised device coordinates
+ * matrix, update() takes it from the active camera of a renderer and renders again only when the camera, the size
+ * of the viewport or the geometry changed.
+ * A triangle is visible if it is drawn in a pixel, or if it covers no pixel centre (it is smaller than a pixel) but
+ * the pixels around one of its vertices show a triangle sharing a vertex with it.
+ * Triangles crossing the near plane are not rasterised.
+ */
+class IdBuffer
+{
+public:
+    constexpr static uint32_t NO_ID = 0xFFFFFFFF;
+
+    IdBuffer();
+
+    /**
+     * @brief render rasterises the triangles of the surface (its polys, the id of each being its index)
+     * @param matrix row-major world to normalised device coordinates matrix, as the composite projection
+     * transform of vtkCamera
+     */
+    void render(vtkPolyData* surface, const double matrix[16], int width, int height);
+    /**
+     * @brief update renders the surface as seen by the active camera of the renderer, if it is out of date
+     * @return true if the buffer has been rendered again
+     */
+    bool update(vtkPolyData* surface, vtkRenderer* renderer);
+    void clear();
+
+    int getWidth() const;
+    int getHeight() const;
+    /**
+     * @brief getId returns the id of the triangle drawn in the pixel (relative to the viewport), NO_ID if none
+     */
+    uint32_t getId(int x, int y) const;
+    bool isTriangleVisible(vtkIdType triangleId) const;
+    /**
+     * @brief isPointVisible tells whether a triangle incident to the point is drawn around its projection
+     */
+    bool isPointVisible(vtkIdType pointId) const;
+
+    unsigned int getThreadsNumber() const;
+    void setThreadsNumber(unsigned int newThreadsNumber);           //0 means one per core
+
+private:
+    vtkSmartPointer<vtkPolyData> surface;
+    std::vector<uint32_t> triangles;                //3 point ids per triangle, read once per geometry
+    std::vector<uint32_t> ids;
+    std::vector<float> depths;
+    std::vector<char> visibleTriangles;
+    double matrix[16];
+    int width;
+    int height;
+    unsigned int threadsNumber;
+    vtkMTimeType geometryTime;
+    vtkMTimeType cameraTime;
+
+    vtkMTimeType getGeometryTime(vtkPolyData* polydata) const;
+    void readTriangles();
+    bool project(const double p[3], float projected[3]) const;
+    bool isNeighbourDrawn(size_t triangle, const float projected[2]) const;
+    void rasterise(const std::vector<float> &projected, const std::vector<char> &valid, int firstRow, int lastRow);
+};
+
+#endif // IDBUFFER_H
@@ -0,0 +1,56 @@
+#ifndef LODPROXY_H
+#define LODPROXY_H
+
+#include <drawabletrianglemesh.hpp>
+#include <chunkedsurface.hpp>
+
+#include <memory>
+#include <vector>
+
+#include <vtkActor.h>
+#include <vtkPointLocator.h>
+#include <vtkPolyData.h>
+#include <vtkPropAssembly.h>
+#include <vtkSmartPointer.h>
+
+/**
+ * @brief The LODProxy class draws a decimated copy of a mesh (built by LODProxyBuilder) in place of its surface
+ * while the camera moves. The proxy is coloured as the surface it replaces: each of its triangles takes the colour
+ * of the triangle of the mesh it comes from (through the CellPalette of the surface when it has one, so that the
+ * highlighted triangles keep their colour), with the visible surface annotations painted over it. The colours are
+ * computed again only when the scene or the palette indices changed since the last time the proxy has been shown.
+ */
+class LODProxy
+{
+public:
+    LODProxy();
+
+    void show(const vtkSmartPointer<vtkPropAssembly> &assembly, unsigned long sceneVersion);
+    void hide();
+
+    bool isReady() const;
+    bool isShown() const;
+
+    std::shared_ptr<Drawables::DrawableTriangleMesh> getMesh() const;
+    void setMesh(const std::shared_ptr<Drawables::DrawableTriangleMesh> &newMesh);       //Drops the proxy of the previous mesh
+    vtkSmartPointer<vtkPolyData> getProxy() const;
+    void setProxy(const vtkSmartPointer<vtkPolyData> &newProxy);
+    std::shared_ptr<ChunkedSurface> getChunkedSurface() const;
+    void setChunkedSurface(const std::shared_ptr<ChunkedSurface> &newChunkedSurface);     //Hidden with the surface when it draws it
+
+private:
+    std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+    vtkSmartPointer<vtkPolyData> proxy;
+    vtkSmartPointer<vtkActor> actor;
+    std::shared_ptr<ChunkedSurface> chunkedSurface;
+    vtkSmartPointer<vtkPointLocator> centroidsLocator;          //Over the centroids of the triangles of the proxy
+    vtkSmartPointer<vtkPropAssembly> shownIn;
+    std::vector<vtkSmartPointer<vtkProp> > hiddenProps;
+    unsigned long coloredVersion;
+    vtkMTimeType coloredPaletteTime;
+    bool colored;
+
+    void updateColors(const vtkSmartPointer<vtkPolyData> &surface);
+};
+
+#endif // LODPROXY_H
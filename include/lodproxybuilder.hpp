@@ -0,0 +1,52 @@
+#ifndef LODPROXYBUILDER_H
+#define LODPROXYBUILDER_H
+
+#include <mutex>
+
+#include <QThread>
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/**
+ * @brief The LODProxyBuilder class decimates the surface of a mesh on a worker thread, producing the proxy drawn
+ * while the camera moves (see LODProxy). The surface is clustered on a grid (vtkQuadricClustering) whose cells are
+ * sized so that the proxy has about TARGET_TRIANGLES triangles. Each triangle of the proxy keeps, in the
+ * CELL_IDS_ARRAY_NAME cell array, the id of the triangle of the mesh it comes from.
+ */
+class LODProxyBuilder : public QThread
+{
+    Q_OBJECT
+public:
+    constexpr static vtkIdType MIN_TRIANGLES = 1000000;          //Smaller meshes are always drawn at full resolution
+    constexpr static vtkIdType TARGET_TRIANGLES = 250000;
+    constexpr static int MAX_DIVISIONS = 2048;
+    constexpr static const char* CELL_IDS_ARRAY_NAME = "OriginalCellIds";
+
+    explicit LODProxyBuilder(QObject *parent = nullptr);
+    ~LODProxyBuilder() override;
+
+    static bool needsProxy(const vtkSmartPointer<vtkPolyData> &surface);
+
+    /**
+     * @brief build starts the decimation of the surface. The connectivity is copied, the points are shared and
+     * only read by the worker
+     */
+    void build(const vtkSmartPointer<vtkPolyData> &surface);
+
+    bool getCanceled() const;
+    vtkSmartPointer<vtkPolyData> takeResult();
+
+public slots:
+    void cancel();
+
+protected:
+    void run() override;
+
+private:
+    vtkSmartPointer<vtkPolyData> input;
+    vtkSmartPointer<vtkPolyData> result;
+    mutable std::mutex resultMutex;
+};
+
+#endif // LODPROXYBUILDER_H
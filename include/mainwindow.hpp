@@ -12,10 +12,24 @@
 #include <drawabletrianglemesh.hpp>
 #include <lineselectionstyle.hpp>
 #include <measurestyle.hpp>
+#include <meshloader.hpp>
+#include <annotationloader.hpp>
+#include <annotationjournal.hpp>
+#include <tilemanager.hpp>
+#include <scenecache.hpp>
+#include <viewerscene.hpp>
+#include <renderscheduler.hpp>
+#include <lodproxy.hpp>
+#include <lodproxybuilder.hpp>
+#include <meshindex.hpp>
 #include <relationship.hpp>
+#include <binaryrelationshipstore.hpp>
 #include <triangleselectionstyle.hpp>
 #include <verticesselectionstyle.hpp>
 #include <vtkPropAssembly.h>
+#include <vtkEventQtSlotConnect.h>
+#include <QProgressDialog>
+#include <QTimer>
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
@@ -32,6 +46,7 @@ public:
 
     const std::shared_ptr<Drawables::DrawableTriangleMesh> &getCurrentMesh() const;
     void setCurrentMesh(const std::shared_ptr<Drawables::DrawableTriangleMesh> &newCurrentMesh);
+    const std::shared_ptr<RenderScheduler> &getRenderScheduler() const;
 
 private slots:
     void on_clearCanvasButton_clicked();
@@ -53,6 +68,7 @@ private slots:
     void on_actionTrianglesRectangleSelection_triggered(bool checked);
 
     void on_actionTrianglesLassoSelection_triggered(bool checked);
+    void on_actionTrianglesFreehandSelection_triggered(bool checked);
 
     void slotFinalization(std::string, uchar*);
 
@@ -78,6 +94,8 @@ private slots:
 
     void slotUpdateView();
 
+    void slotRender();
+
     void slotAddAnnotationsRelationship(std::string, double, double, double, unsigned int, unsigned int, bool);
 
     void slotAddSemanticAttribute(std::string, std::string);
@@ -96,10 +114,53 @@ private slots:
 
     void slotSelectAnnotation(std::string id, bool selected);
 
+    void slotMeshLoaded();
+
+    void slotMeshLoadingFailed(QString message);
+
+    void slotAnnotationsBatchLoaded();
+
+    void slotAnnotationsLoaded();
+
+    void slotAnnotationsLoadingProgress(int progress);
+
+    void slotAnnotationsLoadingFailed(QString message);
+
+    void slotAnnotationChanged(std::string id);
+
+    void slotAnnotationRemoved(std::string id);
+
+    void slotAnnotationViewChanged(std::string id);
+
+    void slotAttributeViewChanged(std::string annotationId, unsigned int attributeId);
+
+    void on_actionOpenCityTiles_triggered();
+
+    void slotTileLoaded(unsigned int id);
+
+    void slotTileEvicted(unsigned int id);
+
+    void slotTileLoadingFailed(QString message);
+
+    void slotCameraMoved();
+
+    void slotUpdateTiles();
+
+    void slotLODProxyBuilt();
+
+    void slotInteractionStarted();
+
+    void slotInteractionEnded();
+
+    void slotInteractionSettled();
+
 private:
+    constexpr static int LOD_SETTLE_TIME = 150;                 //Milliseconds without interactions before the full mesh is drawn again
+
     Ui::MainWindow *ui;
 
-    vtkSmartPointer<vtkRenderer> renderer;
+    std::shared_ptr<ViewerScene> scene;
+    vtkSmartPointer<vtkRenderer> renderer;                      //Those of the scene, never replaced
     vtkSmartPointer<vtkPropAssembly> canvas;
     vtkSmartPointer<VerticesSelectionStyle> verticesSelectionStyle;
     vtkSmartPointer<LineSelectionStyle> linesSelectionStyle;
@@ -110,12 +171,27 @@ private:
     std::shared_ptr<AnnotationDialog> annotationDialog;
     std::shared_ptr<AnnotationsRelationshipDialog> relationshipDialog;
     std::shared_ptr<SemanticAttributeDialog> semanticAttributeDialog;
+    std::shared_ptr<MeshLoader> meshLoader;
+    std::shared_ptr<QProgressDialog> loadingDialog;
+    std::shared_ptr<AnnotationLoader> annotationLoader;
+    std::shared_ptr<AnnotationJournal> annotationJournal;
+    std::shared_ptr<TileManager> tileManager;
+    std::shared_ptr<SceneCache> sceneCache;
+    std::shared_ptr<CellPalette> cellPalette;
+    std::shared_ptr<RenderScheduler> renderScheduler;
+    std::shared_ptr<LODProxyBuilder> lodBuilder;
+    std::shared_ptr<LODProxy> lodProxy;
+    std::shared_ptr<QTimer> lodSettleTimer;
+    vtkSmartPointer<vtkEventQtSlotConnect> cameraConnections;
     std::shared_ptr<Drawables::DrawableTriangleMesh> currentMesh;
+    std::shared_ptr<MeshIdDataset> idDataset;
+    std::shared_ptr<MeshSidecarCache> meshCache;
     std::shared_ptr<SemantisedTriangleMesh::Annotation> annotationBeingModified;
-    std::vector<std::shared_ptr<SemantisedTriangleMesh::Relationship> > annotationsRelationships;
+    std::shared_ptr<BinaryRelationshipStore> relationships;
     std::string currentPath;
     uint lod;
-    unsigned int reachedId;
+    AnnotationIndex reachedId;
+    int activeTile;
 
     bool selectOnlyVisible;
     bool eraseSelected;
@@ -123,9 +199,16 @@ private:
     bool selectEdges;
     bool selectAnnotations;
     bool selectTrianglesWithLasso;
+    bool selectTrianglesFreehand;
     bool isAnnotationBeingModified;
 
     void drawMesh();
+    void setupInteractorStyles();
+    void resetRelationships();
+    void updateReachedId();
+    void activateTile(const std::shared_ptr<TileManager::Tile> &tile);
+    void drawTiles();
+    void buildLODProxy();
     void init();
 };
 #endif // MAINWINDOW_H
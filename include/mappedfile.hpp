@@ -0,0 +1,32 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <memory>
+#include <string>
+
+/**
+ * @brief The MappedFile class is a read-only memory mapping of a whole file.
+ * The mapping is released when the last reference to it goes away.
+ */
+class MappedFile
+{
+public:
+    ~MappedFile();
+
+    static std::shared_ptr<MappedFile> open(const std::string &filename);
+
+    const char *getData() const;
+    size_t getSize() const;
+    const std::string &getFilename() const;
+
+private:
+    MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::string filename;
+    const char *data;
+    size_t size;
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,56 @@
+#ifndef MEASUREBATCHRENDERER_H
+#define MEASUREBATCHRENDERER_H
+
+#include <drawableattribute.hpp>
+#include <drawabletrianglemesh.hpp>
+
+#include <memory>
+
+#include <vtkActor.h>
+#include <vtkActor2D.h>
+#include <vtkPolyData.h>
+#include <vtkPropAssembly.h>
+#include <vtkSmartPointer.h>
+
+/**
+ * @brief The MeasureBatchRenderer class draws the measures (euclidean, geodesic and bounding) of all the annotations
+ * of a mesh with two props, in place of the actors each measure would draw on its own. The segments of every
+ * measure are merged in a single polydata, coloured as their annotation; their values are placed by a single label
+ * placement pass, which drops the labels overlapping others (the longest measures win).
+ * Only measures of visible annotations drawing their attributes are drawn, each as long as its own flags ask for it.
+ */
+class MeasureBatchRenderer
+{
+public:
+    constexpr static const char* LABELS_ARRAY_NAME = "Labels";
+    constexpr static const char* PRIORITIES_ARRAY_NAME = "Priorities";
+
+    MeasureBatchRenderer();
+
+    /**
+     * @brief isBatched tells whether the attribute is drawn by the batch instead of by its own actors
+     */
+    static bool isBatched(const std::shared_ptr<SemantisedTriangleMesh::Attribute> &attribute);
+
+    /**
+     * @brief build collects again the measures of the annotations of the mesh
+     */
+    void build(const std::shared_ptr<Drawables::DrawableTriangleMesh> &mesh);
+    void clear();
+
+    vtkSmartPointer<vtkPropAssembly> getCanvas() const;
+    vtkIdType getMeasuresNumber() const;
+
+    double getLineWidth() const;
+    void setLineWidth(double newLineWidth);
+
+private:
+    vtkSmartPointer<vtkPolyData> lines;
+    vtkSmartPointer<vtkPolyData> labels;
+    vtkSmartPointer<vtkActor> linesActor;
+    vtkSmartPointer<vtkActor2D> labelsActor;
+    vtkSmartPointer<vtkPropAssembly> canvas;
+    vtkIdType measuresNumber;
+};
+
+#endif // MEASUREBATCHRENDERER_H
@@ -26,6 +26,10 @@ signals:
     void updateSignal();
     void updateViewSignal();
     void selectAnnotation(std::string id, bool selected);
+    void annotationChanged(std::string id);
+    void annotationRemoved(std::string id);
+    void annotationViewChanged(std::string id);
+    void attributeViewChanged(std::string annotationId, unsigned int attributeId);
 
 private slots:
     void updateSlot();
@@ -33,6 +37,8 @@ private slots:
     void slotShowAnnotation(bool);
     void slotDeleteAnnotation();
     void slotSelectAnnotation(bool selected);
+    void slotAttributesChanged();
+    void slotAttributeViewChanged(unsigned int attributeId);
 private:
     Ui::MeasuresListWidget *ui;
     std::shared_ptr<Drawables::DrawableTriangleMesh>  mesh;
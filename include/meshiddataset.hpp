@@ -0,0 +1,68 @@
+#ifndef MESHIDDATASET_H
+#define MESHIDDATASET_H
+
+#include <frustumbvh.hpp>
+#include <idbuffer.hpp>
+
+#include <memory>
+
+#include <vector>
+
+#include <vtkPlanes.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+
+/**
+ * @brief The MeshIdDataset class is the id-tagged copy of a mesh surface shared by all the selection styles.
+ * Points and cells carry their original index in the "OriginalMeshIds" arrays. The dataset is built once and
+ * rebuilt only when the points or the triangles of the watched surface are modified (colour changes do not count).
+ * A FrustumBVH over its points is built and rebuilt with it, for the rubber band selections; an IdBuffer of its
+ * triangles tells what the camera sees, for the selections of the visible elements only.
+ */
+class MeshIdDataset
+{
+public:
+    constexpr static const char* IDS_ARRAY_NAME = "OriginalMeshIds";
+
+    MeshIdDataset();
+
+    /**
+     * @brief setSurface sets the surface to be tagged
+     * @param surface the polydata rendered for the mesh, watched for geometry changes
+     * @param geometry optional polydata with the same points and triangles of surface, used in place of it to
+     * build the dataset (e.g. the double precision one of the ASCII parse)
+     */
+    void setSurface(vtkSmartPointer<vtkPolyData> surface, vtkSmartPointer<vtkPolyData> geometry = nullptr);
+
+    vtkSmartPointer<vtkPolyData> getDataset();
+    std::shared_ptr<FrustumBVH> getBVH();
+    /**
+     * @brief selectPoints returns the ids of the points inside the frustum of a rubber band selection
+     */
+    std::vector<vtkIdType> selectPoints(vtkPlanes* frustum);
+    /**
+     * @brief getIdBuffer returns the id buffer of the dataset, up to date with the camera of the renderer
+     */
+    std::shared_ptr<IdBuffer> getIdBuffer(vtkRenderer* renderer);
+    /**
+     * @brief selectVisiblePoints keeps the points, among those given, which are not occluded in the renderer
+     */
+    std::vector<vtkIdType> selectVisiblePoints(const std::vector<vtkIdType> &pointIds, vtkRenderer* renderer);
+    vtkSmartPointer<vtkPolyData> getSurface() const;
+    void invalidate();
+    bool isValid() const;
+
+private:
+    vtkSmartPointer<vtkPolyData> surface;
+    vtkSmartPointer<vtkPolyData> geometry;
+    vtkSmartPointer<vtkPolyData> dataset;
+    std::shared_ptr<FrustumBVH> bvh;
+    std::shared_ptr<IdBuffer> idBuffer;
+    vtkMTimeType builtGeometryTime;
+
+    vtkMTimeType getGeometryTime() const;
+    void build();
+};
+
+#endif // MESHIDDATASET_H
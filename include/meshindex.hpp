@@ -0,0 +1,49 @@
+#ifndef MESHINDEX_H
+#define MESHINDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Indices of the vertices, edges and triangles of a mesh: their position in the mesh, which is also the id of their
+ * point or cell in the vtk datasets. The mesh names its elements and annotations with strings: they are read once
+ * with toIndex() where they enter the selection, picking and annotation paths, which only pass indices around.
+ */
+typedef uint32_t VertexIndex;
+typedef uint32_t EdgeIndex;
+typedef uint32_t TriangleIndex;
+typedef uint32_t AnnotationIndex;
+
+inline uint32_t toIndex(const std::string &id)
+{
+    return static_cast<uint32_t>(std::stoul(id));
+}
+
+template<class T>
+inline uint32_t toIndex(const std::shared_ptr<T> &element)
+{
+    return toIndex(element->getId());
+}
+
+inline std::vector<uint32_t> toIndices(const std::vector<std::string> &ids)
+{
+    std::vector<uint32_t> indices;
+    indices.reserve(ids.size());
+    for(auto &id : ids)
+        indices.push_back(toIndex(id));
+    return indices;
+}
+
+template<class T>
+inline std::vector<uint32_t> toIndices(const std::vector<std::shared_ptr<T> > &elements)
+{
+    std::vector<uint32_t> indices;
+    indices.reserve(elements.size());
+    for(auto &element : elements)
+        indices.push_back(toIndex(element->getId()));
+    return indices;
+}
+
+#endif // MESHINDEX_H
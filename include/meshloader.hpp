@@ -0,0 +1,59 @@
+#ifndef MESHLOADER_H
+#define MESHLOADER_H
+
+#include <drawabletrianglemesh.hpp>
+#include <meshiddataset.hpp>
+#include <meshsidecarcache.hpp>
+
+#include <mutex>
+#include <string>
+
+#include <QThread>
+
+/**
+ * @brief The MeshLoader class loads a mesh and builds its id-tagged VTK datasets on a worker thread.
+ * The results are handed back to the GUI thread in a single MeshLoader::Result once the thread finishes,
+ * so that the caller can swap them in all at once. Cancellation uses the QThread interruption mechanism
+ * and is checked between the loading stages.
+ */
+class MeshLoader : public QThread
+{
+    Q_OBJECT
+public:
+
+    struct Result
+    {
+        std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+        std::shared_ptr<MeshIdDataset> idDataset;           //Already built, shared by the selection styles
+        std::shared_ptr<MeshSidecarCache> cache;            //May be nullptr, then the styles query the mesh
+    };
+
+    explicit MeshLoader(QObject *parent = nullptr);
+    ~MeshLoader() override;
+
+    void load(const std::string &filename);
+
+    bool getCanceled() const;
+    Result takeResult();
+
+    const std::string &getFilename() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void progressChanged(int);
+    void loadingFailed(QString);
+
+protected:
+    void run() override;
+
+private:
+    std::string filename;
+    Result result;
+    mutable std::mutex resultMutex;
+
+    bool stageCompleted(int progress);
+};
+
+#endif // MESHLOADER_H
@@ -0,0 +1,91 @@
+#ifndef MESHSIDECARCACHE_H
+#define MESHSIDECARCACHE_H
+
+#include <mappedfile.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+
+/**
+ * @brief The MeshSidecarCache class keeps next to a mesh file (in <mesh file>.meshcache) the data derived from it
+ * that would otherwise be recomputed at each opening: the minimum edge length, the length of the bounding box diagonal
+ * and a uniform grid of the vertices answering closest vertex queries.
+ * The cache is keyed by the size and the FNV-1a hash of the mesh file: when they do not match it is stale, and it is
+ * rebuilt and rewritten. A valid cache is memory mapped and used in place, its arrays are never copied.
+ */
+class MeshSidecarCache
+{
+public:
+    constexpr static const char* EXTENSION = "meshcache";
+    constexpr static uint32_t VERSION = 1;
+
+    /**
+     * @brief open returns the cache of a mesh file, mapping the sidecar when it is valid and rebuilding it
+     * (and writing it back) from the surface of the loaded mesh otherwise
+     * @return nullptr if the mesh file cannot be read or the surface has no points
+     */
+    static std::shared_ptr<MeshSidecarCache> open(const std::string &meshFilename, vtkSmartPointer<vtkPolyData> surface);
+    /**
+     * @brief load maps the sidecar of a mesh file
+     * @return nullptr if the sidecar is missing, malformed or stale
+     */
+    static std::shared_ptr<MeshSidecarCache> load(const std::string &meshFilename, uint64_t fileSize, uint64_t fileHash);
+    static std::shared_ptr<MeshSidecarCache> build(vtkSmartPointer<vtkPolyData> surface, uint64_t fileSize, uint64_t fileHash);
+    bool write(const std::string &meshFilename) const;
+
+    static std::string getCacheFilename(const std::string &meshFilename);
+    static uint64_t hash(const char *data, size_t size);
+
+    double getMinEdgeLength() const;
+    double getAABBDiagonalLength() const;
+    size_t getVerticesNumber() const;
+    size_t getTrianglesNumber() const;
+    bool isMapped() const;
+
+    /**
+     * @brief getClosestVertex finds the vertex nearest to a point, visiting the grid cells in rings around it
+     * @return the id of the vertex, -1 if the mesh has no vertices
+     */
+    long getClosestVertex(const double point[3]) const;
+
+private:
+    //Layout of the sidecar: the header, then cellStart, cellVertices and cellPoints, each aligned to 8 bytes
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t gridSize[3];
+        uint64_t fileSize;
+        uint64_t fileHash;
+        uint64_t verticesNumber;
+        uint64_t trianglesNumber;
+        uint64_t cellsNumber;
+        double minEdgeLength;
+        double diagonalLength;
+        double origin[3];
+        double cellSize;
+    };
+
+    constexpr static size_t MAX_GRID_SIZE = 1024;
+
+    Header header;
+    std::shared_ptr<MappedFile> file;
+    const uint32_t* cellStart;                  //cellsNumber + 1 offsets in cellVertices
+    const uint32_t* cellVertices;               //Vertex ids sorted by cell
+    const double* cellPoints;                   //Their coordinates, in the same order
+    std::vector<uint32_t> builtCellStart;
+    std::vector<uint32_t> builtCellVertices;
+    std::vector<double> builtCellPoints;
+
+    MeshSidecarCache();
+
+    size_t getCell(const double point[3], unsigned int cell[3]) const;
+    static size_t align(size_t size);
+};
+
+#endif // MESHSIDECARCACHE_H
@@ -0,0 +1,73 @@
+#ifndef PLYASCIIREADER_H
+#define PLYASCIIREADER_H
+
+#include <mappedfile.hpp>
+#include <plyheader.hpp>
+
+#include <string>
+#include <vector>
+
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+#include <vtkPolyData.h>
+
+/**
+ * @brief The PLYAsciiReader class parses ASCII triangle PLY files on all the available cores.
+ * The mapped body is split in chunks on line boundaries. A first pass counts the lines of each chunk, so that every
+ * chunk knows the index of its first line; a second pass parses the chunks concurrently, each one writing its
+ * vertices and triangles at their final positions, so the result does not depend on the scheduling of the threads.
+ * Coordinates are kept in double precision, as written in the file.
+ */
+class PLYAsciiReader
+{
+public:
+    PLYAsciiReader();
+
+    static bool canRead(const std::string &filename);
+
+    bool read(const std::string &filename);
+    /**
+     * @brief readBounds computes the bounding box of the vertices of a file, parsing its header and vertex lines only
+     * @param bounds xmin, xmax, ymin, ymax, zmin, zmax
+     */
+    static bool readBounds(const std::string &filename, double bounds[6]);
+
+    /**
+     * @brief hasOnlyGeometry tells whether the file holds nothing but vertex coordinates and triangles,
+     * i.e. whether the output describes it completely
+     */
+    bool hasOnlyGeometry() const;
+    /**
+     * @brief hasOnlyGeometry tells the same from the header of a file, before reading it
+     */
+    static bool hasOnlyGeometry(const std::string &filename);
+    /**
+     * @brief writeBinary writes the output as a binary little endian PLY file (double coordinates, int indices)
+     */
+    bool writeBinary(const std::string &filename) const;
+
+    vtkSmartPointer<vtkPolyData> getOutput() const;
+    const PLYHeader &getHeader() const;
+
+    unsigned int getThreadsNumber() const;
+    void setThreadsNumber(unsigned int newThreadsNumber);           //0 means one per core
+
+private:
+    struct Chunk
+    {
+        const char* begin;
+        const char* end;
+        size_t firstLine;           //Index of the first non blank line of the chunk in the body
+        size_t linesNumber;
+    };
+
+    std::shared_ptr<MappedFile> file;
+    PLYHeader header;
+    vtkSmartPointer<vtkPolyData> output;
+    unsigned int threadsNumber;
+
+    std::vector<Chunk> split(const char *begin, const char *end, unsigned int chunksNumber) const;
+    bool parseChunk(const Chunk &chunk, double *coordinates, vtkTypeInt32 *connectivity) const;
+};
+
+#endif // PLYASCIIREADER_H
@@ -0,0 +1,56 @@
+#ifndef PLYHEADER_H
+#define PLYHEADER_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief The PLYHeader class parses the header of a PLY file and describes the layout of its elements
+ */
+class PLYHeader
+{
+public:
+    enum class Format {ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN};
+    enum class Type {INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, INVALID};
+
+    struct Property
+    {
+        std::string name;
+        Type type;
+        bool isList;
+        Type countType;
+        size_t offset;          //Byte offset inside the element record, meaningful only for fixed size records
+    };
+
+    struct Element
+    {
+        std::string name;
+        size_t count;
+        size_t stride;          //Size in bytes of a record, 0 if the record contains lists
+        std::vector<Property> properties;
+
+        int getPropertyIndex(const std::string &name) const;
+    };
+
+    PLYHeader();
+
+    bool parse(const char *data, size_t size);
+
+    static size_t getTypeSize(Type type);
+    static Type getType(const std::string &name);
+    static bool isHostLittleEndian();
+
+    const Element *getElement(const std::string &name) const;
+    int getElementIndex(const std::string &name) const;
+
+    Format getFormat() const;
+    size_t getHeaderLength() const;
+    const std::vector<Element> &getElements() const;
+
+private:
+    Format format;
+    size_t headerLength;
+    std::vector<Element> elements;
+};
+
+#endif // PLYHEADER_H
@@ -0,0 +1,25 @@
+#ifndef PLYMAPPEDREADER_H
+#define PLYMAPPEDREADER_H
+
+#include <mappedfile.hpp>
+#include <plyheader.hpp>
+
+#include <string>
+
+/**
+ * @brief The PLYMappedReader class reads binary little endian PLY files through a memory mapping, touching only the
+ * blocks it needs. Meshes are still loaded by the library, which parses the file itself: the reader only answers the
+ * questions asked before a load, such as the bounds of the tiles of a city.
+ */
+class PLYMappedReader
+{
+public:
+    static bool canRead(const std::string &filename);
+    /**
+     * @brief readBounds computes the bounding box of the vertices of a file, reading its header and vertex block only
+     * @param bounds xmin, xmax, ymin, ymax, zmin, zmax
+     */
+    static bool readBounds(const std::string &filename, double bounds[6]);
+};
+
+#endif // PLYMAPPEDREADER_H
@@ -0,0 +1,63 @@
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+/**
+ * @brief The RenderScheduler class collapses any number of render requests in at most one render per display frame.
+ * The first request after a render starts a single shot timer that expires at the next frame boundary (one frame
+ * interval after the previous render), but never later than the latency budget after the request: the requests
+ * arriving meanwhile are served by the same render. Counters of requests, renders and of their latency are kept.
+ */
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    constexpr static int DEFAULT_FRAME_INTERVAL = 16;          //Milliseconds, a 60Hz display
+    constexpr static int DEFAULT_LATENCY_BUDGET = 33;          //Milliseconds between a request and its render
+
+    explicit RenderScheduler(QObject *parent = nullptr);
+
+    void requestRender();
+    /**
+     * @brief renderNow serves at once the pending request, if any
+     */
+    void renderNow();
+    bool isPending() const;
+
+    int getFrameInterval() const;
+    void setFrameInterval(int newFrameInterval);
+    int getLatencyBudget() const;
+    void setLatencyBudget(int newLatencyBudget);
+
+    unsigned long getRequestsNumber() const;
+    unsigned long getRendersNumber() const;
+    unsigned long getLateRendersNumber() const;          //Renders served after the latency budget
+    qint64 getMaxLatency() const;
+    double getMeanLatency() const;
+    void resetCounters();
+
+signals:
+    void render();
+
+private slots:
+    void slotTimeout();
+
+private:
+    QTimer timer;
+    QElapsedTimer clock;
+    int frameInterval;
+    int latencyBudget;
+    bool pending;
+    qint64 lastRender;          //-1 before the first render
+    qint64 firstRequest;        //Time of the oldest request served by the next render
+    unsigned long requestsNumber;
+    unsigned long rendersNumber;
+    unsigned long lateRendersNumber;
+    qint64 maxLatency;
+    qint64 totalLatency;
+};
+
+#endif // RENDERSCHEDULER_H
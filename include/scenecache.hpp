@@ -0,0 +1,112 @@
+#ifndef SCENECACHE_H
+#define SCENECACHE_H
+
+#include <drawableannotation.hpp>
+#include <drawableattribute.hpp>
+#include <drawabletrianglemesh.hpp>
+#include <cellpalette.hpp>
+#include <chunkedsurface.hpp>
+#include <measurebatchrenderer.hpp>
+#include <annotationoutlinelayer.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <vtkProp.h>
+#include <vtkPropAssembly.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+
+/**
+ * @brief The SceneCache class keeps the actors of a mesh and of its annotations in an assembly across frames.
+ * The surface of the mesh and every annotation are drawn once and then left in the assembly: update() only draws
+ * the annotations added since the previous call, removes the canvases of the deleted ones and rebuilds what has
+ * been marked as dirty (the surface, an annotation or a single attribute of an annotation).
+ * When a palette is set, it is applied to the surface every time the surface is drawn.
+ * Large surfaces are drawn in spatial chunks (see ChunkedSurface), culled against the view of the renderer.
+ * Measures are taken out of the canvases of their annotations and drawn all together by a MeasureBatchRenderer,
+ * collected again whenever an annotation is drawn, rebuilt or removed. Surface and line annotations have no canvas:
+ * their outlines are packed in an AnnotationOutlineLayer, and changes to their view (visibility, selection) only
+ * write its cell arrays.
+ * Other meshes (e.g. the resident tiles of a city) can be kept in the same assembly, drawn with their annotations
+ * once when they appear and removed when they go.
+ */
+class SceneCache
+{
+public:
+    SceneCache();
+
+    /**
+     * @brief update brings the assembly in line with the meshes, rebuilding only what changed
+     */
+    void update();
+
+    void markMeshDirty();
+    void markAnnotationDirty(const std::string &id);
+    void markAnnotationViewDirty(const std::string &id);          //Only its visibility or its selection changed
+    void markAttributeDirty(const std::string &annotationId, unsigned int attributeId);
+    void markAllDirty();
+
+    /**
+     * @brief getVersion returns a counter increased every time update() draws, rebuilds or removes something
+     */
+    unsigned long getVersion() const;
+
+    /**
+     * @brief setBackgroundMeshes sets the meshes drawn, annotations included, next to the current one
+     */
+    void setBackgroundMeshes(const std::vector<std::shared_ptr<Drawables::DrawableTriangleMesh> > &meshes);
+
+    vtkSmartPointer<vtkPropAssembly> getAssembly() const;
+    void setAssembly(const vtkSmartPointer<vtkPropAssembly> &newAssembly);           //Nothing is assumed to be in a new assembly
+
+    std::shared_ptr<Drawables::DrawableTriangleMesh> getMesh() const;
+    void setMesh(const std::shared_ptr<Drawables::DrawableTriangleMesh> &newMesh);
+
+    std::shared_ptr<CellPalette> getPalette() const;
+    void setPalette(const std::shared_ptr<CellPalette> &newPalette);
+
+    std::shared_ptr<ChunkedSurface> getChunkedSurface() const;
+    std::shared_ptr<MeasureBatchRenderer> getMeasureBatch() const;
+    std::shared_ptr<AnnotationOutlineLayer> getOutlineLayer() const;
+    void setRenderer(const vtkSmartPointer<vtkRenderer> &newRenderer);
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Drawables::DrawableAnnotation> annotation;
+        vtkSmartPointer<vtkPropAssembly> canvas;            //The one added to the assembly, update() may replace it
+        bool dirty;
+        bool viewDirty;
+        bool layered;                                       //Drawn by the outline layer, without a canvas
+        std::vector<std::shared_ptr<Drawables::DrawableAttribute> > dirtyAttributes;
+    };
+
+    vtkSmartPointer<vtkPropAssembly> assembly;
+    std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+    vtkSmartPointer<vtkProp> meshCanvas;
+    std::shared_ptr<CellPalette> palette;
+    std::shared_ptr<ChunkedSurface> chunkedSurface;
+    std::shared_ptr<MeasureBatchRenderer> measureBatch;
+    bool measuresDirty;
+    std::shared_ptr<AnnotationOutlineLayer> outlineLayer;
+    bool meshDirty;
+    unsigned long version;
+    std::map<SemantisedTriangleMesh::Annotation*, Entry> entries;
+    std::vector<std::shared_ptr<Drawables::DrawableTriangleMesh> > backgroundMeshes;
+    std::map<Drawables::DrawableTriangleMesh*, std::shared_ptr<Drawables::DrawableTriangleMesh> > drawnBackgroundMeshes;
+
+    void drawAnnotation(Entry &entry);
+    void drawAttributes(Entry &entry);
+    void updateAnnotationView(Entry &entry);
+    void drawChunks();
+    void detachMeasures(Entry &entry);
+    void removeMesh();
+    void removeBackgroundMesh(const std::shared_ptr<Drawables::DrawableTriangleMesh> &backgroundMesh);
+    void updateBackgroundMeshes();
+    Entry* findEntry(const std::string &id);
+};
+
+#endif // SCENECACHE_H
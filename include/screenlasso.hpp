@@ -0,0 +1,72 @@
+#ifndef SCREENLASSO_H
+#define SCREENLASSO_H
+
+#include <cstdint>
+#include <vector>
+
+#include <vtkPolyData.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+/**
+ * @brief The ScreenLasso class selects the triangles of a surface falling inside a polygon drawn on the screen.
+ * The polygon is given in viewport pixels, as the mouse draws it. All the points of the surface are projected with
+ * the world to normalised device coordinates matrix of the camera and tested against the polygon, in batches of
+ * BATCH_SIZE points whose loops carry no branches, so that the compiler vectorises them; the batches are split
+ * among threads. The points are projected in float, as offsets from the minimum of the bounds of the surface, so
+ * that large (e.g. georeferenced) coordinates keep their precision. A triangle is inside if its three points are,
+ * as in the rubber band selection.
+ * Points behind the camera are never inside.
+ */
+class ScreenLasso
+{
+public:
+    constexpr static unsigned int BATCH_SIZE = 256;
+
+    ScreenLasso();
+
+    /**
+     * @brief addPoint appends a corner to the polygon, unless it is the last one again
+     */
+    void addPoint(double x, double y);
+    void clear();
+    unsigned int getPointsNumber() const;
+    const std::vector<float> &getPolygon() const;           //x and y of each corner, the polygon closes by itself
+
+    /**
+     * @brief select returns the ids of the triangles of the surface (its polys) lying inside the polygon
+     * @param matrix row-major world to normalised device coordinates matrix, as the composite projection
+     * transform of vtkCamera
+     */
+    std::vector<vtkIdType> select(vtkPolyData* surface, const double matrix[16], int width, int height);
+    /**
+     * @brief select returns the ids of the triangles lying inside the polygon as seen by the active camera of the
+     * renderer, the polygon being in the pixels of its viewport
+     */
+    std::vector<vtkIdType> select(vtkPolyData* surface, vtkRenderer* renderer);
+
+    unsigned int getThreadsNumber() const;
+    void setThreadsNumber(unsigned int newThreadsNumber);           //0 means one per core
+
+private:
+    struct Edge
+    {
+        float x0, y0, y1;
+        float slope;                //Change of x along y, 0 for the horizontal edges that are never crossed
+    };
+
+    std::vector<float> polygon;
+    vtkSmartPointer<vtkPolyData> surface;
+    std::vector<uint32_t> triangles;                //3 point ids per triangle, read once per geometry
+    double origin[3];                               //Minimum of the bounds, subtracted from the points before the projection
+    vtkMTimeType geometryTime;
+    unsigned int threadsNumber;
+
+    vtkMTimeType getGeometryTime(vtkPolyData* polydata) const;
+    void readTriangles();
+    void classifyPoints(const float matrix[16], float width, float height, const std::vector<Edge> &edges,
+                        const float box[4], vtkIdType begin, vtkIdType end, std::vector<uint8_t> &inside) const;
+};
+
+#endif // SCREENLASSO_H
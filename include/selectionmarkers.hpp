@@ -0,0 +1,55 @@
+#ifndef SELECTIONMARKERS_H
+#define SELECTIONMARKERS_H
+
+#include <map>
+#include <vector>
+
+#include <vtkActor.h>
+#include <vtkGlyph3DMapper.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+
+/**
+ * @brief The SelectionMarkers class draws a sphere on each of a set of points with a single actor: the sphere is
+ * instanced by a vtkGlyph3DMapper on the points of a polydata, so that the cost of drawing does not grow with the
+ * number of actors. Points are keyed by an id (e.g. the one of the vertex they mark) and are added and removed in
+ * place, the array is never rebuilt.
+ */
+class SelectionMarkers
+{
+public:
+    SelectionMarkers();
+
+    /**
+     * @brief addPoint adds a marker, or moves the one with the same id
+     */
+    void addPoint(long id, const double point[3]);
+    void removePoint(long id);
+    bool contains(long id) const;
+    void clear();
+
+    size_t size() const;
+    bool empty() const;
+    std::vector<long> getIds() const;
+
+    double getRadius() const;
+    void setRadius(double newRadius);
+    void setColor(double r, double g, double b);
+
+    vtkSmartPointer<vtkActor> getActor() const;
+
+private:
+    vtkSmartPointer<vtkPoints> points;
+    vtkSmartPointer<vtkPolyData> polydata;
+    vtkSmartPointer<vtkSphereSource> sphere;
+    vtkSmartPointer<vtkGlyph3DMapper> mapper;
+    vtkSmartPointer<vtkActor> actor;
+    std::map<long, vtkIdType> indices;          //Position of the marker of each id in points
+    std::vector<long> ids;                      //Id of the marker in each position
+
+    void modified();
+};
+
+#endif // SELECTIONMARKERS_H
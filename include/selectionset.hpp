@@ -0,0 +1,50 @@
+#ifndef SELECTIONSET_H
+#define SELECTIONSET_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The SelectionSet class keeps the ids of the selected elements of a kind (vertices, edges or triangles) of
+ * a mesh: a bitset, one bit per element, answers the membership queries and a compact list of the ids enumerates
+ * them, so that listing or clearing the selection costs as much as the selection and not as the mesh.
+ * Removed ids stay in the list until it is compacted, which happens once they outnumber the selected ones or when
+ * the ids are read.
+ */
+class SelectionSet
+{
+public:
+    SelectionSet();
+
+    /**
+     * @brief reserve sizes the bitset for the elements of a mesh, the set grows by itself anyway
+     */
+    void reserve(unsigned long elementsNumber);
+
+    /**
+     * @brief insert adds the id, returning false if it was already selected
+     */
+    bool insert(unsigned long id);
+    /**
+     * @brief erase removes the id, returning false if it was not selected
+     */
+    bool erase(unsigned long id);
+    bool contains(unsigned long id) const;
+    void clear();
+
+    unsigned long size() const;
+    bool empty() const;
+    /**
+     * @brief getIds returns the selected ids, in the order they have been selected
+     */
+    const std::vector<unsigned long> &getIds() const;
+
+private:
+    mutable std::vector<uint64_t> bits;             //Compacting the list borrows the bits to drop the duplicates
+    mutable std::vector<unsigned long> ids;
+    unsigned long selectedNumber;
+
+    void compact() const;
+};
+
+#endif // SELECTIONSET_H
@@ -0,0 +1,129 @@
+#ifndef TILEMANAGER_H
+#define TILEMANAGER_H
+
+#include <drawabletrianglemesh.hpp>
+#include <meshiddataset.hpp>
+#include <meshsidecarcache.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+
+/**
+ * @brief The TileManager class pages the tiles of a city, each one a PLY mesh, in and out of memory.
+ * When the tiles are opened only their bounding boxes and an estimate of their memory footprint are computed,
+ * and indexed in a uniform grid. update() keeps resident the tiles nearest to the viewpoint that fit in the
+ * memory budget: missing ones are loaded by background workers (tileLoaded is emitted when one is ready), the
+ * others are evicted (tileEvicted is emitted before the mesh is released, still on the GUI thread).
+ * The annotations of a tile are kept next to it, in <tile name>.bant: they are read when the tile is loaded and
+ * written back when it is evicted, so they always stay attached to their tile.
+ */
+class TileManager : public QObject
+{
+    Q_OBJECT
+public:
+    constexpr static size_t DEFAULT_MEMORY_BUDGET = static_cast<size_t>(2) * 1024 * 1024 * 1024;
+    //Rough footprint of a vertex and of a triangle of a loaded DrawableTriangleMesh, with its VTK copy
+    constexpr static size_t BYTES_PER_VERTEX = 256;
+    constexpr static size_t BYTES_PER_TRIANGLE = 192;
+
+    enum class TileState {UNLOADED, LOADING, RESIDENT, EVICTING};
+
+    struct Tile
+    {
+        unsigned int id;
+        std::string filename;
+        double bounds[6];
+        size_t estimatedBytes;
+        TileState state;
+        std::shared_ptr<Drawables::DrawableTriangleMesh> mesh;
+        std::shared_ptr<MeshIdDataset> idDataset;
+        std::shared_ptr<MeshSidecarCache> meshCache;
+
+        double getDistance(const double point[3]) const;
+    };
+
+    explicit TileManager(QObject *parent = nullptr);
+    ~TileManager() override;
+
+    /**
+     * @brief open indexes a set of tiles, nothing is loaded until update is called
+     */
+    bool open(const std::vector<std::string> &filenames);
+    /**
+     * @brief close drops every tile, writing back the annotations of the resident ones
+     */
+    void close();
+    bool isOpen() const;
+
+    /**
+     * @brief update chooses the tiles to be resident for a viewpoint, and schedules loads and evictions accordingly
+     */
+    void update(const double viewpoint[3]);
+
+    std::vector<std::shared_ptr<Tile> > getResidentTiles() const;
+    std::shared_ptr<Tile> getNearestResidentTile(const double point[3]) const;
+    std::shared_ptr<Tile> getTile(unsigned int id) const;
+    size_t getTilesNumber() const;
+    void getBounds(double bounds[6]) const;
+
+    /**
+     * @brief setPinnedTile keeps a tile resident whatever the viewpoint (e.g. the one being annotated)
+     */
+    void setPinnedTile(int id);
+    int getPinnedTile() const;
+
+    size_t getMemoryBudget() const;
+    void setMemoryBudget(size_t newMemoryBudget);
+    double getResidentRadius() const;
+    void setResidentRadius(double newResidentRadius);           //0 means no limit besides the memory budget
+
+    static std::string getAnnotationsFilename(const std::string &tileFilename);
+
+signals:
+    void tileLoaded(unsigned int id);
+    void tileEvicted(unsigned int id);
+    void loadingFailed(QString);
+
+private:
+    struct Task
+    {
+        unsigned int tile;
+        bool load;                  //false for evictions
+    };
+
+    std::vector<std::shared_ptr<Tile> > tiles;
+    double bounds[6];
+    //Uniform grid over the tiles bounding boxes
+    double cellSize;
+    unsigned int gridSize[3];
+    std::vector<std::vector<unsigned int> > cells;
+
+    size_t memoryBudget;
+    double residentRadius;
+    int pinnedTile;
+
+    std::vector<std::thread> workers;
+    std::deque<Task> tasks;
+    bool stopping;
+    mutable std::mutex tilesMutex;
+    std::condition_variable tasksCondition;
+
+    void buildIndex();
+    std::vector<unsigned int> queryIndex(const double point[3], double radius) const;
+    void startWorkers();
+    void stopWorkers();
+    void work();
+    void loadTile(const std::shared_ptr<Tile> &tile);
+    void evictTile(const std::shared_ptr<Tile> &tile);
+    static bool readTileInfo(Tile &tile);
+    static void writeAnnotations(const std::shared_ptr<Tile> &tile);
+};
+
+#endif // TILEMANAGER_H
@@ -0,0 +1,62 @@
+#ifndef VIEWERSCENE_H
+#define VIEWERSCENE_H
+
+#include <drawabletrianglemesh.hpp>
+#include <scenecache.hpp>
+
+#include <memory>
+
+#include <vtkActor.h>
+#include <vtkPropAssembly.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderer.h>
+#include <vtkSmartPointer.h>
+
+/**
+ * @brief The ViewerScene class owns what the viewer draws for its whole life: the renderer, the canvas assembly
+ * in it and the SceneCache (with its layers) filling the canvas. None of them is ever created again: opening a mesh,
+ * clearing the viewer or loading annotations only replace the content of the cache, so the actors, their GPU
+ * buffers and the camera of what did not change are kept. The camera is framed again only when a different mesh
+ * becomes the content.
+ * When there is nothing to draw, a placeholder (a tetrahedron) is shown in the canvas.
+ */
+class ViewerScene
+{
+public:
+    ViewerScene();
+
+    /**
+     * @brief attach adds the renderer to the window, once
+     */
+    void attach(vtkRenderWindow* window);
+
+    /**
+     * @brief setContent replaces the mesh drawn by the scene, the annotations of the same mesh are kept as they are
+     */
+    void setContent(const std::shared_ptr<Drawables::DrawableTriangleMesh> &mesh);
+
+    /**
+     * @brief update brings the canvas in line with the content and frames it if it has just been replaced
+     */
+    void update();
+
+    void resetCamera();
+    void resetCamera(const double bounds[6]);       //The pending framing of the content is dropped
+
+    bool getPlaceholderVisible() const;
+    void setPlaceholderVisible(bool newPlaceholderVisible);
+
+    vtkSmartPointer<vtkRenderer> getRenderer() const;
+    vtkSmartPointer<vtkPropAssembly> getCanvas() const;
+    std::shared_ptr<SceneCache> getSceneCache() const;
+
+private:
+    vtkSmartPointer<vtkRenderer> renderer;
+    vtkSmartPointer<vtkPropAssembly> canvas;
+    vtkSmartPointer<vtkActor> placeholder;
+    std::shared_ptr<SceneCache> sceneCache;
+    bool placeholderVisible;
+    bool framingPending;
+};
+
+#endif // VIEWERSCENE_H
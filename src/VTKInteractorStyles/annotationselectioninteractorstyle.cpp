@@ -43,7 +43,7 @@ void AnnotationSelectionInteractorStyle::OnLeftButtonDown()
         SemantisedTriangleMesh::Point pickedPos(pickPos[0], pickPos[1], pickPos[2]);
         if(picked >= 0)
         {
-            auto v = mesh->getClosestPoint(pickedPos);
+            auto v = (meshCache != nullptr ? mesh->getVertex(static_cast<unsigned long>(meshCache->getClosestVertex(pickPos))) : mesh->getClosestPoint(pickedPos));
             auto annotations = mesh->getAnnotations();
 
             vector<std::shared_ptr<DrawableAnnotation> > selected;
@@ -72,6 +72,7 @@ void AnnotationSelectionInteractorStyle::OnLeftButtonDown()
                         selectedAnnotations.push_back(selectedAnnotation);
                     else
                         selectedAnnotations.erase(sait);
+                    emit(annotationViewChanged(selectedAnnotation->getId()));
                 }
 
                 emit(updateView());
@@ -91,7 +92,14 @@ void AnnotationSelectionInteractorStyle::resetSelection()
 {
     if(mesh == nullptr) return;
     for(unsigned int i = 0; i < mesh->getAnnotations().size(); i++)
-        dynamic_pointer_cast<DrawableAnnotation>(mesh->getAnnotations()[i])->setSelected(false);
+    {
+        auto annotation = dynamic_pointer_cast<DrawableAnnotation>(mesh->getAnnotations()[i]);
+        if(annotation->getSelected())
+        {
+            annotation->setSelected(false);
+            emit(annotationViewChanged(annotation->getId()));
+        }
+    }
     selectedAnnotations.clear();
     emit(updateView());
 }
@@ -158,3 +166,13 @@ void AnnotationSelectionInteractorStyle::setMesh(const std::shared_ptr<DrawableT
 {
     mesh = newMesh;
 }
+
+const std::shared_ptr<MeshSidecarCache> &AnnotationSelectionInteractorStyle::getMeshCache() const
+{
+    return meshCache;
+}
+
+void AnnotationSelectionInteractorStyle::setMeshCache(const std::shared_ptr<MeshSidecarCache> &newMeshCache)
+{
+    meshCache = newMeshCache;
+}
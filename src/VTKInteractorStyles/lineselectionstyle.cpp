@@ -2,7 +2,6 @@
 #include <vtkCellArray.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindow.h>
-#include <vtkSphereSource.h>
 #include <vtkProperty.h>
 #include <vtkLine.h>
 #include <vtkPolyDataMapper.h>
@@ -32,24 +31,22 @@ LineSelectionStyle::LineSelectionStyle()
     splineActor  = vtkSmartPointer<vtkActor>::New();
     splineActor->GetProperty()->SetColor(1.0,0,0);
     splineActor->GetProperty()->SetLineWidth(3.0);
-    sphereAssembly = vtkSmartPointer<vtkPropAssembly>::New();          //Assembly of actors
+    markers = std::make_shared<SelectionMarkers>();
 }
 
 void LineSelectionStyle::OnRightButtonDown()
 {
     if(lassoStarted){
         ren->RemoveActor(assembly);
-        this->assembly->RemovePart(sphereAssembly);
-        sphereAssembly = vtkSmartPointer<vtkPropAssembly>::NewInstance(sphereAssembly);
+        this->assembly->RemovePart(markers->getActor());
+        markers->clear();
         polyLine.clear();
         lastVertex = nullptr;
         firstVertex = nullptr;
         lassoStarted = false;
         this->assembly->Modified();
         this->ren->AddActor(this->assembly);
-        this->ren->Render();
-        this->qvtkwidget->update();
-        this->qvtkwidget->renderWindow()->Render();
+        emit(updateView());
 
     }
 }
@@ -82,19 +79,10 @@ void LineSelectionStyle::OnLeftButtonDown()
             SemantisedTriangleMesh::Point pickedPos(pickPos[0], pickPos[1], pickPos[2]);
             if(picked >= 0)
             {
-                auto v = mesh->getClosestPoint(pickedPos);
-
-                vtkIdType pointID = static_cast<vtkIdType>(std::stoi(v->getId()));
+                VertexIndex pointID = meshCache != nullptr ? static_cast<VertexIndex>(meshCache->getClosestVertex(pickPos)) : toIndex(mesh->getClosestPoint(pickedPos));
                 auto actualVertex = mesh->getVertex(static_cast<unsigned long>(pointID));
-                vtkSmartPointer<vtkSphereSource> sphereSource = vtkSmartPointer<vtkSphereSource>::New();
-                sphereSource->SetCenter(actualVertex->getX(), actualVertex->getY(), actualVertex->getZ());
-                sphereSource->SetRadius(sphereRadius);
-                vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-                mapper->SetInputConnection(sphereSource->GetOutputPort());
-                vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-                actor->GetProperty()->SetColor(0,0,1);
-                actor->SetMapper(mapper);
-                sphereAssembly->AddPart(actor);
+                double point[3] = {actualVertex->getX(), actualVertex->getY(), actualVertex->getZ()};
+                markers->addPoint(static_cast<long>(pointID), point);
                 if(firstVertex == nullptr){
                     firstVertex = actualVertex;
                     polyLine.push_back(firstVertex);
@@ -129,30 +117,34 @@ void LineSelectionStyle::resetSelection()
     lassoStarted = false;
     polylinePoints = vtkSmartPointer<vtkPoints>::NewInstance(polylinePoints);
     polyLineSegments = vtkSmartPointer<vtkCellArray>::NewInstance(polyLineSegments);
-    this->assembly->RemovePart(sphereAssembly);
+    this->assembly->RemovePart(markers->getActor());
+    markers->clear();
     this->assembly->RemovePart(splineActor);
     this->assembly->RemovePart(annotation->getCanvas());
     this->assembly->Modified();
     this->annotation->clearPolylines();
-    for(uint i = 0; i < mesh->getEdgesNumber(); i++){
-        auto e = mesh->getEdge(i);
-        e->removeFlag(FlagType::SELECTED);
-    }
+    //Only the selected edges are visited
+    for(auto id : selectedEdges.getIds())
+        mesh->getEdge(id)->removeFlag(FlagType::SELECTED);
+    selectedEdges.clear();
 
 }
 
 void LineSelectionStyle::defineSelection(std::vector<std::vector<std::shared_ptr<Vertex> > > polylines)
 {
+    //The points of the polylines are taken from their vertices, their ids are not read
     for(uint i = 0; i < polylines.size(); i++)
     {
-        polylinePoints->InsertNextPoint(points->GetPoint(static_cast<vtkIdType>(std::stoi(polylines.at(i).at(0)->getId()))));
+        auto first = polylines.at(i).at(0);
+        polylinePoints->InsertNextPoint(first->getX(), first->getY(), first->getZ());
         for(uint j = 1; j < polylines.at(i).size(); j++)
         {
             std::shared_ptr<Vertex> v1 = polylines.at(i).at(j - 1);
             auto v2 = polylines.at(i).at(j);
             auto e = v1->getCommonEdge(v2);
             e->addFlag(FlagType::SELECTED);
-            polylinePoints->InsertNextPoint(points->GetPoint(static_cast<vtkIdType>(std::stoi(v2->getId()))));
+            selectedEdges.insert(toIndex(e));
+            polylinePoints->InsertNextPoint(v2->getX(), v2->getY(), v2->getZ());
             reachedID++;
             vtkSmartPointer<vtkLine> line = vtkSmartPointer<vtkLine>::New();
             line->GetPointIds()->SetNumberOfIds(2);
@@ -165,25 +157,17 @@ void LineSelectionStyle::defineSelection(std::vector<std::vector<std::shared_ptr
     }
 }
 
-void LineSelectionStyle::finalizeAnnotation(std::string id, std::string tag, unsigned char color[])
+void LineSelectionStyle::finalizeAnnotation(AnnotationIndex id, std::string tag, unsigned char color[])
 {
     if(mesh == nullptr) return;
-    vector<std::shared_ptr<SemantisedTriangleMesh::Edge> > selectedEdges;
-    for(uint i = 0; i < mesh->getEdgesNumber(); i++){
-        auto e = mesh->getEdge(i);
-        if(e->searchFlag(FlagType::SELECTED) >= 0)
-            selectedEdges.push_back(e);
-    }
-
-    if(selectedEdges.size() > 0){
+    if(!selectedEdges.empty()){
         assembly->RemovePart(annotation->getCanvas());
-        this->annotation->setId(id);
+        this->annotation->setId(std::to_string(id));
         this->annotation->setTag(tag);
         this->annotation->setColor(color);
         this->annotation->setMesh(mesh);
         this->annotation->update();
         this->mesh->addAnnotation(annotation);
-        this->mesh->draw(assembly);
         this->annotation = std::make_shared<DrawableLineAnnotation>();
         this->annotation->setId("0");
         this->annotation->setTag("");
@@ -198,7 +182,7 @@ void LineSelectionStyle::draw()
 {
     ren->RemoveActor(assembly);
     this->assembly->RemovePart(splineActor);
-    this->assembly->RemovePart(sphereAssembly);
+    this->assembly->RemovePart(markers->getActor());
 
     // Setup actor and mapper
     if(annotation->getPolyLines().size() > 0 || polyLine.size() > 1)
@@ -213,12 +197,11 @@ void LineSelectionStyle::draw()
         splineActor->GetProperty()->SetColor(255,0,0);
         this->assembly->AddPart(splineActor);
     }
-    this->assembly->AddPart(sphereAssembly);
+    if(!markers->empty())
+        this->assembly->AddPart(markers->getActor());
     this->assembly->Modified();
     ren->AddActor(assembly);
-    ren->Render();
-    ren->GetRenderWindow()->Render();
-    this->qvtkwidget->update();
+    emit(updateView());
 }
 
 
@@ -232,14 +215,9 @@ void LineSelectionStyle::setSplineActor(const vtkSmartPointer<vtkActor> &value)
     splineActor = value;
 }
 
-vtkSmartPointer<vtkPropAssembly> LineSelectionStyle::getSphereAssembly() const
+const std::shared_ptr<SelectionMarkers> &LineSelectionStyle::getMarkers() const
 {
-    return sphereAssembly;
-}
-
-void LineSelectionStyle::setSphereAssembly(const vtkSmartPointer<vtkPropAssembly> &value)
-{
-    sphereAssembly = value;
+    return markers;
 }
 
 vtkSmartPointer<vtkPropAssembly> LineSelectionStyle::getAssembly() const
@@ -300,6 +278,7 @@ double LineSelectionStyle::getSphereRadius() const
 void LineSelectionStyle::setSphereRadius(double value)
 {
     sphereRadius = value;
+    markers->setRadius(sphereRadius);
 }
 
 bool LineSelectionStyle::getSelectionMode() const
@@ -374,19 +353,31 @@ const std::shared_ptr<DrawableTriangleMesh> &LineSelectionStyle::getMesh() const
 
 void LineSelectionStyle::setMesh(const std::shared_ptr<DrawableTriangleMesh> &newMesh)
 {
+    //The ids of the selection belong to the previous mesh
+    if(newMesh != mesh)
+        selectedEdges.clear();
     mesh = newMesh;
-    this->sphereRadius = this->mesh->getAABBDiagonalLength() / RADIUS_RATIO;
-    this->tolerance = this->mesh->getMinEdgeLength() * TOLERANCE_RATIO;
+    //The cache spares a visit of the whole mesh
+    if(meshCache != nullptr)
+    {
+        this->sphereRadius = meshCache->getAABBDiagonalLength() / RADIUS_RATIO;
+        this->tolerance = meshCache->getMinEdgeLength() * TOLERANCE_RATIO;
+    } else
+    {
+        this->sphereRadius = this->mesh->getAABBDiagonalLength() / RADIUS_RATIO;
+        this->tolerance = this->mesh->getMinEdgeLength() * TOLERANCE_RATIO;
+    }
+    markers->setRadius(sphereRadius);
 }
 
-vtkSmartPointer<vtkPolyData> LineSelectionStyle::getPoints() const
+const std::shared_ptr<MeshIdDataset> &LineSelectionStyle::getIdDataset() const
 {
-    return points;
+    return idDataset;
 }
 
-void LineSelectionStyle::setPoints(const vtkSmartPointer<vtkPolyData> &value)
+void LineSelectionStyle::setIdDataset(const std::shared_ptr<MeshIdDataset> &newIdDataset)
 {
-    points = value;
+    idDataset = newIdDataset;
 }
 
 
@@ -399,3 +390,13 @@ void LineSelectionStyle::setCellPicker(const vtkSmartPointer<vtkCellPicker> &val
 {
     cellPicker = value;
 }
+
+const std::shared_ptr<MeshSidecarCache> &LineSelectionStyle::getMeshCache() const
+{
+    return meshCache;
+}
+
+void LineSelectionStyle::setMeshCache(const std::shared_ptr<MeshSidecarCache> &newMeshCache)
+{
+    meshCache = newMeshCache;
+}
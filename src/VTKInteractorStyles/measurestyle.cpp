@@ -77,9 +77,9 @@ void MeasureStyle::manageRulerMovement(std::shared_ptr<SemantisedTriangleMesh::V
     measurePath.push_back(end);
     dynamic_pointer_cast<SemantisedTriangleMesh::GeometricAttribute>(onCreationAttribute)->clearMeasurePointsID();
     auto eucAtt = dynamic_pointer_cast<DrawableEuclideanMeasure>(onCreationAttribute);
-    eucAtt->addMeasurePointID(std::stoi(measurePath[0]->getId()));
+    eucAtt->addMeasurePointID(toIndex(measurePath[0]));
     if(measurePath.size() > 1)
-        eucAtt->addMeasurePointID(std::stoi(measurePath[1]->getId()));
+        eucAtt->addMeasurePointID(toIndex(measurePath[1]));
 
 
 }
@@ -100,7 +100,7 @@ void MeasureStyle::manageTapeMovement(std::shared_ptr<SemantisedTriangleMesh::Ve
     geoAtt->clearMeasurePointsID();
     for(unsigned int i = 0; i < measurePath.size(); i++)
     {
-        geoAtt->addMeasurePointID(std::stoi(measurePath[i]->getId()));
+        geoAtt->addMeasurePointID(toIndex(measurePath[i]));
     }
 }
 
@@ -206,8 +206,8 @@ void MeasureStyle::manageBoundingMovement()
 
     auto boundAtt = dynamic_pointer_cast<DrawableBoundingMeasure>(onCreationAttribute);
     boundAtt->clearMeasurePointsID();
-    boundAtt->addMeasurePointID(std::stoi(measurePath[0]->getId()));
-    boundAtt->addMeasurePointID(std::stoi(measurePath[1]->getId()));
+    boundAtt->addMeasurePointID(toIndex(measurePath[0]));
+    boundAtt->addMeasurePointID(toIndex(measurePath[1]));
     boundAtt->setOrigin(boundingOrigin);
     boundAtt->setDirection(boundingDirection);
     boundAtt->update();
@@ -369,7 +369,7 @@ void MeasureStyle::OnLeftButtonDown()
             }
         } else if(picked >= 0)
         {
-            auto v = mesh->getClosestPoint(pickedPos);
+            auto v = (meshCache != nullptr ? mesh->getVertex(static_cast<unsigned long>(meshCache->getClosestVertex(pickPos))) : mesh->getClosestPoint(pickedPos));
 
             for(unsigned int i = 0; i < mesh->getAnnotations().size(); i++){
                 if(mesh->getAnnotations()[i]->isPointInAnnotation(v) && dynamic_pointer_cast<DrawableAnnotation>(mesh->getAnnotations()[i])->getSelected()){
@@ -385,13 +385,14 @@ void MeasureStyle::OnLeftButtonDown()
                         {
                             measurePath.push_back(v);
                             auto eucAtt = dynamic_pointer_cast<DrawableEuclideanMeasure>(onCreationAttribute);
-                            eucAtt->addMeasurePointID(std::stoi(v->getId()));
-                            eucAtt->addMeasurePointID(std::stoi(v->getId()));
+                            VertexIndex vid = toIndex(v);
+                            eucAtt->addMeasurePointID(vid);
+                            eucAtt->addMeasurePointID(vid);
                             break;
                         } else if (measureType == MeasureType::TAPE)
                         {
                             auto geoAtt = dynamic_pointer_cast<DrawableGeodesicMeasure>(onCreationAttribute);
-                            geoAtt->addMeasurePointID(std::stoi(v->getId()));
+                            geoAtt->addMeasurePointID(toIndex(v));
                             break;
                         }
 
@@ -440,7 +441,7 @@ void MeasureStyle::OnRightButtonDown()
     {
         if(measurePath.size() > 0)
         {
-            dynamic_pointer_cast<GeometricAttribute>(onCreationAttribute)->removeMeasurePointID(std::stoi(measurePath.back()->getId()));
+            dynamic_pointer_cast<GeometricAttribute>(onCreationAttribute)->removeMeasurePointID(toIndex(measurePath.back()));
             measurePath.pop_back();
             if(measurePath.size() > 0)
                 last = measurePath.back();
@@ -556,7 +557,15 @@ void MeasureStyle::draw()
     if(drawAttributes)
         onCreationAttribute->draw(measureAssembly);
     measureAssembly->Modified();
-    meshRenderer->Render();
-    meshRenderer->GetRenderWindow()->Render();
-    this->qvtkwidget->update();
+    emit(updateView());
+}
+
+const std::shared_ptr<MeshSidecarCache> &MeasureStyle::getMeshCache() const
+{
+    return meshCache;
+}
+
+void MeasureStyle::setMeshCache(const std::shared_ptr<MeshSidecarCache> &newMeshCache)
+{
+    meshCache = newMeshCache;
 }
@@ -1,22 +1,22 @@
 #include "triangleselectionstyle.hpp"
 #include "vtkRenderWindow.h"
 
-#include <vtkVertexGlyphFilter.h>
 #include <vtkPointData.h>
 #include <vtkRenderedAreaPicker.h>
-#include <vtkExtractGeometry.h>
-#include <vtkSelectVisiblePoints.h>
 #include <vtkParametricFunctionSource.h>
 #include <vtkParametricSpline.h>
-#include <vtkSphereSource.h>
 #include <vtkImplicitFunction.h>
 #include <vtkPlanes.h>
 #include <vtkProperty.h>
 #include <vtkPolyDataMapper.h>
+#include <vtkPolyDataMapper2D.h>
+#include <vtkProperty2D.h>
 #include <vtkRenderLargeImage.h>
 #include <vtkLine.h>
 #include <vtkWorldPointPicker.h>
 
+#include <algorithm>
+
 
 using namespace std;
 using namespace SemantisedTriangleMesh;
@@ -27,6 +27,7 @@ TriangleSelectionStyle::TriangleSelectionStyle(){
     selectionType = SelectionType::RECTANGLE_AREA;
     visibleTrianglesOnly = true;
     lasso_started = false;
+    freehandStarted = false;
     alreadyStarted = false;
     showSelectedTriangles = true;
     firstVertex = nullptr;
@@ -36,7 +37,13 @@ TriangleSelectionStyle::TriangleSelectionStyle(){
     splineActor  = vtkSmartPointer<vtkActor>::New();
     splineActor->GetProperty()->SetColor(1.0,0,0);
     splineActor->GetProperty()->SetLineWidth(3.0);
-    sphereAssembly = vtkSmartPointer<vtkPropAssembly>::New();          //Assembly of actors
+    freehandLasso = std::make_shared<ScreenLasso>();
+    freehandActor = vtkSmartPointer<vtkActor2D>::New();
+    freehandActor->SetMapper(vtkSmartPointer<vtkPolyDataMapper2D>::New());
+    freehandActor->GetProperty()->SetColor(1.0,0,0);
+    freehandActor->GetProperty()->SetLineWidth(3.0);
+    markers = std::make_shared<SelectionMarkers>();
+    palette = std::make_shared<CellPalette>();
     this->cellPicker = vtkSmartPointer<vtkCellPicker>::New();
 }
 
@@ -51,29 +58,42 @@ void TriangleSelectionStyle::OnRightButtonDown(){
     this->FindPokedRenderer(x, y);
     //Some tolerance is set for the picking
     this->cellPicker->SetTolerance(0);
+    //Large surfaces are drawn in chunks: the cell picked in a chunk is mapped back to the triangle of the mesh
+    auto chunks = palette->getChunks();
+    this->cellPicker->InitializePickList();
+    if(chunks != nullptr && chunks->isBuilt() && chunks->getSurfaceActor() == mesh->getSurfaceActor())
+        chunks->addToPickList(this->cellPicker);
+    else
+        this->cellPicker->AddPickList(mesh->getSurfaceActor());
     this->cellPicker->Pick(x, y, 0, ren);
     //If some point has been picked...
-    vtkIdType pickedTriangleID = this->cellPicker->GetCellId();
+    vtkIdType pickedTriangleID = ChunkedSurface::toGlobalCellId(this->cellPicker->GetDataSet(), this->cellPicker->GetCellId());
     if(pickedTriangleID > 0 && pickedTriangleID < this->mesh->getTrianglesNumber()){
 
-        vector<std::string> selected;
+        vector<TriangleIndex> selected;
         if(lasso_started){
             auto t = mesh->getTriangle(static_cast<unsigned long>(pickedTriangleID));
             std::dynamic_pointer_cast<DrawableSurfaceAnnotation>(this->annotation)->addOutline(polygonContour);
             auto innerTriangles = mesh->regionGrowing(polygonContour, t);
+            //The region grows behind occlusions too: only what the camera sees is kept
+            std::shared_ptr<IdBuffer> buffer = visibleTrianglesOnly ? idDataset->getIdBuffer(ren) : nullptr;
+            //The ids of the grown triangles are read once, from here on they are indices
+            selected.reserve(innerTriangles.size());
             for(auto tit = innerTriangles.begin(); tit != innerTriangles.end(); tit++){
-                selected.push_back((*tit)->getId());
+                TriangleIndex id = toIndex(*tit);
+                if(buffer == nullptr || buffer->isTriangleVisible(static_cast<vtkIdType>(id)))
+                    selected.push_back(id);
             }
             splinePoints = vtkSmartPointer<vtkPoints>::New();
-            assembly->RemovePart(sphereAssembly);
-            sphereAssembly = vtkSmartPointer<vtkPropAssembly>::New();
+            assembly->RemovePart(markers->getActor());
+            markers->clear();
             polygonContour.clear();
             lastVertex = nullptr;
             firstVertex = nullptr;
             lasso_started = false;
             this->assembly->RemovePart(splineActor);
         }else
-            selected.push_back(std::to_string(static_cast<unsigned long>(pickedTriangleID)));
+            selected.push_back(static_cast<TriangleIndex>(pickedTriangleID));
 
         defineSelection(selected);
 
@@ -83,6 +103,12 @@ void TriangleSelectionStyle::OnRightButtonDown(){
 
 void TriangleSelectionStyle::OnMouseMove(){
 
+    //While the freehand lasso is dragged the camera stays still
+    if(freehandStarted){
+        addFreehandPoint();
+        drawFreehandPath();
+        return;
+    }
     vtkInteractorStyleRubberBandPick::OnMouseMove();
 
 }
@@ -116,19 +142,10 @@ void TriangleSelectionStyle::OnLeftButtonDown(){
                     SemantisedTriangleMesh::Point pickedPos(pickPos[0], pickPos[1], pickPos[2]);
                     if(picked >= 0)
                     {
-                        auto v = mesh->getClosestPoint(pickedPos);
-
-                        vtkIdType pointID = static_cast<vtkIdType>(std::stoi(v->getId()));
+                        VertexIndex pointID = meshCache != nullptr ? static_cast<VertexIndex>(meshCache->getClosestVertex(pickPos)) : toIndex(mesh->getClosestPoint(pickedPos));
                         auto actualVertex = mesh->getVertex(static_cast<unsigned long>(pointID));
-                        vtkSmartPointer<vtkSphereSource> sphereSource = vtkSmartPointer<vtkSphereSource>::New();
-                        sphereSource->SetCenter(actualVertex->getX(), actualVertex->getY(), actualVertex->getZ());
-                        sphereSource->SetRadius(sphereRadius);
-                        vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-                        mapper->SetInputConnection(sphereSource->GetOutputPort());
-                        vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-                        actor->GetProperty()->SetColor(0,0,1);
-                        actor->SetMapper(mapper);
-                        sphereAssembly->AddPart(actor);
+                        double point[3] = {actualVertex->getX(), actualVertex->getY(), actualVertex->getZ()};
+                        markers->addPoint(static_cast<long>(pointID), point);
                         if(firstVertex == nullptr){
                             firstVertex = actualVertex;
                             polygonContour.push_back(firstVertex);
@@ -146,6 +163,15 @@ void TriangleSelectionStyle::OnLeftButtonDown(){
             case SelectionType::PAINTED_LINE:
                 break;
 
+            case SelectionType::FREEHAND_LASSO:
+
+                if(mesh == nullptr)
+                    break;
+                freehandStarted = true;
+                freehandLasso->clear();
+                addFreehandPoint();
+                return;
+
             default: break;
         }
 
@@ -165,75 +191,95 @@ void TriangleSelectionStyle::OnLeftButtonUp(){
                 // Forward events
 
                 vtkPlanes* frustum = static_cast<vtkRenderedAreaPicker*>(this->GetInteractor()->GetPicker())->GetFrustum();
-
-                vtkSmartPointer<vtkExtractGeometry> extractGeometry = vtkSmartPointer<vtkExtractGeometry>::New();
-                extractGeometry->SetImplicitFunction(static_cast<vtkImplicitFunction*>(frustum));
-
-                #if VTK_MAJOR_VERSION <= 5
-                    extractGeometry->SetInput(this->Triangles);
-                #else
-                    extractGeometry->SetInputData(this->triangles);
-                #endif
-                    extractGeometry->Update();
-
-                vtkSmartPointer<vtkVertexGlyphFilter> glyphFilter = vtkSmartPointer<vtkVertexGlyphFilter>::New();
-                glyphFilter->SetInputConnection(extractGeometry->GetOutputPort());
-                glyphFilter->Update();
-
-                vtkSmartPointer<vtkPolyData> selected;
-                if(visibleTrianglesOnly){
-                    vtkSmartPointer<vtkSelectVisiblePoints> selectVisiblePoints = vtkSmartPointer<vtkSelectVisiblePoints>::New();
-                    selectVisiblePoints->SetInputConnection(glyphFilter->GetOutputPort());
-                    selectVisiblePoints->SetRenderer(this->GetCurrentRenderer());
-                    selectVisiblePoints->Update();
-                    selected = selectVisiblePoints->GetOutput();
-                }else
-                    selected = glyphFilter->GetOutput();
-
-                vector<std::string> newlySelected;
-                vtkSmartPointer<vtkIdTypeArray> ids = vtkIdTypeArray::SafeDownCast(selected->GetPointData()->GetArray("OriginalMeshIds"));
-                for(vtkIdType i = 0; ids!=nullptr && i < ids->GetNumberOfTuples(); i++){
-                    vtkSmartPointer<vtkIdList> tids = vtkSmartPointer<vtkIdList>::New();
-                    triangles->GetPointCells(ids->GetValue(i), tids);
-                    for(vtkIdType j = 0; j < tids->GetNumberOfIds(); j++){
-                        newlySelected.push_back(std::to_string(static_cast<unsigned long>(tids->GetId(j))));
+                vtkSmartPointer<vtkPolyData> triangles = idDataset->getDataset();
+                if(triangles == nullptr)
+                    break;
+
+                //The points inside the frustum come from the tree of the dataset, the surface is not filtered
+                std::vector<vtkIdType> insidePoints = idDataset->selectPoints(frustum);
+                std::vector<char> inside(static_cast<size_t>(triangles->GetNumberOfPoints()), 0);
+                for(auto pid : insidePoints)
+                    inside[static_cast<size_t>(pid)] = 1;
+
+                //As before, the selection grows from the points of the triangles lying entirely inside the frustum
+                vtkSmartPointer<vtkIdList> tids = vtkSmartPointer<vtkIdList>::New();
+                vtkSmartPointer<vtkIdList> pids = vtkSmartPointer<vtkIdList>::New();
+                std::vector<vtkIdType> seeds;
+                for(auto pid : insidePoints)
+                {
+                    triangles->GetPointCells(pid, tids);
+                    bool seed = false;
+                    for(vtkIdType j = 0; !seed && j < tids->GetNumberOfIds(); j++)
+                    {
+                        triangles->GetCellPoints(tids->GetId(j), pids);
+                        seed = true;
+                        for(vtkIdType k = 0; seed && k < pids->GetNumberOfIds(); k++)
+                            seed = inside[static_cast<size_t>(pids->GetId(k))] != 0;
                     }
+                    if(seed)
+                        seeds.push_back(pid);
                 }
 
+                std::vector<vtkIdType> selectedIds;
+                for(auto pid : seeds)
+                {
+                    triangles->GetPointCells(pid, tids);
+                    for(vtkIdType j = 0; j < tids->GetNumberOfIds(); j++)
+                        selectedIds.push_back(tids->GetId(j));
+                }
+                std::sort(selectedIds.begin(), selectedIds.end());
+                selectedIds.erase(std::unique(selectedIds.begin(), selectedIds.end()), selectedIds.end());
+
+                //The id buffer only filters the selection: the triangles hidden from the camera are dropped
+                std::shared_ptr<IdBuffer> buffer = visibleTrianglesOnly ? idDataset->getIdBuffer(this->GetCurrentRenderer()) : nullptr;
+                vector<TriangleIndex> newlySelected;
+                newlySelected.reserve(selectedIds.size());
+                for(auto tid : selectedIds)
+                    if(buffer == nullptr || buffer->isTriangleVisible(tid))
+                        newlySelected.push_back(static_cast<TriangleIndex>(tid));
+
                 defineSelection(newlySelected);
 
             }
             break;
 
+        case SelectionType::FREEHAND_LASSO:
+            if(freehandStarted)
+                selectFreehand();
+            break;
+
+        default: break;
     }
 
 }
 
-void TriangleSelectionStyle::SetTriangles(vtkSmartPointer<vtkPolyData> triangles) {this->triangles = triangles;}
-
 void TriangleSelectionStyle::resetSelection(){
 
     if(mesh == nullptr) return;
-    for(uint i = 0; i < mesh->getTrianglesNumber(); i++){
-        auto t = mesh->getTriangle(i);
-        t->removeFlag(FlagType::SELECTED);
-        mesh->setTriangleColor(t->getId(), mesh->ORIGINAL_COLOR);
-    }
+    //Only the selected triangles are visited
+    for(auto id : selectedTriangles.getIds())
+        mesh->getTriangle(id)->removeFlag(FlagType::SELECTED);
+    selectedTriangles.clear();
+    palette->restoreAll();
+    palette->update();
 }
 
-void TriangleSelectionStyle::defineSelection(std::vector<string> selected){
+void TriangleSelectionStyle::defineSelection(const std::vector<TriangleIndex> &selected){
     if(mesh == nullptr) return;
-    for(auto it = selected.begin(); it != selected.end(); it++){
-        auto t = mesh->getTriangle(*it);
+    unsigned char red[3] = {255, 0, 0};
+    for(auto id : selected){
+        auto t = mesh->getTriangle(static_cast<unsigned long>(id));
         if(selectionMode)
         {
             t->addFlag(FlagType::SELECTED);
-            mesh->setTriangleColor(t->getId(), mesh->RED);
+            selectedTriangles.insert(id);
+            palette->highlight(static_cast<vtkIdType>(id), red);
         }
         else
         {
             t->removeFlag(FlagType::SELECTED);
-            mesh->setTriangleColor(t->getId(), mesh->ORIGINAL_COLOR);
+            selectedTriangles.erase(id);
+            palette->restore(static_cast<vtkIdType>(id));
         }
     }
 
@@ -281,25 +327,23 @@ void TriangleSelectionStyle::setAssembly(const vtkSmartPointer<vtkPropAssembly>
     assembly = value;
 }
 
-void TriangleSelectionStyle::finalizeAnnotation(std::string id, string tag, unsigned char color[]){
+void TriangleSelectionStyle::finalizeAnnotation(AnnotationIndex id, string tag, unsigned char color[]){
 
     if(mesh == nullptr) return;
-    vector<std::shared_ptr<SemantisedTriangleMesh::Triangle> > selectedTriangles;
-    for(uint i = 0; i < mesh->getTrianglesNumber(); i++){
-        auto t = mesh->getTriangle(i);
-        if(t->searchFlag(FlagType::SELECTED) >= 0)
-        {
-            t->removeFlag(FlagType::SELECTED);
-            selectedTriangles.push_back(t);
-            mesh->setTriangleColor(t->getId(), mesh->ORIGINAL_COLOR);
-        }
-
+    vector<std::shared_ptr<SemantisedTriangleMesh::Triangle> > annotatedTriangles;
+    for(auto triangleId : selectedTriangles.getIds()){
+        auto t = mesh->getTriangle(triangleId);
+        t->removeFlag(FlagType::SELECTED);
+        annotatedTriangles.push_back(t);
     }
+    selectedTriangles.clear();
+    palette->restoreAll();
+    palette->update();
 
-    if(selectedTriangles.size() > 0){
+    if(annotatedTriangles.size() > 0){
 
-        this->annotation->setId(id);
-        auto outlines = mesh->getOutlines(selectedTriangles);
+        this->annotation->setId(std::to_string(id));
+        auto outlines = mesh->getOutlines(annotatedTriangles);
         std::dynamic_pointer_cast<DrawableSurfaceAnnotation>(this->annotation)->setOutlines(outlines);
         this->annotation->setColor(color);
         this->annotation->setTag(tag);
@@ -317,8 +361,7 @@ void TriangleSelectionStyle::draw()
 {
     ren->RemoveActor(assembly);
     this->assembly->RemovePart(splineActor);
-    this->assembly->RemovePart(sphereAssembly);
-    this->assembly->RemovePart(mesh->getCanvas());
+    this->assembly->RemovePart(markers->getActor());
     if(selectionType == SelectionType::LASSO_AREA)
     {
 
@@ -326,10 +369,10 @@ void TriangleSelectionStyle::draw()
         auto polylinePoints = vtkSmartPointer<vtkPoints>::New();
         if(polygonContour.size() > 1)
         {
-            polylinePoints->InsertNextPoint(triangles->GetPoint(static_cast<vtkIdType>(std::stoi(polygonContour[0]->getId()))));
+            polylinePoints->InsertNextPoint(polygonContour[0]->getX(), polygonContour[0]->getY(), polygonContour[0]->getZ());
             for(unsigned int i = 1; i < polygonContour.size(); i++)
             {
-                polylinePoints->InsertNextPoint(triangles->GetPoint(static_cast<vtkIdType>(std::stoi(polygonContour[i]->getId()))));
+                polylinePoints->InsertNextPoint(polygonContour[i]->getX(), polygonContour[i]->getY(), polygonContour[i]->getZ());
                 vtkSmartPointer<vtkLine> line = vtkSmartPointer<vtkLine>::New();
                 line->GetPointIds()->SetNumberOfIds(2);
                 line->GetPointIds()->SetId(0, static_cast<vtkIdType>(i - 1));
@@ -345,15 +388,66 @@ void TriangleSelectionStyle::draw()
             splineActor->GetProperty()->SetLineWidth(5);
             this->assembly->AddPart(splineActor);
         }
-        this->assembly->AddPart(sphereAssembly);
-    } else
-        mesh->draw(assembly);
+        if(!markers->empty())
+            this->assembly->AddPart(markers->getActor());
+    }
+    //Selected triangles are palette indices of the surface: the mesh is not drawn again
+    palette->update();
 
     this->assembly->Modified();
     ren->AddActor(assembly);
-    ren->Render();
-    ren->GetRenderWindow()->Render();
-    this->qvtkWidget->update();
+    emit(updateView());
+}
+
+void TriangleSelectionStyle::addFreehandPoint()
+{
+    //The polygon is kept in the pixels of the viewport, where the lasso projects the mesh
+    int* position = this->Interactor->GetEventPosition();
+    int* origin = ren->GetOrigin();
+    freehandLasso->addPoint(position[0] - origin[0], position[1] - origin[1]);
+}
+
+void TriangleSelectionStyle::drawFreehandPath()
+{
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    auto lines = vtkSmartPointer<vtkCellArray>::New();
+    const std::vector<float> &polygon = freehandLasso->getPolygon();
+    unsigned int cornersNumber = freehandLasso->getPointsNumber();
+    //The path is drawn closed, as it will be selected
+    lines->InsertNextCell(static_cast<int>(cornersNumber > 2 ? cornersNumber + 1 : cornersNumber));
+    for(unsigned int i = 0; i < cornersNumber; i++)
+    {
+        points->InsertNextPoint(polygon[2 * i], polygon[2 * i + 1], 0);
+        lines->InsertCellPoint(static_cast<vtkIdType>(i));
+    }
+    if(cornersNumber > 2)
+        lines->InsertCellPoint(0);
+    auto path = vtkSmartPointer<vtkPolyData>::New();
+    path->SetPoints(points);
+    path->SetLines(lines);
+    static_cast<vtkPolyDataMapper2D*>(freehandActor->GetMapper())->SetInputData(path);
+    if(!ren->HasViewProp(freehandActor))
+        ren->AddActor2D(freehandActor);
+    //The path changes at every mouse move: the render is left to the scheduler, as for the selection
+    emit(updateView());
+}
+
+void TriangleSelectionStyle::selectFreehand()
+{
+    freehandStarted = false;
+    ren->RemoveActor2D(freehandActor);
+    vector<TriangleIndex> newlySelected;
+    vtkSmartPointer<vtkPolyData> triangles = idDataset->getDataset();
+    if(triangles != nullptr)
+    {
+        //The lasso goes through the occluded triangles too: the id buffer keeps the visible ones, as in the other modes
+        std::shared_ptr<IdBuffer> buffer = visibleTrianglesOnly ? idDataset->getIdBuffer(ren) : nullptr;
+        for(auto tid : freehandLasso->select(triangles, ren))
+            if(buffer == nullptr || buffer->isTriangleVisible(tid))
+                newlySelected.push_back(static_cast<TriangleIndex>(tid));
+    }
+    freehandLasso->clear();
+    defineSelection(newlySelected);
 }
 
 QVTKOpenGLNativeWidget *TriangleSelectionStyle::getQvtkWidget() const
@@ -393,11 +487,21 @@ const std::shared_ptr<DrawableTriangleMesh> &TriangleSelectionStyle::getMesh() c
 
 void TriangleSelectionStyle::setMesh(const std::shared_ptr<DrawableTriangleMesh> &newMesh)
 {
+    if(newMesh != mesh)
+    {
+        selectedTriangles.clear();
+        palette->clear();
+    }
     mesh = newMesh;
+    palette->setActor(mesh->getSurfaceActor());
     cellPicker = vtkSmartPointer<vtkCellPicker>::NewInstance(cellPicker);
     cellPicker->SetPickFromList(1);
     cellPicker->AddPickList(mesh->getSurfaceActor());
-    this->sphereRadius = this->mesh->getMinEdgeLength();
+    if(meshCache != nullptr)
+        this->sphereRadius = meshCache->getMinEdgeLength();
+    else
+        this->sphereRadius = this->mesh->getMinEdgeLength();
+    markers->setRadius(sphereRadius);
 }
 
 const std::vector<std::shared_ptr<SemantisedTriangleMesh::Vertex> > &TriangleSelectionStyle::getPolygonContour() const
@@ -410,6 +514,16 @@ void TriangleSelectionStyle::setPolygonContour(const std::vector<std::shared_ptr
     polygonContour = newPolygonContour;
 }
 
+const std::shared_ptr<MeshIdDataset> &TriangleSelectionStyle::getIdDataset() const
+{
+    return idDataset;
+}
+
+void TriangleSelectionStyle::setIdDataset(const std::shared_ptr<MeshIdDataset> &newIdDataset)
+{
+    idDataset = newIdDataset;
+}
+
 TriangleSelectionStyle::SelectionType TriangleSelectionStyle::getSelectionType() const
 {
     return selectionType;
@@ -419,3 +533,28 @@ void TriangleSelectionStyle::setSelectionType(TriangleSelectionStyle::SelectionT
 {
     selectionType = newSelectionType;
 }
+
+const std::shared_ptr<MeshSidecarCache> &TriangleSelectionStyle::getMeshCache() const
+{
+    return meshCache;
+}
+
+void TriangleSelectionStyle::setMeshCache(const std::shared_ptr<MeshSidecarCache> &newMeshCache)
+{
+    meshCache = newMeshCache;
+}
+
+const std::shared_ptr<CellPalette> &TriangleSelectionStyle::getPalette() const
+{
+    return palette;
+}
+
+void TriangleSelectionStyle::setPalette(const std::shared_ptr<CellPalette> &newPalette)
+{
+    palette = newPalette;
+}
+
+const std::shared_ptr<ScreenLasso> &TriangleSelectionStyle::getFreehandLasso() const
+{
+    return freehandLasso;
+}
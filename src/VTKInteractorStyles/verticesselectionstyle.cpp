@@ -1,20 +1,13 @@
 #include "vtkRenderer.h"
 #include <verticesselectionstyle.hpp>
 
-#include <vtkSphereSource.h>
 #include <vtkWorldPointPicker.h>
-#include <vtkIdFilter.h>
-#include <vtkVertexGlyphFilter.h>
 #include <vtkPointData.h>
 #include <vtkActor.h>
 #include <vtkRenderedAreaPicker.h>
-#include <vtkExtractGeometry.h>
-#include <vtkSelectVisiblePoints.h>
-#include <vtkImplicitFunction.h>
 #include <vtkPlanes.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
-#include <vtkIdFilter.h>
 #include <vtkRenderWindow.h>
 
 using namespace std;
@@ -28,7 +21,7 @@ VerticesSelectionStyle::VerticesSelectionStyle() {
     leftPressed = false;
     this->assembly = vtkSmartPointer<vtkPropAssembly>::New();
     this->pointPicker = vtkSmartPointer<vtkPointPicker>::New();
-    this->sphereAssembly = vtkSmartPointer<vtkPropAssembly>::New();
+    this->markers = std::make_shared<SelectionMarkers>();
     this->annotation = std::make_shared<DrawablePointAnnotation>();
 
 }
@@ -47,11 +40,11 @@ void VerticesSelectionStyle::OnRightButtonDown() {
     int picked = picker->Pick(x, y, 0, this->GetCurrentRenderer());
     picker->GetPickPosition(pickPos);
 
-    std::vector<std::shared_ptr<SemantisedTriangleMesh::Vertex> > selected;
+    std::vector<VertexIndex> selected;
     SemantisedTriangleMesh::Point pickedPos(pickPos[0], pickPos[1], pickPos[2]);
     if(picked >= 0)
     {
-        selected.push_back(mesh->getClosestPoint(pickedPos));
+        selected.push_back(meshCache != nullptr ? static_cast<VertexIndex>(meshCache->getClosestVertex(pickPos)) : toIndex(mesh->getClosestPoint(pickedPos)));
         defineSelection(selected);
         draw();
     }
@@ -83,40 +76,15 @@ void VerticesSelectionStyle::OnLeftButtonUp() {
 
 		vtkPlanes* frustum = static_cast<vtkRenderedAreaPicker*>(this->GetInteractor()->GetPicker())->GetFrustum();
 
-		vtkSmartPointer<vtkExtractGeometry> extractGeometry = vtkSmartPointer<vtkExtractGeometry>::New();
-        extractGeometry->SetImplicitFunction(static_cast<vtkImplicitFunction*>(frustum));
+        //The tree of the dataset returns the ids directly, no polydata is extracted
+        std::vector<vtkIdType> ids = idDataset->selectPoints(frustum);
+        if (visiblePointsOnly)
+            ids = idDataset->selectVisiblePoints(ids, this->GetCurrentRenderer());
 
-#if VTK_MAJOR_VERSION <= 5
-		extractGeometry->SetInput(this->Points);
-#else
-        extractGeometry->SetInputData(this->points);
-#endif
-		extractGeometry->Update();
-
-		vtkSmartPointer<vtkVertexGlyphFilter> glyphFilter = vtkSmartPointer<vtkVertexGlyphFilter>::New();
-		glyphFilter->SetInputConnection(extractGeometry->GetOutputPort());
-		glyphFilter->Update();
-
-        vtkSmartPointer<vtkPolyData> selected;
-		if (visiblePointsOnly) {
-			vtkSmartPointer<vtkSelectVisiblePoints> selectVisiblePoints = vtkSmartPointer<vtkSelectVisiblePoints>::New();
-			selectVisiblePoints->SetInputConnection(glyphFilter->GetOutputPort());
-			selectVisiblePoints->SetRenderer(this->GetCurrentRenderer());
-			selectVisiblePoints->Update();
-			selected = selectVisiblePoints->GetOutput();
-		}
-		else
-			selected = glyphFilter->GetOutput();
-
-
-		vtkSmartPointer<vtkIdTypeArray> ids = vtkIdTypeArray::SafeDownCast(selected->GetPointData()->GetArray("OriginalMeshIds"));
-
-		if (ids == nullptr)
-			return;
-
-        std::vector<std::shared_ptr<Vertex> > selectedPoints;
-		for (vtkIdType i = 0; i < ids->GetNumberOfTuples(); i++)
-            selectedPoints.push_back(mesh->getVertex(ids->GetValue(i)));
+        std::vector<VertexIndex> selectedPoints;
+        selectedPoints.reserve(ids.size());
+        for (auto id : ids)
+            selectedPoints.push_back(static_cast<VertexIndex>(id));
 
         defineSelection(selectedPoints);
         draw();
@@ -133,74 +101,60 @@ void VerticesSelectionStyle::resetSelection() {
 
     if(mesh == nullptr) return;
 
-    this->assembly->RemovePart(sphereAssembly);
-    this->sphereAssembly = vtkSmartPointer<vtkPropAssembly>::New();
+    this->assembly->RemovePart(markers->getActor());
+    this->markers->clear();
 
-    for (uint i = 0; i < mesh->getVerticesNumber(); i++) {
-        auto v = mesh->getVertex(i);
-        v->removeFlag(FlagType::SELECTED);
-    }
+    //Only the selected vertices are visited
+    for (auto id : selectedVertices.getIds())
+        mesh->getVertex(id)->removeFlag(FlagType::SELECTED);
+    selectedVertices.clear();
 
     emit(updateView());
 }
 
 
-void VerticesSelectionStyle::defineSelection(std::vector<std::shared_ptr<Vertex> > selected) {
+void VerticesSelectionStyle::defineSelection(const std::vector<VertexIndex> &selected) {
     if(mesh == nullptr) return;
-    for (auto v : selected)
-        if(selectionMode)
+    for (auto id : selected)
+        if(selectionMode && selectedVertices.insert(id))
+        {
+            auto v = mesh->getVertex(static_cast<unsigned long>(id));
             v->addFlag(FlagType::SELECTED);
+            double point[3] = {v->getX(), v->getY(), v->getZ()};
+            markers->addPoint(static_cast<long>(id), point);
+        }
+}
+
+void VerticesSelectionStyle::defineSelection(const std::vector<std::shared_ptr<Vertex> > &selected) {
+    defineSelection(toIndices(selected));
 }
 
 void VerticesSelectionStyle::draw() {
 
     if(mesh == nullptr) return;
     ren->RemoveActor(this->assembly);
-    assembly->RemovePart(sphereAssembly);
-    this->sphereAssembly = vtkSmartPointer<vtkPropAssembly>::New();
-    bool thereAreSelected = false;
-
-    for (unsigned long i = 0; i < static_cast<unsigned long>(mesh->getVerticesNumber()); i++)
-        if (mesh->getVertex(i)->searchFlag(FlagType::SELECTED) >= 0)
-        {
-            vtkSmartPointer<vtkSphereSource> sphereSource = vtkSmartPointer<vtkSphereSource>::New();
-            auto p = mesh->getVertex(i);
-            p->addFlag(FlagType::SELECTED);
-            sphereSource->SetCenter(p->getX(), p->getY(), p->getZ());
-            sphereSource->SetRadius(sphereRadius);
-            vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-            mapper->SetInputConnection(sphereSource->GetOutputPort());
-            vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-            actor->GetProperty()->SetColor(0,0,1);
-            actor->SetMapper(mapper);
-            sphereAssembly->AddPart(actor);
-            thereAreSelected = true;
-        }
-
-    if(thereAreSelected)
-        assembly->AddPart(sphereAssembly);
+    //The markers are kept up to date by defineSelection: the selected vertices are not searched here
+    assembly->RemovePart(markers->getActor());
+    if(!markers->empty())
+        assembly->AddPart(markers->getActor());
 
     this->assembly->Modified();
     ren->AddActor(this->assembly);
-    ren->Render();
-    ren->GetRenderWindow()->Render();
-    this->qvtkwidget->update();
+    emit(updateView());
 
 }
 
-void VerticesSelectionStyle::finalizeAnnotation(std::string id, string tag, unsigned char color[])
+void VerticesSelectionStyle::finalizeAnnotation(AnnotationIndex id, string tag, unsigned char color[])
 {
     if(mesh == nullptr) return;
     vector<std::shared_ptr<SemantisedTriangleMesh::Vertex> > selectedPoints;
-    for(uint i = 0; i < mesh->getVerticesNumber(); i++){
-        auto v = mesh->getVertex(i);
-        if(v->searchFlag(FlagType::SELECTED) >= 0)
-            selectedPoints.push_back(v);
-    }
+    selectedPoints.reserve(selectedVertices.size());
+    for(auto vid : selectedVertices.getIds())
+        selectedPoints.push_back(mesh->getVertex(vid));
 
     if(selectedPoints.size() > 0){
 
-        this->annotation->setId(id);
+        this->annotation->setId(std::to_string(id));
         this->annotation->setTag(tag);
         this->annotation->setColor(color);
         this->annotation->setPoints(selectedPoints);
@@ -212,14 +166,14 @@ void VerticesSelectionStyle::finalizeAnnotation(std::string id, string tag, unsi
     }
 }
 
-vtkSmartPointer<vtkPolyData> VerticesSelectionStyle::getPoints() const
+const std::shared_ptr<MeshIdDataset> &VerticesSelectionStyle::getIdDataset() const
 {
-    return points;
+    return idDataset;
 }
 
-void VerticesSelectionStyle::setPoints(const vtkSmartPointer<vtkPolyData>& value)
+void VerticesSelectionStyle::setIdDataset(const std::shared_ptr<MeshIdDataset> &newIdDataset)
 {
-    points = value;
+    idDataset = newIdDataset;
 }
 
 
@@ -280,14 +234,18 @@ const std::shared_ptr<DrawableTriangleMesh> &VerticesSelectionStyle::getMesh() c
 
 void VerticesSelectionStyle::setMesh(const std::shared_ptr<DrawableTriangleMesh> &newMesh)
 {
+    //The ids of the selection belong to the previous mesh
+    if(newMesh != mesh)
+    {
+        markers->clear();
+        selectedVertices.clear();
+    }
     mesh = newMesh;
-    vtkSmartPointer<vtkIdFilter> idFilterMesh = vtkSmartPointer<vtkIdFilter>::New();
-    idFilterMesh->SetInputData(mesh->getPointsActor()->GetMapper()->GetInputAsDataSet());
-    idFilterMesh->PointIdsOn();
-    idFilterMesh->SetPointIdsArrayName("OriginalMeshIds");
-    idFilterMesh->Update();
-    vtkSmartPointer<vtkPolyData> inputMesh = static_cast<vtkPolyData*>(idFilterMesh->GetOutput());
-    this->sphereRadius = this->mesh->getAABBDiagonalLength() / RADIUS_RATIO;
+    if(meshCache != nullptr)
+        this->sphereRadius = meshCache->getAABBDiagonalLength() / RADIUS_RATIO;
+    else
+        this->sphereRadius = this->mesh->getAABBDiagonalLength() / RADIUS_RATIO;
+    markers->setRadius(sphereRadius);
 }
 
 vtkSmartPointer<vtkRenderer> VerticesSelectionStyle::getRenderer() const
@@ -300,3 +258,13 @@ void VerticesSelectionStyle::setRenderer(vtkSmartPointer<vtkRenderer> newRen)
     ren = newRen;
 }
 
+const std::shared_ptr<MeshSidecarCache> &VerticesSelectionStyle::getMeshCache() const
+{
+    return meshCache;
+}
+
+void VerticesSelectionStyle::setMeshCache(const std::shared_ptr<MeshSidecarCache> &newMeshCache)
+{
+    meshCache = newMeshCache;
+}
+
@@ -0,0 +1,457 @@
+#include "annotationjournal.hpp"
+#include "mappedfile.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace SemantisedTriangleMesh;
+using namespace Drawables;
+
+static const char MAGIC[8] = {'B', 'A', 'N', 'T', 'J', 'R', 'N', 'L'};
+static const uint32_t VERSION = 1;
+static const uint64_t HEADER_SIZE = sizeof(MAGIC) + sizeof(uint32_t);
+static const uint64_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+AnnotationJournal::AnnotationJournal()
+{
+    journal = nullptr;
+    journalSize = 0;
+    compacting = false;
+}
+
+AnnotationJournal::~AnnotationJournal()
+{
+    detach();
+}
+
+bool AnnotationJournal::attach(const std::string &mainFilename, const std::shared_ptr<DrawableTriangleMesh> &mesh, bool keepExisting)
+{
+    detach();
+    this->mainFilename = mainFilename;
+    this->journalFilename = mainFilename + ".journal";
+    this->mesh = mesh;
+    std::lock_guard<std::mutex> lock(journalMutex);
+    return openJournal(!keepExisting);
+}
+
+void AnnotationJournal::detach()
+{
+    if(compaction.joinable())
+        compaction.join();
+    std::lock_guard<std::mutex> lock(journalMutex);
+    closeJournal();
+    mesh = nullptr;
+}
+
+bool AnnotationJournal::isAttached() const
+{
+    std::lock_guard<std::mutex> lock(journalMutex);
+    return journal != nullptr;
+}
+
+bool AnnotationJournal::recordAnnotation(const std::shared_ptr<Annotation> &annotation)
+{
+    if(annotation == nullptr || !isAttached())
+        return false;
+    BinaryAnnotationFileManager manager;
+    manager.setMesh(mesh);
+    BinaryWriter writer;
+    manager.encodeAnnotations(std::vector<std::shared_ptr<Annotation> >(1, annotation), writer);
+    return append(RecordType::ANNOTATION, writer.getBuffer());
+}
+
+bool AnnotationJournal::recordAnnotationRemoval(const std::string &id)
+{
+    if(!isAttached())
+        return false;
+    BinaryWriter writer;
+    writer.writeVarUInt(std::stoul(id));
+    return append(RecordType::ANNOTATION_REMOVAL, writer.getBuffer());
+}
+
+bool AnnotationJournal::recordRelationship(const BinaryAnnotationFileManager::RelationshipRecord &relationship)
+{
+    if(!isAttached())
+        return false;
+    BinaryWriter writer;
+    BinaryAnnotationFileManager::encodeRelationship(relationship, writer);
+    return append(RecordType::RELATIONSHIP, writer.getBuffer());
+}
+
+void AnnotationJournal::replay(std::vector<BinaryAnnotationFileManager::RelationshipRecord> &relationships)
+{
+    std::vector<Record> records;
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        if(journal == nullptr)
+            return;
+        fflush(journal);
+        records = readRecords(journalFilename, journalSize);
+    }
+
+    BinaryAnnotationFileManager manager;
+    manager.setMesh(mesh);
+    std::set<std::string> ids;
+    for(auto annotation : mesh->getAnnotations())
+        ids.insert(annotation->getId());
+
+    for(auto record : records)
+    {
+        BinaryReader reader(record.payload.data(), record.payload.size());
+        switch(record.type)
+        {
+            case RecordType::ANNOTATION:
+            {
+                for(auto annotation : manager.decodeAnnotations(reader))
+                {
+                    if(ids.find(annotation->getId()) != ids.end())
+                        mesh->removeAnnotation(annotation->getId());
+                    mesh->addAnnotation(annotation);
+                    ids.insert(annotation->getId());
+                }
+                break;
+            }
+            case RecordType::ANNOTATION_REMOVAL:
+            {
+                std::string id = std::to_string(reader.readVarUInt());
+                if(ids.find(id) != ids.end())
+                {
+                    mesh->removeAnnotation(id);
+                    ids.erase(id);
+                }
+                break;
+            }
+            case RecordType::RELATIONSHIP:
+            {
+                putRelationship(relationships, BinaryAnnotationFileManager::decodeRelationship(reader));
+                break;
+            }
+        }
+    }
+}
+
+void AnnotationJournal::compact()
+{
+    if(compacting.exchange(true))
+        return;
+    if(compaction.joinable())
+        compaction.join();
+
+    uint64_t compactedSize;
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        if(journal != nullptr)
+            fflush(journal);
+        compactedSize = journalSize;
+        if(journal == nullptr || compactedSize <= HEADER_SIZE)
+        {
+            compacting = false;
+            return;
+        }
+    }
+    compaction = std::thread(&AnnotationJournal::runCompaction, this, compactedSize);
+}
+
+bool AnnotationJournal::isCompacting() const
+{
+    return compacting;
+}
+
+const std::string &AnnotationJournal::getMainFilename() const
+{
+    return mainFilename;
+}
+
+const std::string &AnnotationJournal::getJournalFilename() const
+{
+    return journalFilename;
+}
+
+bool AnnotationJournal::append(RecordType type, const std::string &payload)
+{
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        if(journal == nullptr)
+            return false;
+
+        std::string content;
+        content.reserve(payload.size() + 1);
+        content.push_back(static_cast<char>(type));
+        content.append(payload);
+        BinaryWriter writer;
+        writer.writeUInt32(static_cast<uint32_t>(content.size()));
+        writer.writeUInt32(checksum(content));
+        writer.writeBytes(content.data(), content.size());
+
+        const std::string &buffer = writer.getBuffer();
+        if(fwrite(buffer.data(), 1, buffer.size(), journal) != buffer.size() || fflush(journal) != 0)
+        {
+            std::cout << "Unable to write the annotation journal " << journalFilename << std::endl << std::flush;
+            return false;
+        }
+        fdatasync(fileno(journal));
+        journalSize += buffer.size();
+        full = journalSize > COMPACTION_THRESHOLD;
+    }
+    if(full)
+        compact();
+    return true;
+}
+
+bool AnnotationJournal::openJournal(bool truncate)
+{
+    uint64_t validSize = 0;
+    if(!truncate)
+        readRecords(journalFilename, UINT64_MAX, &validSize);
+
+    if(validSize < HEADER_SIZE)
+    {
+        //Missing, obsolete or damaged beyond the header: start a new one
+        journal = fopen(journalFilename.c_str(), "wb");
+        if(journal == nullptr)
+            return false;
+        BinaryWriter writer;
+        writer.writeBytes(MAGIC, sizeof(MAGIC));
+        writer.writeUInt32(VERSION);
+        fwrite(writer.getBuffer().data(), 1, writer.getBuffer().size(), journal);
+        fflush(journal);
+        journalSize = HEADER_SIZE;
+        return true;
+    }
+
+    //Drop what a crash may have left after the last complete record, or new records would follow garbage
+    if(::truncate(journalFilename.c_str(), static_cast<off_t>(validSize)) != 0)
+        return false;
+    journal = fopen(journalFilename.c_str(), "ab");
+    if(journal == nullptr)
+        return false;
+    journalSize = validSize;
+    return true;
+}
+
+void AnnotationJournal::closeJournal()
+{
+    if(journal != nullptr)
+    {
+        fclose(journal);
+        journal = nullptr;
+    }
+    journalSize = 0;
+}
+
+void AnnotationJournal::runCompaction(uint64_t compactedSize)
+{
+    //Only records are handled here, the mesh belongs to the GUI thread: the last journaled state of each id is
+    //either a record replacing the annotation or its removal (nullptr)
+    BinaryAnnotationFileManager manager;
+    std::vector<BinaryAnnotationFileManager::RelationshipRecord> journaledRelationships;
+    std::map<uint32_t, std::shared_ptr<BinaryAnnotationFileManager::AnnotationRecord> > journaled;
+    std::vector<uint32_t> journaledOrder;
+    for(auto record : readRecords(journalFilename, compactedSize))
+    {
+        BinaryReader reader(record.payload.data(), record.payload.size());
+        switch(record.type)
+        {
+            case RecordType::ANNOTATION:
+            {
+                std::vector<BinaryAnnotationFileManager::AnnotationRecord> annotations;
+                manager.decodeRecords(reader, annotations);
+                for(auto &annotation : annotations)
+                {
+                    if(journaled.find(annotation.id) == journaled.end())
+                        journaledOrder.push_back(annotation.id);
+                    journaled[annotation.id] = std::make_shared<BinaryAnnotationFileManager::AnnotationRecord>(annotation);
+                }
+                break;
+            }
+            case RecordType::ANNOTATION_REMOVAL:
+            {
+                uint32_t id = static_cast<uint32_t>(reader.readVarUInt());
+                if(journaled.find(id) == journaled.end())
+                    journaledOrder.push_back(id);
+                journaled[id] = nullptr;
+                break;
+            }
+            case RecordType::RELATIONSHIP:
+            {
+                putRelationship(journaledRelationships, BinaryAnnotationFileManager::decodeRelationship(reader));
+                break;
+            }
+        }
+    }
+
+    //The chunks of the main file without journaled annotations are copied as they are, as long as the annotations
+    //before them did not change in number (their attributes refer to annotation positions); the others are encoded
+    //again from their records
+    BinaryWriter sections;
+    size_t inputIndex = 0, outputIndex = 0;
+    std::vector<BinaryAnnotationFileManager::RelationshipRecord> relationships;
+    if(access(mainFilename.c_str(), F_OK) == 0)
+    {
+        if(manager.open(mainFilename))
+            while(manager.hasNextChunk())
+            {
+                std::string chunkSections;
+                auto chunk = manager.readNextRecords(&chunkSections);
+                bool touched = false;
+                for(auto &annotation : chunk)
+                    touched = touched || journaled.find(annotation.id) != journaled.end();
+                bool shifted = inputIndex != outputIndex;
+                inputIndex += chunk.size();
+                if(!touched && !shifted)
+                {
+                    sections.writeBytes(chunkSections.data(), chunkSections.size());
+                    outputIndex += chunk.size();
+                } else
+                {
+                    std::vector<BinaryAnnotationFileManager::AnnotationRecord> kept;
+                    for(auto &annotation : chunk)
+                    {
+                        auto it = journaled.find(annotation.id);
+                        if(it == journaled.end())
+                            kept.push_back(annotation);
+                        else
+                        {
+                            if(it->second != nullptr)
+                                kept.push_back(*it->second);
+                            journaled.erase(it);
+                        }
+                    }
+                    manager.encodeRecords(kept, outputIndex, sections);
+                    outputIndex += kept.size();
+                }
+            }
+        if(!manager.getError().empty())
+        {
+            //Never replace a main file that could not be read: the journal keeps the changes
+            std::cout << "Journal compaction skipped: " << manager.getError() << std::endl << std::flush;
+            compacting = false;
+            return;
+        }
+        relationships = manager.getRelationships();
+    }
+
+    //Annotations added since the main file was written go after the others
+    std::vector<BinaryAnnotationFileManager::AnnotationRecord> added;
+    for(auto id : journaledOrder)
+    {
+        auto it = journaled.find(id);
+        if(it != journaled.end() && it->second != nullptr)
+            added.push_back(*it->second);
+    }
+    manager.encodeRecords(added, outputIndex, sections);
+    for(auto &relationship : journaledRelationships)
+        putRelationship(relationships, relationship);
+
+    //Both files are replaced by renaming complete copies: a crash leaves either the old or the new version
+    std::string temporaryMain = mainFilename + ".compacting";
+    manager.setRelationships(relationships);
+    if(!manager.writeSections(temporaryMain, sections.getBuffer()) || rename(temporaryMain.c_str(), mainFilename.c_str()) != 0)
+    {
+        std::cout << "Journal compaction failed: unable to write " << mainFilename << std::endl << std::flush;
+        compacting = false;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        if(journal != nullptr)
+        {
+            //Keep the records appended while compacting
+            fflush(journal);
+            std::string tail;
+            auto file = MappedFile::open(journalFilename);
+            if(file != nullptr && file->getSize() > compactedSize)
+                tail.assign(file->getData() + compactedSize, file->getSize() - compactedSize);
+            file.reset();
+
+            std::string temporaryJournal = journalFilename + ".compacting";
+            FILE* rewritten = fopen(temporaryJournal.c_str(), "wb");
+            if(rewritten != nullptr)
+            {
+                BinaryWriter writer;
+                writer.writeBytes(MAGIC, sizeof(MAGIC));
+                writer.writeUInt32(VERSION);
+                writer.writeBytes(tail.data(), tail.size());
+                bool written = fwrite(writer.getBuffer().data(), 1, writer.getBuffer().size(), rewritten) == writer.getBuffer().size();
+                written = fflush(rewritten) == 0 && written;
+                fdatasync(fileno(rewritten));
+                fclose(rewritten);
+                if(written && rename(temporaryJournal.c_str(), journalFilename.c_str()) == 0)
+                {
+                    fclose(journal);
+                    journal = fopen(journalFilename.c_str(), "ab");
+                    journalSize = HEADER_SIZE + tail.size();
+                }
+            }
+        }
+    }
+    compacting = false;
+}
+
+void AnnotationJournal::putRelationship(std::vector<BinaryAnnotationFileManager::RelationshipRecord> &relationships, const BinaryAnnotationFileManager::RelationshipRecord &relationship)
+{
+    auto it = std::find_if(relationships.begin(), relationships.end(),
+                           [&relationship](const BinaryAnnotationFileManager::RelationshipRecord &r){ return r.id == relationship.id; });
+    if(it != relationships.end())
+        *it = relationship;
+    else
+        relationships.push_back(relationship);
+}
+
+std::vector<AnnotationJournal::Record> AnnotationJournal::readRecords(const std::string &filename, uint64_t to, uint64_t *validSize)
+{
+    std::vector<Record> records;
+    if(validSize != nullptr)
+        *validSize = 0;
+    auto file = MappedFile::open(filename);
+    if(file == nullptr || file->getSize() < HEADER_SIZE || memcmp(file->getData(), MAGIC, sizeof(MAGIC)) != 0)
+        return records;
+
+    uint64_t end = std::min<uint64_t>(to, file->getSize());
+    BinaryReader reader(file->getData(), end);
+    reader.readBytes(sizeof(MAGIC));
+    if(reader.readUInt32() > VERSION)
+        return records;
+    uint64_t valid = HEADER_SIZE;
+
+    while(end - reader.getPosition() >= RECORD_HEADER_SIZE)
+    {
+        uint32_t length = reader.readUInt32();
+        uint32_t sum = reader.readUInt32();
+        const char* content = reader.readBytes(length);
+        //A truncated or damaged record ends the journal
+        if(content == nullptr || length == 0)
+            break;
+        std::string payload(content, length);
+        if(checksum(payload) != sum)
+            break;
+        Record record;
+        record.type = static_cast<RecordType>(payload[0]);
+        record.payload = payload.substr(1);
+        records.push_back(record);
+        valid = reader.getPosition();
+    }
+    if(validSize != nullptr)
+        *validSize = valid;
+    return records;
+}
+
+uint32_t AnnotationJournal::checksum(const std::string &payload)
+{
+    //FNV-1a
+    uint32_t hash = 2166136261u;
+    for(auto c : payload)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,109 @@
+#include "annotationloader.hpp"
+
+#include <exception>
+
+using namespace std;
+using namespace Drawables;
+
+AnnotationLoader::AnnotationLoader(QObject *parent) : QThread(parent)
+{
+}
+
+AnnotationLoader::~AnnotationLoader()
+{
+    cancel();
+    wait();
+}
+
+void AnnotationLoader::load(const std::string &filename, const std::shared_ptr<DrawableTriangleMesh> &mesh)
+{
+    if(isRunning())
+        return;
+    this->filename = filename;
+    this->mesh = mesh;
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        batch.clear();
+        relationships.clear();
+    }
+    start();
+}
+
+void AnnotationLoader::cancel()
+{
+    requestInterruption();
+}
+
+bool AnnotationLoader::getCanceled() const
+{
+    return isInterruptionRequested();
+}
+
+std::vector<BinaryAnnotationFileManager::RelationshipRecord> AnnotationLoader::takeRelationships()
+{
+    std::lock_guard<std::mutex> lock(batchMutex);
+    std::vector<BinaryAnnotationFileManager::RelationshipRecord> taken;
+    taken.swap(relationships);
+    return taken;
+}
+
+std::vector<BinaryAnnotationFileManager::AnnotationRecord> AnnotationLoader::takeBatch()
+{
+    std::lock_guard<std::mutex> lock(batchMutex);
+    std::vector<BinaryAnnotationFileManager::AnnotationRecord> taken;
+    taken.swap(batch);
+    return taken;
+}
+
+const std::string &AnnotationLoader::getFilename() const
+{
+    return filename;
+}
+
+std::shared_ptr<DrawableTriangleMesh> AnnotationLoader::getMesh() const
+{
+    return mesh;
+}
+
+void AnnotationLoader::run()
+{
+    emit(progressChanged(0));
+    try
+    {
+        BinaryAnnotationFileManager manager;
+        if(!manager.open(filename))
+        {
+            emit(loadingFailed(QString::fromStdString(manager.getError())));
+            return;
+        }
+
+        size_t batchSize = FIRST_BATCH_SIZE;
+        std::vector<BinaryAnnotationFileManager::AnnotationRecord> pending;
+        while(manager.hasNextChunk() && !isInterruptionRequested())
+        {
+            auto chunk = manager.readNextRecords();
+            if(!manager.getError().empty())
+            {
+                emit(loadingFailed(QString::fromStdString(manager.getError())));
+                return;
+            }
+            pending.insert(pending.end(), chunk.begin(), chunk.end());
+            if(pending.size() >= batchSize || !manager.hasNextChunk())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(batchMutex);
+                    batch.insert(batch.end(), pending.begin(), pending.end());
+                }
+                pending.clear();
+                batchSize *= 2;
+                emit(progressChanged(manager.getProgress()));
+                emit(batchLoaded());
+            }
+        }
+        std::lock_guard<std::mutex> lock(batchMutex);
+        relationships = manager.getRelationships();
+    } catch(const std::exception &e)
+    {
+        emit(loadingFailed(QString::fromStdString(e.what())));
+    }
+}
@@ -0,0 +1,201 @@
+#include "annotationoutlinelayer.hpp"
+#include "meshindex.hpp"
+
+#include <drawablelineannotation.hpp>
+#include <drawablesurfaceannotation.hpp>
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkPoints.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkProperty.h>
+#include <vtkTypeUInt32Array.h>
+
+#include <algorithm>
+
+using namespace std;
+using namespace SemantisedTriangleMesh;
+using namespace Drawables;
+
+AnnotationOutlineLayer::AnnotationOutlineLayer()
+{
+    outlines = vtkSmartPointer<vtkPolyData>::New();
+    auto mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    mapper->SetInputData(outlines);
+    mapper->SetScalarModeToUseCellData();
+    mapper->SetColorModeToDirectScalars();
+    actor = vtkSmartPointer<vtkActor>::New();
+    actor->SetMapper(mapper);
+    actor->GetProperty()->SetLineWidth(3);
+    actor->GetProperty()->LightingOff();
+    actor->PickableOff();
+    selectionColor[0] = 255;
+    selectionColor[1] = 255;
+    selectionColor[2] = 0;
+    geometryDirty = false;
+    viewDirty = false;
+}
+
+bool AnnotationOutlineLayer::isLayered(const std::shared_ptr<Annotation> &annotation)
+{
+    return dynamic_pointer_cast<DrawableSurfaceAnnotation>(annotation) != nullptr ||
+           dynamic_pointer_cast<DrawableLineAnnotation>(annotation) != nullptr;
+}
+
+void AnnotationOutlineLayer::add(const std::shared_ptr<DrawableAnnotation> &annotation)
+{
+    if(annotation == nullptr || ranges.find(annotation.get()) != ranges.end())
+        return;
+    Range range;
+    range.annotation = annotation;
+    range.begin = range.end = 0;
+    ranges.insert(std::make_pair(annotation.get(), range));
+    order.push_back(annotation.get());
+    geometryDirty = true;
+}
+
+void AnnotationOutlineLayer::remove(Annotation *annotation)
+{
+    if(ranges.erase(annotation) == 0)
+        return;
+    order.erase(std::remove(order.begin(), order.end(), annotation), order.end());
+    geometryDirty = true;
+}
+
+void AnnotationOutlineLayer::markGeometryDirty(Annotation *annotation)
+{
+    if(ranges.find(annotation) != ranges.end())
+        geometryDirty = true;
+}
+
+void AnnotationOutlineLayer::updateView(Annotation *annotation)
+{
+    auto it = ranges.find(annotation);
+    //A packing is pending: it writes the view of every annotation anyway
+    if(it == ranges.end() || geometryDirty)
+        return;
+    writeView(it->second);
+    viewDirty = true;
+}
+
+void AnnotationOutlineLayer::clear()
+{
+    ranges.clear();
+    order.clear();
+    outlines->Initialize();
+    colors = nullptr;
+    mask = nullptr;
+    geometryDirty = false;
+    viewDirty = false;
+}
+
+void AnnotationOutlineLayer::update()
+{
+    if(geometryDirty)
+        pack();
+    else if(viewDirty)
+    {
+        colors->Modified();
+        mask->Modified();
+        outlines->Modified();
+    }
+    geometryDirty = false;
+    viewDirty = false;
+    actor->SetVisibility(outlines->GetNumberOfCells() > 0);
+}
+
+vtkSmartPointer<vtkActor> AnnotationOutlineLayer::getActor() const
+{
+    return actor;
+}
+
+size_t AnnotationOutlineLayer::getAnnotationsNumber() const
+{
+    return ranges.size();
+}
+
+const unsigned char *AnnotationOutlineLayer::getSelectionColor() const
+{
+    return selectionColor;
+}
+
+void AnnotationOutlineLayer::setSelectionColor(const unsigned char newSelectionColor[3])
+{
+    std::copy(newSelectionColor, newSelectionColor + 3, selectionColor);
+    for(auto &range : ranges)
+        if(range.second.annotation->getSelected())
+            updateView(range.first);
+}
+
+void AnnotationOutlineLayer::pack()
+{
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    auto lines = vtkSmartPointer<vtkCellArray>::New();
+    auto ids = vtkSmartPointer<vtkTypeUInt32Array>::New();
+    ids->SetName(IDS_ARRAY_NAME);
+
+    for(auto annotationPointer : order)
+    {
+        Range &range = ranges.at(annotationPointer);
+        std::vector<std::vector<std::shared_ptr<Vertex> > > polylines;
+        bool closed = false;
+        auto surfaceAnnotation = dynamic_pointer_cast<DrawableSurfaceAnnotation>(range.annotation);
+        if(surfaceAnnotation != nullptr)
+        {
+            polylines = surfaceAnnotation->getOutlines();
+            closed = true;
+        } else
+        {
+            auto lineAnnotation = dynamic_pointer_cast<DrawableLineAnnotation>(range.annotation);
+            if(lineAnnotation != nullptr)
+                polylines = lineAnnotation->getPolyLines();
+        }
+
+        AnnotationIndex id = toIndex(range.annotation->getId());
+        range.begin = lines->GetNumberOfCells();
+        for(auto &polyline : polylines)
+        {
+            if(polyline.size() < 2)
+                continue;
+            //Outlines are closed loops, which do not necessarily repeat their first vertex
+            bool closing = closed && polyline.front() != polyline.back();
+            vtkIdType first = points->GetNumberOfPoints();
+            lines->InsertNextCell(static_cast<vtkIdType>(polyline.size() + (closing ? 1 : 0)));
+            for(auto &v : polyline)
+                lines->InsertCellPoint(points->InsertNextPoint(v->getX(), v->getY(), v->getZ()));
+            if(closing)
+                lines->InsertCellPoint(first);
+            ids->InsertNextValue(id);
+        }
+        range.end = lines->GetNumberOfCells();
+    }
+
+    outlines->Initialize();
+    outlines->SetPoints(points);
+    outlines->SetLines(lines);
+    colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    colors->SetName(COLORS_ARRAY_NAME);
+    colors->SetNumberOfComponents(3);
+    colors->SetNumberOfTuples(lines->GetNumberOfCells());
+    mask = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    mask->SetName(vtkDataSetAttributes::GhostArrayName());
+    mask->SetNumberOfTuples(lines->GetNumberOfCells());
+    for(auto &range : ranges)
+        writeView(range.second);
+    outlines->GetCellData()->AddArray(ids);
+    outlines->GetCellData()->SetScalars(colors);
+    outlines->GetCellData()->AddArray(mask);
+    outlines->Modified();
+}
+
+void AnnotationOutlineLayer::writeView(const Range &range)
+{
+    unsigned char* color = range.annotation->getSelected() ? selectionColor : range.annotation->getColor();
+    unsigned char hidden = range.annotation->getDrawAnnotation() ? 0 : static_cast<unsigned char>(vtkDataSetAttributes::HIDDENCELL);
+    for(vtkIdType cell = range.begin; cell < range.end; cell++)
+    {
+        colors->SetTypedTuple(cell, color);
+        mask->SetValue(cell, hidden);
+    }
+}
@@ -21,6 +21,9 @@ AttributeWidget::AttributeWidget(QWidget *parent):
     this->setIndentation(0);
 
     this->setHeaderHidden(true);
+    textSettleTimer.setSingleShot(true);
+    textSettleTimer.setInterval(TEXT_SETTLE_TIME);
+    connect(&textSettleTimer, SIGNAL(timeout()), this, SLOT(textSettled()));
 }
 
 AttributeWidget::~AttributeWidget()
@@ -30,7 +33,14 @@ AttributeWidget::~AttributeWidget()
 
 void AttributeWidget::update()
 {
+    //Text still settling belongs to the widgets about to be deleted
+    if(textSettleTimer.isActive())
+    {
+        textSettleTimer.stop();
+        textSettled();
+    }
     this->clear();
+    textEditAttributeMap.clear();
 
     for(unsigned int i = 0; i < annotation->getAttributes().size(); i++)
     {
@@ -78,6 +88,11 @@ std::shared_ptr<Annotation> AttributeWidget::getAnnotation() const
 
 void AttributeWidget::setAnnotation(std::shared_ptr<Annotation> value)
 {
+    if(textSettleTimer.isActive())
+    {
+        textSettleTimer.stop();
+        textSettled();
+    }
     annotation = value;
 }
 
@@ -88,6 +103,7 @@ void AttributeWidget::measureButtonClickedSlot()
     if(attr != nullptr)
     {
         attr->setDrawAttribute(button->isChecked());
+        emit attributeViewChanged(static_cast<unsigned int>(attr->getId()));
         emit updateViewSignal();
     }
 }
@@ -98,6 +114,7 @@ void AttributeWidget::deletionButtonClickedSlot()
     QPushButton* button = qobject_cast<QPushButton *>(sender());
     auto drawable = std::dynamic_pointer_cast<DrawableAttribute>(buttonMeasureMap[button]);
     annotation->removeAttribute(drawable);
+    emit attributesChanged();
     emit updateViewSignal();
     update();
 }
@@ -112,5 +129,10 @@ void AttributeWidget::textEdited()
         text = text.substr(pos + 6);
 
     attribute->setValue(text);
+    textSettleTimer.start();
+}
 
+void AttributeWidget::textSettled()
+{
+    emit attributesChanged();
 }
@@ -0,0 +1,781 @@
+#include "binaryannotationfilemanager.hpp"
+#include "mappedfile.hpp"
+#include "meshindex.hpp"
+
+#include <drawablepointannotation.hpp>
+#include <drawablelineannotation.hpp>
+#include <drawablesurfaceannotation.hpp>
+#include <drawableeuclideanmeasure.hpp>
+#include <drawablegeodesicmeasure.hpp>
+#include <drawableboundingmeasure.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+using namespace SemantisedTriangleMesh;
+using namespace Drawables;
+
+static const char MAGIC[8] = {'B', 'A', 'N', 'T', '\r', '\n', '\x1A', '\n'};
+
+BinaryAnnotationFileManager::BinaryAnnotationFileManager()
+{
+    decodedAnnotations = 0;
+}
+
+bool BinaryAnnotationFileManager::writeAnnotations(const std::string &filename)
+{
+    if(mesh == nullptr)
+    {
+        error = "No mesh to take the annotations from";
+        return false;
+    }
+    return writeAnnotations(filename, mesh->getAnnotations());
+}
+
+bool BinaryAnnotationFileManager::writeAnnotations(const std::string &filename, const std::vector<std::shared_ptr<Annotation> > &annotations)
+{
+    BinaryWriter sections;
+    encodeAnnotations(annotations, sections);
+    return writeSections(filename, sections.getBuffer());
+}
+
+bool BinaryAnnotationFileManager::writeSections(const std::string &filename, const std::string &sections)
+{
+    error.clear();
+    BinaryWriter writer;
+    writer.writeBytes(MAGIC, sizeof(MAGIC));
+    writer.writeUInt32(VERSION);
+    writer.writeBytes(sections.data(), sections.size());
+    if(!relationships.empty())
+    {
+        size_t section = writer.beginSection(static_cast<uint32_t>(SectionType::RELATIONSHIPS));
+        writer.writeVarUInt(relationships.size());
+        for(auto relationship : relationships)
+            encodeRelationship(relationship, writer);
+        writer.endSection(section);
+    }
+
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    if(!stream.is_open())
+    {
+        error = "Unable to open " + filename + " for writing";
+        return false;
+    }
+    stream.write(writer.getBuffer().data(), static_cast<std::streamsize>(writer.getBuffer().size()));
+    stream.close();
+    if(stream.fail())
+    {
+        error = "Unable to write " + filename;
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::shared_ptr<Annotation> > BinaryAnnotationFileManager::readAnnotations(const std::string &filename)
+{
+    std::vector<std::shared_ptr<Annotation> > annotations;
+    if(!open(filename))
+        return annotations;
+    while(hasNextChunk())
+    {
+        auto chunk = readNextChunk();
+        if(!error.empty())
+        {
+            annotations.clear();
+            break;
+        }
+        annotations.insert(annotations.end(), chunk.begin(), chunk.end());
+    }
+    close();
+    return annotations;
+}
+
+bool BinaryAnnotationFileManager::open(const std::string &filename)
+{
+    close();
+    error.clear();
+    relationships.clear();
+    file = MappedFile::open(filename);
+    if(file == nullptr)
+    {
+        error = "Unable to open " + filename;
+        return false;
+    }
+
+    fileReader = std::make_shared<BinaryReader>(file->getData(), file->getSize());
+    const char* magic = fileReader->readBytes(sizeof(MAGIC));
+    if(magic == nullptr || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        error = filename + " is not a binary annotation file";
+        close();
+        return false;
+    }
+    uint32_t version = fileReader->readUInt32();
+    if(version == 0 || version > VERSION)
+    {
+        error = filename + " has been written by a newer version (format " + std::to_string(version) + ")";
+        close();
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::shared_ptr<Annotation> > BinaryAnnotationFileManager::readNextChunk()
+{
+    auto chunk = buildAnnotations(readNextRecords());
+    if(!error.empty())
+        close();
+    return chunk;
+}
+
+std::vector<BinaryAnnotationFileManager::AnnotationRecord> BinaryAnnotationFileManager::readNextRecords(std::string *sections)
+{
+    std::vector<AnnotationRecord> chunk;
+    if(!hasNextChunk())
+        return chunk;
+    if(!decodeChunk(*fileReader, decodedAnnotations, chunk, sections))
+    {
+        if(error.empty())
+            error = "Malformed binary annotation file " + file->getFilename();
+        chunk.clear();
+        close();
+        return chunk;
+    }
+    decodedAnnotations += chunk.size();
+    return chunk;
+}
+
+bool BinaryAnnotationFileManager::hasNextChunk() const
+{
+    return fileReader != nullptr && error.empty() && !fileReader->atEnd() && !fileReader->getFailed();
+}
+
+int BinaryAnnotationFileManager::getProgress() const
+{
+    if(fileReader == nullptr || fileReader->getSize() == 0)
+        return 100;
+    return static_cast<int>(100.0 * fileReader->getPosition() / fileReader->getSize());
+}
+
+void BinaryAnnotationFileManager::close()
+{
+    fileReader.reset();
+    file.reset();
+    decodedAnnotations = 0;
+}
+
+void BinaryAnnotationFileManager::encodeAnnotations(const std::vector<std::shared_ptr<Annotation> > &annotations, BinaryWriter &writer) const
+{
+    for(size_t begin = 0; begin < annotations.size(); begin += CHUNK_SIZE)
+    {
+        size_t end = std::min(begin + CHUNK_SIZE, annotations.size());
+        size_t section = writer.beginSection(static_cast<uint32_t>(SectionType::ANNOTATIONS));
+        writer.writeVarUInt(end - begin);
+        for(size_t i = begin; i < end; i++)
+            encodeAnnotation(annotations[i], writer);
+        writer.endSection(section);
+
+        section = writer.beginSection(static_cast<uint32_t>(SectionType::SEMANTIC_ATTRIBUTES));
+        encodeSemanticAttributes(annotations, begin, end, writer);
+        writer.endSection(section);
+
+        section = writer.beginSection(static_cast<uint32_t>(SectionType::GEOMETRIC_ATTRIBUTES));
+        encodeGeometricAttributes(annotations, begin, end, writer);
+        writer.endSection(section);
+    }
+}
+
+void BinaryAnnotationFileManager::encodeRecords(const std::vector<AnnotationRecord> &records, size_t firstIndex, BinaryWriter &writer) const
+{
+    for(size_t begin = 0; begin < records.size(); begin += CHUNK_SIZE)
+    {
+        size_t end = std::min(begin + CHUNK_SIZE, records.size());
+        size_t section = writer.beginSection(static_cast<uint32_t>(SectionType::ANNOTATIONS));
+        writer.writeVarUInt(end - begin);
+        for(size_t i = begin; i < end; i++)
+            encodeRecord(records[i], writer);
+        writer.endSection(section);
+
+        std::vector<std::pair<size_t, const AttributeRecord*> > semantic, geometric;
+        for(size_t i = begin; i < end; i++)
+            for(auto &attribute : records[i].attributes)
+                (attribute.geometric ? geometric : semantic).push_back(std::make_pair(firstIndex + i, &attribute));
+
+        section = writer.beginSection(static_cast<uint32_t>(SectionType::SEMANTIC_ATTRIBUTES));
+        writer.writeVarUInt(semantic.size());
+        for(auto entry : semantic)
+        {
+            writer.writeVarUInt(entry.first);
+            writer.writeVarUInt(entry.second->id);
+            writer.writeString(entry.second->key);
+            writer.writeString(entry.second->value);
+        }
+        writer.endSection(section);
+
+        section = writer.beginSection(static_cast<uint32_t>(SectionType::GEOMETRIC_ATTRIBUTES));
+        writer.writeVarUInt(geometric.size());
+        for(auto entry : geometric)
+        {
+            writer.writeVarUInt(entry.first);
+            writer.writeVarUInt(entry.second->id);
+            writer.writeUInt8(static_cast<uint8_t>(entry.second->kind));
+            writer.writeString(entry.second->key);
+            writer.writeUInt8(entry.second->drawValue ? 1 : 0);
+            writer.writeIdSequence(entry.second->points);
+            if(entry.second->kind == GeometricKind::BOUNDING)
+            {
+                for(unsigned int j = 0; j < 3; j++)
+                    writer.writeDouble(entry.second->origin[j]);
+                for(unsigned int j = 0; j < 3; j++)
+                    writer.writeDouble(entry.second->direction[j]);
+            }
+        }
+        writer.endSection(section);
+    }
+}
+
+std::vector<std::shared_ptr<Annotation> > BinaryAnnotationFileManager::decodeAnnotations(BinaryReader &reader)
+{
+    std::vector<AnnotationRecord> records;
+    if(!decodeRecords(reader, records))
+        return std::vector<std::shared_ptr<Annotation> >();
+    return buildAnnotations(records);
+}
+
+bool BinaryAnnotationFileManager::decodeRecords(BinaryReader &reader, std::vector<AnnotationRecord> &records)
+{
+    while(!reader.atEnd())
+    {
+        std::vector<AnnotationRecord> chunk;
+        if(!decodeChunk(reader, records.size(), chunk))
+        {
+            if(error.empty())
+                error = "Malformed binary annotation content";
+            records.clear();
+            return false;
+        }
+        records.insert(records.end(), chunk.begin(), chunk.end());
+    }
+    return true;
+}
+
+std::vector<std::shared_ptr<Annotation> > BinaryAnnotationFileManager::buildAnnotations(const std::vector<AnnotationRecord> &records) const
+{
+    std::vector<std::shared_ptr<Annotation> > annotations;
+    if(records.empty())
+        return annotations;
+    if(mesh == nullptr)
+    {
+        error = "No mesh to attach the annotations to";
+        return annotations;
+    }
+    annotations.reserve(records.size());
+    for(auto &record : records)
+    {
+        auto annotation = buildAnnotation(record);
+        if(annotation == nullptr)
+        {
+            annotations.clear();
+            break;
+        }
+        annotations.push_back(annotation);
+    }
+    return annotations;
+}
+
+bool BinaryAnnotationFileManager::decodeChunk(BinaryReader &reader, size_t firstIndex, std::vector<AnnotationRecord> &chunk, std::string *sections)
+{
+    bool started = false;
+    uint32_t type;
+    BinaryReader content(nullptr, 0);
+    //A chunk is an annotations section and every section up to the next annotations section
+    while(reader.peekSectionType(type))
+    {
+        if(started && type == static_cast<uint32_t>(SectionType::ANNOTATIONS))
+            break;
+        size_t sectionBegin = reader.getPosition();
+        if(!reader.readSection(type, content))
+            return false;
+        if(sections != nullptr && type != static_cast<uint32_t>(SectionType::RELATIONSHIPS))
+            sections->append(reader.getData() + sectionBegin, reader.getPosition() - sectionBegin);
+        bool valid = true;
+        switch(static_cast<SectionType>(type))
+        {
+            case SectionType::ANNOTATIONS:
+            {
+                started = true;
+                uint64_t count = content.readVarUInt();
+                //Sizes come from the file: do not trust them beyond what the section can hold
+                chunk.reserve(std::min<uint64_t>(count, content.getSize()));
+                for(uint64_t i = 0; i < count && valid; i++)
+                {
+                    AnnotationRecord record;
+                    valid = decodeAnnotation(content, record);
+                    if(valid)
+                        chunk.push_back(record);
+                }
+                break;
+            }
+            case SectionType::SEMANTIC_ATTRIBUTES:
+                valid = decodeSemanticAttributes(content, chunk, firstIndex);
+                break;
+            case SectionType::GEOMETRIC_ATTRIBUTES:
+                valid = decodeGeometricAttributes(content, chunk, firstIndex);
+                break;
+            case SectionType::RELATIONSHIPS:
+            {
+                uint64_t count = content.readVarUInt();
+                for(uint64_t i = 0; i < count && !content.getFailed(); i++)
+                    relationships.push_back(decodeRelationship(content));
+                break;
+            }
+            default:
+                //Unknown section, written by a newer version: skip it
+                break;
+        }
+        if(!valid || content.getFailed())
+            return false;
+    }
+    //Trailing bytes too short for a section header
+    return !reader.getFailed() && (reader.atEnd() || reader.peekSectionType(type));
+}
+
+void BinaryAnnotationFileManager::encodeRelationship(const RelationshipRecord &relationship, BinaryWriter &writer)
+{
+    writer.writeVarUInt(relationship.id);
+    writer.writeString(relationship.type);
+    writer.writeDouble(relationship.weight);
+    writer.writeDouble(relationship.minValue);
+    writer.writeDouble(relationship.maxValue);
+    writer.writeUInt8(relationship.directed ? 1 : 0);
+    writer.writeIdSequence(relationship.subjects);
+}
+
+BinaryAnnotationFileManager::RelationshipRecord BinaryAnnotationFileManager::decodeRelationship(BinaryReader &reader)
+{
+    RelationshipRecord relationship;
+    relationship.id = static_cast<unsigned int>(reader.readVarUInt());
+    relationship.type = reader.readString();
+    relationship.weight = reader.readDouble();
+    relationship.minValue = reader.readDouble();
+    relationship.maxValue = reader.readDouble();
+    relationship.directed = reader.readUInt8() != 0;
+    relationship.subjects = reader.readIdSequence();
+    return relationship;
+}
+
+bool BinaryAnnotationFileManager::isBinaryAnnotationFile(const std::string &filename)
+{
+    std::string extension = std::string(".") + EXTENSION;
+    if(filename.size() < extension.size())
+        return false;
+    std::string suffix = filename.substr(filename.size() - extension.size());
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::tolower);
+    return suffix == extension;
+}
+
+void BinaryAnnotationFileManager::encodeAnnotation(const std::shared_ptr<Annotation> &annotation, BinaryWriter &writer) const
+{
+    writer.writeVarUInt(toIndex(annotation->getId()));
+    writer.writeString(annotation->getTag());
+    unsigned char* color = annotation->getColor();
+    writer.writeUInt8(color[0]);
+    writer.writeUInt8(color[1]);
+    writer.writeUInt8(color[2]);
+
+    switch(annotation->getType())
+    {
+        case AnnotationType::Point:
+        {
+            writer.writeUInt8(static_cast<uint8_t>(AnnotationKind::POINT));
+            auto points = std::dynamic_pointer_cast<DrawablePointAnnotation>(annotation)->getPoints();
+            writer.writeIdSequence(toIndices(points));
+            break;
+        }
+        case AnnotationType::Line:
+        {
+            writer.writeUInt8(static_cast<uint8_t>(AnnotationKind::LINE));
+            auto polylines = std::dynamic_pointer_cast<DrawableLineAnnotation>(annotation)->getPolyLines();
+            writer.writeVarUInt(polylines.size());
+            for(auto polyline : polylines)
+                writer.writeIdSequence(toIndices(polyline));
+            break;
+        }
+        case AnnotationType::Surface:
+        {
+            writer.writeUInt8(static_cast<uint8_t>(AnnotationKind::SURFACE));
+            auto surfaceAnnotation = std::dynamic_pointer_cast<DrawableSurfaceAnnotation>(annotation);
+            //The outlines define the annotation: its triangles are written only when it has none, for readers to
+            //compute the outlines from them
+            auto outlines = surfaceAnnotation->getOutlines();
+            std::vector<uint32_t> triangles;
+            if(outlines.empty())
+            {
+                auto trianglesIds = surfaceAnnotation->getTrianglesIds();
+                triangles.reserve(trianglesIds.size());
+                for(auto id : trianglesIds)
+                    triangles.push_back(toIndex(id));
+                std::sort(triangles.begin(), triangles.end());
+                triangles.erase(std::unique(triangles.begin(), triangles.end()), triangles.end());
+            }
+            writer.writeSortedIds(triangles);
+
+            writer.writeVarUInt(outlines.size());
+            for(auto outline : outlines)
+                writer.writeIdSequence(toIndices(outline));
+            break;
+        }
+        default:
+            writer.writeUInt8(0xFF);
+    }
+}
+
+void BinaryAnnotationFileManager::encodeRecord(const AnnotationRecord &record, BinaryWriter &writer) const
+{
+    writer.writeVarUInt(record.id);
+    writer.writeString(record.tag);
+    writer.writeUInt8(record.color[0]);
+    writer.writeUInt8(record.color[1]);
+    writer.writeUInt8(record.color[2]);
+    writer.writeUInt8(static_cast<uint8_t>(record.kind));
+    if(record.kind == AnnotationKind::POINT)
+    {
+        writer.writeIdSequence(record.polylines.empty() ? std::vector<uint32_t>() : record.polylines[0]);
+        return;
+    }
+    if(record.kind == AnnotationKind::SURFACE)
+        writer.writeSortedIds(record.triangles);
+    writer.writeVarUInt(record.polylines.size());
+    for(auto &polyline : record.polylines)
+        writer.writeIdSequence(polyline);
+}
+
+bool BinaryAnnotationFileManager::decodeAnnotation(BinaryReader &reader, AnnotationRecord &record) const
+{
+    record.id = static_cast<uint32_t>(reader.readVarUInt());
+    record.tag = reader.readString();
+    record.color[0] = reader.readUInt8();
+    record.color[1] = reader.readUInt8();
+    record.color[2] = reader.readUInt8();
+    uint8_t type = reader.readUInt8();
+    if(reader.getFailed())
+        return false;
+
+    record.kind = static_cast<AnnotationKind>(type);
+    switch(record.kind)
+    {
+        case AnnotationKind::POINT:
+            record.polylines.push_back(reader.readIdSequence());
+            break;
+        case AnnotationKind::LINE:
+        case AnnotationKind::SURFACE:
+        {
+            if(record.kind == AnnotationKind::SURFACE)
+                record.triangles = reader.readSortedIds();
+            uint64_t polylinesNumber = reader.readVarUInt();
+            for(uint64_t i = 0; i < polylinesNumber && !reader.getFailed(); i++)
+                record.polylines.push_back(reader.readIdSequence());
+            break;
+        }
+        default:
+            error = "Unknown annotation type " + std::to_string(type);
+            return false;
+    }
+    return !reader.getFailed();
+}
+
+std::shared_ptr<Annotation> BinaryAnnotationFileManager::buildAnnotation(const AnnotationRecord &record) const
+{
+    std::vector<std::vector<std::shared_ptr<Vertex> > > polylines;
+    for(auto &ids : record.polylines)
+    {
+        polylines.push_back(toVertices(ids));
+        if(!error.empty())
+            return nullptr;
+    }
+
+    std::shared_ptr<Annotation> annotation;
+    switch(record.kind)
+    {
+        case AnnotationKind::POINT:
+        {
+            auto pointAnnotation = std::make_shared<DrawablePointAnnotation>();
+            pointAnnotation->setPoints(polylines.empty() ? std::vector<std::shared_ptr<Vertex> >() : polylines[0]);
+            annotation = pointAnnotation;
+            break;
+        }
+        case AnnotationKind::LINE:
+        {
+            auto lineAnnotation = std::make_shared<DrawableLineAnnotation>();
+            for(auto &polyline : polylines)
+                lineAnnotation->addPolyLine(polyline);
+            annotation = lineAnnotation;
+            break;
+        }
+        case AnnotationKind::SURFACE:
+        {
+            if(polylines.empty() && !record.triangles.empty())
+            {
+                //Annotations stored without outlines: compute them from the triangles as the selection does
+                std::vector<std::shared_ptr<Triangle> > selectedTriangles;
+                selectedTriangles.reserve(record.triangles.size());
+                for(auto t : record.triangles)
+                {
+                    if(t >= mesh->getTrianglesNumber())
+                    {
+                        error = "Triangle " + std::to_string(t) + " is not in the mesh";
+                        return nullptr;
+                    }
+                    selectedTriangles.push_back(mesh->getTriangle(t));
+                }
+                polylines = mesh->getOutlines(selectedTriangles);
+            }
+            auto surfaceAnnotation = std::make_shared<DrawableSurfaceAnnotation>();
+            surfaceAnnotation->setOutlines(polylines);
+            surfaceAnnotation->setMeshPoints(mesh->getMeshVertices());
+            annotation = surfaceAnnotation;
+            break;
+        }
+    }
+
+    annotation->setId(std::to_string(record.id));
+    annotation->setTag(record.tag);
+    unsigned char color[3] = {record.color[0], record.color[1], record.color[2]};
+    annotation->setColor(color);
+    annotation->setMesh(mesh);
+    std::dynamic_pointer_cast<DrawableAnnotation>(annotation)->update();
+    for(auto &attributeRecord : record.attributes)
+    {
+        auto attribute = buildAttribute(attributeRecord);
+        if(attribute == nullptr)
+            return nullptr;
+        annotation->addAttribute(attribute);
+    }
+    return annotation;
+}
+
+void BinaryAnnotationFileManager::encodeSemanticAttributes(const std::vector<std::shared_ptr<Annotation> > &annotations, size_t begin, size_t end, BinaryWriter &writer) const
+{
+    std::vector<std::pair<size_t, std::shared_ptr<Attribute> > > semantic;
+    for(size_t i = begin; i < end; i++)
+        for(auto attribute : annotations[i]->getAttributes())
+            if(!attribute->isGeometric())
+                semantic.push_back(std::make_pair(i, attribute));
+
+    writer.writeVarUInt(semantic.size());
+    for(auto entry : semantic)
+    {
+        writer.writeVarUInt(entry.first);
+        writer.writeVarUInt(entry.second->getId());
+        writer.writeString(entry.second->getKey());
+        writer.writeString(*static_cast<std::string*>(entry.second->getValue()));
+    }
+}
+
+bool BinaryAnnotationFileManager::decodeSemanticAttributes(BinaryReader &reader, std::vector<AnnotationRecord> &chunk, size_t firstIndex) const
+{
+    uint64_t count = reader.readVarUInt();
+    for(uint64_t i = 0; i < count && !reader.getFailed(); i++)
+    {
+        uint64_t annotationIndex = reader.readVarUInt();
+        unsigned int id = static_cast<unsigned int>(reader.readVarUInt());
+        std::string key = reader.readString();
+        std::string value = reader.readString();
+        if(reader.getFailed() || annotationIndex < firstIndex || annotationIndex - firstIndex >= chunk.size())
+            return false;
+
+        AttributeRecord attribute = AttributeRecord();
+        attribute.id = id;
+        attribute.geometric = false;
+        attribute.key = key;
+        attribute.value = value;
+        chunk[annotationIndex - firstIndex].attributes.push_back(attribute);
+    }
+    return !reader.getFailed();
+}
+
+void BinaryAnnotationFileManager::encodeGeometricAttributes(const std::vector<std::shared_ptr<Annotation> > &annotations, size_t begin, size_t end, BinaryWriter &writer) const
+{
+    std::vector<std::pair<size_t, std::shared_ptr<Attribute> > > geometric;
+    for(size_t i = begin; i < end; i++)
+        for(auto attribute : annotations[i]->getAttributes())
+            if(attribute->isGeometric() && std::dynamic_pointer_cast<GeometricAttribute>(attribute) != nullptr)
+                geometric.push_back(std::make_pair(i, attribute));
+
+    writer.writeVarUInt(geometric.size());
+    for(auto entry : geometric)
+    {
+        auto attribute = std::dynamic_pointer_cast<GeometricAttribute>(entry.second);
+        auto bounding = std::dynamic_pointer_cast<DrawableBoundingMeasure>(attribute);
+        GeometricKind kind = GeometricKind::EUCLIDEAN;
+        if(bounding != nullptr)
+            kind = GeometricKind::BOUNDING;
+        else if(std::dynamic_pointer_cast<DrawableGeodesicMeasure>(attribute) != nullptr)
+            kind = GeometricKind::GEODESIC;
+
+        writer.writeVarUInt(entry.first);
+        writer.writeVarUInt(attribute->getId());
+        writer.writeUInt8(static_cast<uint8_t>(kind));
+        writer.writeString(attribute->getKey());
+        auto drawable = std::dynamic_pointer_cast<DrawableAttribute>(attribute);
+        writer.writeUInt8(drawable != nullptr && drawable->getDrawValue() ? 1 : 0);
+        auto measurePoints = attribute->getMeasurePointsID();
+        std::vector<uint32_t> points(measurePoints.begin(), measurePoints.end());
+        writer.writeIdSequence(points);
+        if(kind == GeometricKind::BOUNDING)
+        {
+            auto origin = bounding->getOrigin();
+            auto direction = bounding->getDirection();
+            writer.writeDouble(origin->getX());
+            writer.writeDouble(origin->getY());
+            writer.writeDouble(origin->getZ());
+            writer.writeDouble(direction->getX());
+            writer.writeDouble(direction->getY());
+            writer.writeDouble(direction->getZ());
+        }
+    }
+}
+
+bool BinaryAnnotationFileManager::decodeGeometricAttributes(BinaryReader &reader, std::vector<AnnotationRecord> &chunk, size_t firstIndex) const
+{
+    uint64_t count = reader.readVarUInt();
+    for(uint64_t i = 0; i < count && !reader.getFailed(); i++)
+    {
+        AttributeRecord attribute = AttributeRecord();
+        uint64_t annotationIndex = reader.readVarUInt();
+        attribute.id = static_cast<unsigned int>(reader.readVarUInt());
+        attribute.geometric = true;
+        uint8_t kind = reader.readUInt8();
+        attribute.kind = static_cast<GeometricKind>(kind);
+        attribute.key = reader.readString();
+        attribute.drawValue = reader.readUInt8() != 0;
+        attribute.points = reader.readIdSequence();
+        if(reader.getFailed() || annotationIndex < firstIndex || annotationIndex - firstIndex >= chunk.size())
+            return false;
+        if(attribute.kind == GeometricKind::BOUNDING)
+        {
+            for(unsigned int j = 0; j < 3; j++)
+                attribute.origin[j] = reader.readDouble();
+            for(unsigned int j = 0; j < 3; j++)
+                attribute.direction[j] = reader.readDouble();
+        } else if(attribute.kind != GeometricKind::EUCLIDEAN && attribute.kind != GeometricKind::GEODESIC)
+        {
+            error = "Unknown measure type " + std::to_string(kind);
+            return false;
+        }
+        chunk[annotationIndex - firstIndex].attributes.push_back(attribute);
+    }
+    return !reader.getFailed();
+}
+
+std::shared_ptr<Attribute> BinaryAnnotationFileManager::buildAttribute(const AttributeRecord &record) const
+{
+    if(!record.geometric)
+    {
+        auto attribute = std::make_shared<SemanticAttribute>();
+        attribute->setId(record.id);
+        attribute->setIsGeometric(false);
+        attribute->setKey(record.key);
+        attribute->setValue(record.value);
+        return attribute;
+    }
+
+    for(auto p : record.points)
+        if(p >= mesh->getVerticesNumber())
+        {
+            error = "Vertex " + std::to_string(p) + " is not in the mesh";
+            return nullptr;
+        }
+
+    std::shared_ptr<DrawableAttribute> attribute;
+    switch(record.kind)
+    {
+        case GeometricKind::EUCLIDEAN:
+        {
+            auto euclidean = std::make_shared<DrawableEuclideanMeasure>();
+            for(auto p : record.points)
+                euclidean->addMeasurePointID(p);
+            euclidean->setMesh(mesh);
+            euclidean->setValue(new double(0.0));
+            euclidean->update();
+            attribute = euclidean;
+            break;
+        }
+        case GeometricKind::GEODESIC:
+        {
+            auto geodesic = std::make_shared<DrawableGeodesicMeasure>();
+            for(auto p : record.points)
+                geodesic->addMeasurePointID(p);
+            geodesic->setMesh(mesh);
+            geodesic->setValue(new double(0.0));
+            geodesic->update();
+            attribute = geodesic;
+            break;
+        }
+        case GeometricKind::BOUNDING:
+        {
+            auto bounding = std::make_shared<DrawableBoundingMeasure>();
+            bounding->setOrigin(std::make_shared<Point>(record.origin[0], record.origin[1], record.origin[2]));
+            bounding->setDirection(std::make_shared<Point>(record.direction[0], record.direction[1], record.direction[2]));
+            bounding->setType(GeometricAttributeType::BOUNDING_MEASURE);
+            for(auto p : record.points)
+                bounding->addMeasurePointID(p);
+            bounding->setMesh(mesh);
+            bounding->setValue(new double(0.0));
+            bounding->update();
+            bounding->setDrawPlanes(false);
+            attribute = bounding;
+            break;
+        }
+    }
+
+    attribute->setId(record.id);
+    attribute->setKey(record.key);
+    attribute->setIsGeometric(true);
+    attribute->setDrawValue(record.drawValue);
+    return attribute;
+}
+
+std::vector<std::shared_ptr<Vertex> > BinaryAnnotationFileManager::toVertices(const std::vector<uint32_t> &ids) const
+{
+    std::vector<std::shared_ptr<Vertex> > vertices;
+    vertices.reserve(ids.size());
+    for(auto id : ids)
+    {
+        if(id >= mesh->getVerticesNumber())
+        {
+            error = "Vertex " + std::to_string(id) + " is not in the mesh";
+            break;
+        }
+        vertices.push_back(mesh->getVertex(id));
+    }
+    return vertices;
+}
+
+std::shared_ptr<DrawableTriangleMesh> BinaryAnnotationFileManager::getMesh() const
+{
+    return mesh;
+}
+
+void BinaryAnnotationFileManager::setMesh(const std::shared_ptr<DrawableTriangleMesh> &newMesh)
+{
+    mesh = newMesh;
+}
+
+const std::vector<BinaryAnnotationFileManager::RelationshipRecord> &BinaryAnnotationFileManager::getRelationships() const
+{
+    return relationships;
+}
+
+void BinaryAnnotationFileManager::setRelationships(const std::vector<RelationshipRecord> &newRelationships)
+{
+    relationships = newRelationships;
+}
+
+const std::string &BinaryAnnotationFileManager::getError() const
+{
+    return error;
+}
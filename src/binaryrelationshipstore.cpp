@@ -0,0 +1,397 @@
+#include "binaryrelationshipstore.hpp"
+#include "mappedfile.hpp"
+#include "meshindex.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <set>
+
+using namespace std;
+using namespace SemantisedTriangleMesh;
+using namespace Drawables;
+
+static const char MAGIC[8] = {'B', 'R', 'E', 'L', '\r', '\n', '\x1A', '\n'};
+
+BinaryRelationshipStore::BinaryRelationshipStore()
+{
+    subjectOffsets.push_back(0);
+}
+
+size_t BinaryRelationshipStore::addRelationship(const BinaryAnnotationFileManager::RelationshipRecord &record)
+{
+    ids.push_back(record.id);
+    subjects.insert(subjects.end(), record.subjects.begin(), record.subjects.end());
+    subjectOffsets.push_back(static_cast<uint32_t>(subjects.size()));
+    types.push_back(internType(record.type));
+    weights.push_back(record.weight);
+    minValues.push_back(record.minValue);
+    maxValues.push_back(record.maxValue);
+    directed.push_back(record.directed ? 1 : 0);
+    resolved.push_back(nullptr);
+    return ids.size() - 1;
+}
+
+std::vector<size_t> BinaryRelationshipStore::importRelationships(const std::vector<std::shared_ptr<Relationship> > &relationships)
+{
+    std::vector<size_t> imported;
+    std::set<uint32_t> taken(ids.begin(), ids.end());
+    uint32_t nextId = getNextId();
+    for(auto relationship : relationships)
+    {
+        if(relationship == nullptr || std::find(resolved.begin(), resolved.end(), relationship) != resolved.end())
+            continue;
+        BinaryAnnotationFileManager::RelationshipRecord record;
+        record.id = static_cast<uint32_t>(relationship->getId());
+        if(taken.find(record.id) != taken.end())
+            record.id = nextId;
+        nextId = std::max(nextId, record.id + 1);
+        taken.insert(record.id);
+        record.type = relationship->getType();
+        record.weight = relationship->getWeight();
+        record.minValue = relationship->getMinValue();
+        record.maxValue = relationship->getMaxValue();
+        //The direction is given to the mesh with each pair of annotations, the relationship does not keep it
+        record.directed = false;
+        for(auto annotation : relationship->getAnnotations())
+            record.subjects.push_back(toIndex(annotation));
+        size_t index = addRelationship(record);
+        resolved[index] = relationship;
+        imported.push_back(index);
+    }
+    return imported;
+}
+
+BinaryAnnotationFileManager::RelationshipRecord BinaryRelationshipStore::getRecord(size_t index) const
+{
+    BinaryAnnotationFileManager::RelationshipRecord record;
+    record.id = ids[index];
+    record.type = typeTable[types[index]];
+    record.weight = weights[index];
+    record.minValue = minValues[index];
+    record.maxValue = maxValues[index];
+    record.directed = directed[index] != 0;
+    record.subjects = getSubjects(index);
+    return record;
+}
+
+std::vector<BinaryAnnotationFileManager::RelationshipRecord> BinaryRelationshipStore::getRecords() const
+{
+    std::vector<BinaryAnnotationFileManager::RelationshipRecord> records;
+    records.reserve(ids.size());
+    for(size_t i = 0; i < ids.size(); i++)
+        records.push_back(getRecord(i));
+    return records;
+}
+
+std::shared_ptr<Relationship> BinaryRelationshipStore::getRelationship(size_t index)
+{
+    if(index >= ids.size())
+        return nullptr;
+    if(resolved[index] != nullptr || mesh == nullptr)
+        return resolved[index];
+
+    std::vector<std::shared_ptr<Annotation> > annotations;
+    for(uint32_t i = subjectOffsets[index]; i < subjectOffsets[index + 1]; i++)
+    {
+        auto annotation = mesh->getAnnotation(static_cast<int>(subjects[i]));
+        if(annotation != nullptr)
+            annotations.push_back(annotation);
+    }
+
+    auto relationship = std::make_shared<Relationship>();
+    relationship->setId(ids[index]);
+    relationship->setAnnotations(annotations);
+    relationship->setType(typeTable[types[index]]);
+    relationship->setWeight(weights[index]);
+    relationship->setMinValue(minValues[index]);
+    relationship->setMaxValue(maxValues[index]);
+
+    for (unsigned int i = 0; i < annotations.size(); i++) {
+        for (unsigned int j = i; j < annotations.size(); j++) {
+            if( i == j && annotations.size() != 1)
+                continue;
+            mesh->addAnnotationsRelationship(annotations[i], annotations[j], typeTable[types[index]], directed[index] != 0);
+        }
+    }
+    resolved[index] = relationship;
+    return relationship;
+}
+
+void BinaryRelationshipStore::resolveAll()
+{
+    for(size_t i = 0; i < ids.size(); i++)
+        getRelationship(i);
+}
+
+bool BinaryRelationshipStore::isResolved(size_t index) const
+{
+    return index < resolved.size() && resolved[index] != nullptr;
+}
+
+size_t BinaryRelationshipStore::size() const
+{
+    return ids.size();
+}
+
+bool BinaryRelationshipStore::empty() const
+{
+    return ids.empty();
+}
+
+void BinaryRelationshipStore::clear()
+{
+    ids.clear();
+    subjectOffsets.assign(1, 0);
+    subjects.clear();
+    types.clear();
+    weights.clear();
+    minValues.clear();
+    maxValues.clear();
+    directed.clear();
+    typeTable.clear();
+    typeIndices.clear();
+    resolved.clear();
+}
+
+uint32_t BinaryRelationshipStore::getId(size_t index) const
+{
+    return ids[index];
+}
+
+uint32_t BinaryRelationshipStore::getNextId() const
+{
+    uint32_t nextId = 0;
+    for(auto id : ids)
+        nextId = std::max(nextId, id + 1);
+    return nextId;
+}
+
+const std::string &BinaryRelationshipStore::getType(size_t index) const
+{
+    return typeTable[types[index]];
+}
+
+std::vector<uint32_t> BinaryRelationshipStore::getSubjects(size_t index) const
+{
+    return std::vector<uint32_t>(subjects.begin() + subjectOffsets[index], subjects.begin() + subjectOffsets[index + 1]);
+}
+
+const std::vector<std::string> &BinaryRelationshipStore::getTypes() const
+{
+    return typeTable;
+}
+
+bool BinaryRelationshipStore::read(const std::string &filename)
+{
+    error.clear();
+    auto file = MappedFile::open(filename);
+    if(file == nullptr)
+    {
+        error = "Unable to open " + filename;
+        return false;
+    }
+
+    BinaryReader reader(file->getData(), file->getSize());
+    const char* magic = reader.readBytes(sizeof(MAGIC));
+    if(magic == nullptr || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        error = filename + " is not a binary relationships file";
+        return false;
+    }
+    uint32_t version = reader.readUInt32();
+    if(version == 0 || version > VERSION)
+    {
+        error = filename + " has been written by a newer version (format " + std::to_string(version) + ")";
+        return false;
+    }
+
+    //Type indices of the file, mapped to the ones of the store
+    std::vector<uint32_t> typesMap;
+    size_t previousSize = ids.size();
+    uint32_t type;
+    BinaryReader content(nullptr, 0);
+    while(!reader.atEnd())
+    {
+        if(!reader.readSection(type, content))
+            break;
+        switch(static_cast<SectionType>(type))
+        {
+            case SectionType::TYPES:
+            {
+                uint64_t typesNumber = content.readVarUInt();
+                for(uint64_t i = 0; i < typesNumber && !content.getFailed(); i++)
+                    typesMap.push_back(internType(content.readString()));
+                if(content.getFailed())
+                {
+                    error = filename + " is malformed";
+                    return false;
+                }
+                break;
+            }
+            case SectionType::COLUMNS:
+                if(!decodeColumns(content, typesMap))
+                {
+                    //Nothing of a malformed file is kept
+                    while(ids.size() > previousSize)
+                    {
+                        ids.pop_back();
+                        subjectOffsets.pop_back();
+                        types.pop_back();
+                        weights.pop_back();
+                        minValues.pop_back();
+                        maxValues.pop_back();
+                        directed.pop_back();
+                        resolved.pop_back();
+                    }
+                    subjects.resize(subjectOffsets.back());
+                    error = filename + " is malformed";
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if(reader.getFailed())
+    {
+        error = filename + " is truncated";
+        return false;
+    }
+    return true;
+}
+
+bool BinaryRelationshipStore::decodeColumns(BinaryReader &reader, const std::vector<uint32_t> &typesMap)
+{
+    uint64_t count = reader.readVarUInt();
+    //Every relationship takes at least a few bytes: larger counts come from corrupted files
+    if(reader.getFailed() || count > reader.getSize())
+        return false;
+
+    std::vector<uint32_t> readIds = reader.readIdSequence();
+    std::vector<uint32_t> subjectCounts(count);
+    for(auto &subjectCount : subjectCounts)
+        subjectCount = static_cast<uint32_t>(reader.readVarUInt());
+    std::vector<uint32_t> readSubjects = reader.readIdSequence();
+    std::vector<uint32_t> readTypes(count);
+    for(auto &readType : readTypes)
+    {
+        uint64_t fileType = reader.readVarUInt();
+        if(fileType >= typesMap.size())
+            return false;
+        readType = typesMap[fileType];
+    }
+    std::vector<double> readWeights(count), readMinValues(count), readMaxValues(count);
+    for(auto &weight : readWeights)
+        weight = reader.readDouble();
+    for(auto &minValue : readMinValues)
+        minValue = reader.readDouble();
+    for(auto &maxValue : readMaxValues)
+        maxValue = reader.readDouble();
+    const char* readDirected = reader.readBytes(count);
+    if(reader.getFailed() || readIds.size() != count || readDirected == nullptr)
+        return false;
+
+    uint64_t subjectsNumber = 0;
+    for(auto subjectCount : subjectCounts)
+        subjectsNumber += subjectCount;
+    if(subjectsNumber != readSubjects.size())
+        return false;
+
+    ids.insert(ids.end(), readIds.begin(), readIds.end());
+    for(auto subjectCount : subjectCounts)
+        subjectOffsets.push_back(subjectOffsets.back() + subjectCount);
+    subjects.insert(subjects.end(), readSubjects.begin(), readSubjects.end());
+    types.insert(types.end(), readTypes.begin(), readTypes.end());
+    weights.insert(weights.end(), readWeights.begin(), readWeights.end());
+    minValues.insert(minValues.end(), readMinValues.begin(), readMinValues.end());
+    maxValues.insert(maxValues.end(), readMaxValues.begin(), readMaxValues.end());
+    directed.insert(directed.end(), readDirected, readDirected + count);
+    resolved.resize(ids.size(), nullptr);
+    return true;
+}
+
+bool BinaryRelationshipStore::write(const std::string &filename) const
+{
+    error.clear();
+    BinaryWriter writer;
+    writer.writeBytes(MAGIC, sizeof(MAGIC));
+    writer.writeUInt32(VERSION);
+
+    size_t section = writer.beginSection(static_cast<uint32_t>(SectionType::TYPES));
+    writer.writeVarUInt(typeTable.size());
+    for(auto &type : typeTable)
+        writer.writeString(type);
+    writer.endSection(section);
+
+    section = writer.beginSection(static_cast<uint32_t>(SectionType::COLUMNS));
+    writer.writeVarUInt(ids.size());
+    writer.writeIdSequence(ids);
+    for(size_t i = 0; i < ids.size(); i++)
+        writer.writeVarUInt(subjectOffsets[i + 1] - subjectOffsets[i]);
+    writer.writeIdSequence(subjects);
+    for(auto type : types)
+        writer.writeVarUInt(type);
+    for(auto weight : weights)
+        writer.writeDouble(weight);
+    for(auto minValue : minValues)
+        writer.writeDouble(minValue);
+    for(auto maxValue : maxValues)
+        writer.writeDouble(maxValue);
+    writer.writeBytes(reinterpret_cast<const char*>(directed.data()), directed.size());
+    writer.endSection(section);
+
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    if(!stream.is_open())
+    {
+        error = "Unable to open " + filename + " for writing";
+        return false;
+    }
+    stream.write(writer.getBuffer().data(), static_cast<std::streamsize>(writer.getBuffer().size()));
+    stream.close();
+    if(stream.fail())
+    {
+        error = "Unable to write " + filename;
+        return false;
+    }
+    return true;
+}
+
+bool BinaryRelationshipStore::isBinaryRelationshipFile(const std::string &filename)
+{
+    std::string extension = std::string(".") + EXTENSION;
+    if(filename.size() < extension.size())
+        return false;
+    std::string suffix = filename.substr(filename.size() - extension.size());
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::tolower);
+    return suffix == extension;
+}
+
+std::shared_ptr<DrawableTriangleMesh> BinaryRelationshipStore::getMesh() const
+{
+    return mesh;
+}
+
+void BinaryRelationshipStore::setMesh(const std::shared_ptr<DrawableTriangleMesh> &newMesh)
+{
+    //Relationships resolved on another mesh point to its annotations
+    if(newMesh != mesh)
+        std::fill(resolved.begin(), resolved.end(), nullptr);
+    mesh = newMesh;
+}
+
+const std::string &BinaryRelationshipStore::getError() const
+{
+    return error;
+}
+
+uint32_t BinaryRelationshipStore::internType(const std::string &type)
+{
+    auto it = typeIndices.find(type);
+    if(it != typeIndices.end())
+        return it->second;
+    uint32_t index = static_cast<uint32_t>(typeTable.size());
+    typeTable.push_back(type);
+    typeIndices.insert(std::make_pair(type, index));
+    return index;
+}
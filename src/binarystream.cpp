@@ -0,0 +1,312 @@
+#include "binarystream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+BinaryWriter::BinaryWriter()
+{
+}
+
+void BinaryWriter::writeUInt8(uint8_t value)
+{
+    buffer.push_back(static_cast<char>(value));
+}
+
+void BinaryWriter::writeUInt32(uint32_t value)
+{
+    for(unsigned int i = 0; i < 4; i++)
+        buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+void BinaryWriter::writeUInt64(uint64_t value)
+{
+    for(unsigned int i = 0; i < 8; i++)
+        buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+void BinaryWriter::writeDouble(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(double));
+    writeUInt64(bits);
+}
+
+void BinaryWriter::writeVarUInt(uint64_t value)
+{
+    while(value >= 0x80)
+    {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+void BinaryWriter::writeVarInt(int64_t value)
+{
+    writeVarUInt((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void BinaryWriter::writeString(const std::string &value)
+{
+    writeVarUInt(value.size());
+    buffer.append(value);
+}
+
+void BinaryWriter::writeBytes(const char *data, size_t size)
+{
+    buffer.append(data, size);
+}
+
+void BinaryWriter::writeSortedIds(const std::vector<uint32_t> &ids)
+{
+    //Runs are counted first so that the reader can reserve the whole set at once
+    uint64_t runs = 0;
+    for(size_t i = 0; i < ids.size(); i++)
+        if(i == 0 || ids[i] != ids[i - 1] + 1)
+            runs++;
+    writeVarUInt(ids.size());
+    writeVarUInt(runs);
+
+    uint64_t previousEnd = 0;
+    size_t i = 0;
+    while(i < ids.size())
+    {
+        size_t j = i + 1;
+        while(j < ids.size() && ids[j] == ids[j - 1] + 1)
+            j++;
+        writeVarUInt(ids[i] - previousEnd);
+        writeVarUInt(j - i - 1);
+        previousEnd = static_cast<uint64_t>(ids[j - 1]) + 1;
+        i = j;
+    }
+}
+
+void BinaryWriter::writeIdSequence(const std::vector<uint32_t> &ids)
+{
+    writeVarUInt(ids.size());
+    int64_t previous = 0;
+    for(size_t i = 0; i < ids.size(); i++)
+    {
+        writeVarInt(static_cast<int64_t>(ids[i]) - previous);
+        previous = ids[i];
+    }
+}
+
+size_t BinaryWriter::beginSection(uint32_t type)
+{
+    writeUInt32(type);
+    size_t section = buffer.size();
+    writeUInt64(0);
+    return section;
+}
+
+void BinaryWriter::endSection(size_t section)
+{
+    uint64_t length = buffer.size() - section - 8;
+    for(unsigned int i = 0; i < 8; i++)
+        buffer[section + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+}
+
+const std::string &BinaryWriter::getBuffer() const
+{
+    return buffer;
+}
+
+void BinaryWriter::clear()
+{
+    buffer.clear();
+}
+
+BinaryReader::BinaryReader(const char *data, size_t size)
+{
+    this->data = data;
+    this->size = size;
+    this->position = 0;
+    this->failed = false;
+}
+
+uint8_t BinaryReader::readUInt8()
+{
+    if(!available(1))
+        return 0;
+    return static_cast<uint8_t>(data[position++]);
+}
+
+uint32_t BinaryReader::readUInt32()
+{
+    if(!available(4))
+        return 0;
+    uint32_t value = 0;
+    for(unsigned int i = 0; i < 4; i++)
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(data[position++])) << (8 * i);
+    return value;
+}
+
+uint64_t BinaryReader::readUInt64()
+{
+    if(!available(8))
+        return 0;
+    uint64_t value = 0;
+    for(unsigned int i = 0; i < 8; i++)
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(data[position++])) << (8 * i);
+    return value;
+}
+
+double BinaryReader::readDouble()
+{
+    uint64_t bits = readUInt64();
+    double value;
+    memcpy(&value, &bits, sizeof(double));
+    return value;
+}
+
+uint64_t BinaryReader::readVarUInt()
+{
+    uint64_t value = 0;
+    for(unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        if(!available(1))
+            return 0;
+        uint8_t byte = static_cast<uint8_t>(data[position++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0)
+            return value;
+    }
+    failed = true;
+    return 0;
+}
+
+int64_t BinaryReader::readVarInt()
+{
+    uint64_t value = readVarUInt();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+std::string BinaryReader::readString()
+{
+    uint64_t length = readVarUInt();
+    if(!available(length))
+        return "";
+    std::string value(data + position, length);
+    position += length;
+    return value;
+}
+
+const char *BinaryReader::readBytes(size_t size)
+{
+    if(!available(size))
+        return nullptr;
+    const char* bytes = data + position;
+    position += size;
+    return bytes;
+}
+
+std::vector<uint32_t> BinaryReader::readSortedIds()
+{
+    std::vector<uint32_t> ids;
+    uint64_t count = readVarUInt();
+    uint64_t runs = readVarUInt();
+    //Every run takes at least two bytes and the ids are distinct 32 bit values: anything larger is a corrupted count
+    if(failed || runs > (size - position) / 2 || runs > count || count > UINT32_MAX + static_cast<uint64_t>(1))
+    {
+        failed = true;
+        return ids;
+    }
+    //A run encodes any number of ids in a few bytes, so the count itself cannot be checked against the bytes left:
+    //one id per remaining byte is reserved up front, and long runs grow the vector past it
+    ids.reserve(static_cast<size_t>(std::min<uint64_t>(count, size - position)));
+    uint64_t previousEnd = 0;
+    for(uint64_t i = 0; i < runs && !failed; i++)
+    {
+        uint64_t start = previousEnd + readVarUInt();
+        uint64_t length = readVarUInt() + 1;
+        if(start + length > UINT32_MAX + static_cast<uint64_t>(1) || ids.size() + length > count)
+        {
+            failed = true;
+            break;
+        }
+        for(uint64_t j = 0; j < length; j++)
+            ids.push_back(static_cast<uint32_t>(start + j));
+        previousEnd = start + length;
+    }
+    return ids;
+}
+
+std::vector<uint32_t> BinaryReader::readIdSequence()
+{
+    std::vector<uint32_t> ids;
+    uint64_t count = readVarUInt();
+    if(failed || count > size - position)
+    {
+        failed = true;
+        return ids;
+    }
+    ids.reserve(count);
+    int64_t previous = 0;
+    for(uint64_t i = 0; i < count && !failed; i++)
+    {
+        previous += readVarInt();
+        ids.push_back(static_cast<uint32_t>(previous));
+    }
+    return ids;
+}
+
+bool BinaryReader::readSection(uint32_t &type, BinaryReader &content)
+{
+    if(atEnd() || failed)
+        return false;
+    type = readUInt32();
+    uint64_t length = readUInt64();
+    const char* bytes = readBytes(length);
+    if(bytes == nullptr)
+        return false;
+    content = BinaryReader(bytes, length);
+    return true;
+}
+
+bool BinaryReader::peekSectionType(uint32_t &type) const
+{
+    if(failed || size - position < 12)
+        return false;
+    type = 0;
+    for(unsigned int i = 0; i < 4; i++)
+        type |= static_cast<uint32_t>(static_cast<uint8_t>(data[position + i])) << (8 * i);
+    return true;
+}
+
+bool BinaryReader::getFailed() const
+{
+    return failed;
+}
+
+bool BinaryReader::atEnd() const
+{
+    return position >= size;
+}
+
+size_t BinaryReader::getPosition() const
+{
+    return position;
+}
+
+size_t BinaryReader::getSize() const
+{
+    return size;
+}
+
+const char *BinaryReader::getData() const
+{
+    return data;
+}
+
+bool BinaryReader::available(size_t bytes)
+{
+    if(failed || bytes > size - position)
+    {
+        failed = true;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,225 @@
+#include "cellpalette.hpp"
+
+#include <vtkCellData.h>
+#include <vtkMapper.h>
+#include <vtkProperty.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+
+static uint32_t pack(unsigned char r, unsigned char g, unsigned char b)
+{
+    return (static_cast<uint32_t>(r) << 16) | (static_cast<uint32_t>(g) << 8) | static_cast<uint32_t>(b);
+}
+
+CellPalette::CellPalette()
+{
+    lookupTable = vtkSmartPointer<vtkLookupTable>::New();
+    indicesChanged = false;
+    lookupTableChanged = false;
+    scalarMode = VTK_SCALAR_MODE_DEFAULT;
+    colorMode = VTK_COLOR_MODE_DEFAULT;
+    useLookupTableScalarRange = false;
+}
+
+void CellPalette::setActor(const vtkSmartPointer<vtkActor> &newActor)
+{
+    if(newActor == nullptr || newActor->GetMapper() == nullptr)
+    {
+        clear();
+        return;
+    }
+    auto newSurface = vtkPolyData::SafeDownCast(newActor->GetMapper()->GetInputAsDataSet());
+    if(newSurface == nullptr)
+    {
+        clear();
+        return;
+    }
+    //Highlights refer to the cells of the previous surface
+    if(newSurface != surface && surface != nullptr && newSurface->GetNumberOfCells() != surface->GetNumberOfCells())
+        highlighted.clear();
+    auto mapper = newActor->GetMapper();
+    if(newActor != actor)
+    {
+        scalarMode = mapper->GetScalarMode();
+        colorMode = mapper->GetColorMode();
+        useLookupTableScalarRange = mapper->GetUseLookupTableScalarRange();
+        mapperLookupTable = mapper->GetLookupTable();
+    }
+    actor = newActor;
+    surface = newSurface;
+
+    //The colours drawn so far are captured: the cell scalars if there are any, the colour of the actor otherwise
+    vtkIdType cellsNumber = surface->GetNumberOfCells();
+    baseIndices.resize(static_cast<size_t>(cellsNumber));
+    auto sourceColors = vtkUnsignedCharArray::SafeDownCast(surface->GetCellData()->GetScalars());
+    if(sourceColors != nullptr && sourceColors->GetNumberOfComponents() >= 3 && sourceColors->GetNumberOfTuples() == cellsNumber)
+    {
+        int components = sourceColors->GetNumberOfComponents();
+        const unsigned char* data = sourceColors->GetPointer(0);
+        for(vtkIdType i = 0; i < cellsNumber; i++)
+        {
+            const unsigned char* color = data + i * components;
+            baseIndices[static_cast<size_t>(i)] = internColor(pack(color[0], color[1], color[2]));
+        }
+    } else
+    {
+        double* color = actor->GetProperty()->GetColor();
+        uint16_t index = internColor(pack(static_cast<unsigned char>(color[0] * 255),
+                                          static_cast<unsigned char>(color[1] * 255),
+                                          static_cast<unsigned char>(color[2] * 255)));
+        std::fill(baseIndices.begin(), baseIndices.end(), index);
+    }
+
+    if(indices == nullptr || surface->GetCellData()->GetArray(ARRAY_NAME) != indices)
+    {
+        indices = vtkSmartPointer<vtkTypeUInt16Array>::New();
+        indices->SetName(ARRAY_NAME);
+        surface->GetCellData()->AddArray(indices);
+    }
+    indices->SetNumberOfTuples(cellsNumber);
+    std::copy(baseIndices.begin(), baseIndices.end(), indices->GetPointer(0));
+    for(auto &cell : highlighted)
+        indices->SetValue(cell.first, cell.second);
+    indices->Modified();
+    indicesChanged = false;
+
+    updateLookupTable();
+    mapper->ScalarVisibilityOn();
+    mapper->SetScalarModeToUseCellFieldData();
+    mapper->SelectColorArray(ARRAY_NAME);
+    mapper->SetColorModeToMapScalars();
+    mapper->SetLookupTable(lookupTable);
+    mapper->UseLookupTableScalarRangeOn();
+    if(chunks != nullptr && chunks->getSurfaceActor() == actor)
+        chunks->markAllModified();
+}
+
+vtkSmartPointer<vtkActor> CellPalette::getActor() const
+{
+    return actor;
+}
+
+void CellPalette::clear()
+{
+    if(surface != nullptr && indices != nullptr)
+        surface->GetCellData()->RemoveArray(ARRAY_NAME);
+    if(actor != nullptr && actor->GetMapper() != nullptr)
+    {
+        auto mapper = actor->GetMapper();
+        mapper->SetScalarMode(scalarMode);
+        mapper->SetColorMode(colorMode);
+        mapper->SetUseLookupTableScalarRange(useLookupTableScalarRange);
+        mapper->SetLookupTable(mapperLookupTable);
+    }
+    mapperLookupTable = nullptr;
+    actor = nullptr;
+    surface = nullptr;
+    indices = nullptr;
+    baseIndices.clear();
+    colors.clear();
+    colorIndices.clear();
+    highlighted.clear();
+    indicesChanged = false;
+}
+
+void CellPalette::highlight(vtkIdType cell, const unsigned char color[3])
+{
+    if(indices == nullptr || cell < 0 || cell >= indices->GetNumberOfTuples())
+        return;
+    uint16_t index = internColor(pack(color[0], color[1], color[2]));
+    highlighted[cell] = index;
+    setIndex(cell, index);
+}
+
+void CellPalette::restore(vtkIdType cell)
+{
+    auto it = highlighted.find(cell);
+    if(it == highlighted.end())
+        return;
+    highlighted.erase(it);
+    if(indices != nullptr && cell < indices->GetNumberOfTuples())
+        setIndex(cell, baseIndices[static_cast<size_t>(cell)]);
+}
+
+void CellPalette::restoreAll()
+{
+    if(indices != nullptr)
+        for(auto &cell : highlighted)
+            if(cell.first < indices->GetNumberOfTuples())
+                setIndex(cell.first, baseIndices[static_cast<size_t>(cell.first)]);
+    highlighted.clear();
+}
+
+bool CellPalette::isHighlighted(vtkIdType cell) const
+{
+    return highlighted.find(cell) != highlighted.end();
+}
+
+void CellPalette::update()
+{
+    if(lookupTableChanged)
+        updateLookupTable();
+    if(indices == nullptr || !indicesChanged)
+        return;
+    indices->Modified();
+    indicesChanged = false;
+    if(chunks != nullptr && chunks->getSurfaceActor() == actor)
+        chunks->update();
+}
+
+size_t CellPalette::getColorsNumber() const
+{
+    return colors.size();
+}
+
+std::shared_ptr<ChunkedSurface> CellPalette::getChunks() const
+{
+    return chunks;
+}
+
+void CellPalette::setChunks(const std::shared_ptr<ChunkedSurface> &newChunks)
+{
+    chunks = newChunks;
+}
+
+uint16_t CellPalette::internColor(uint32_t color)
+{
+    auto it = colorIndices.find(color);
+    if(it != colorIndices.end())
+        return it->second;
+    //Colours beyond the capacity of the indices share the last one
+    if(colors.size() == MAX_COLORS)
+        return static_cast<uint16_t>(MAX_COLORS - 1);
+    uint16_t index = static_cast<uint16_t>(colors.size());
+    colors.push_back(color);
+    colorIndices.insert(std::make_pair(color, index));
+    lookupTableChanged = true;
+    return index;
+}
+
+void CellPalette::setIndex(vtkIdType cell, uint16_t index)
+{
+    if(indices->GetValue(cell) == index)
+        return;
+    indices->SetValue(cell, index);
+    if(chunks != nullptr && chunks->getSurfaceActor() == actor)
+        chunks->markCellModified(cell);
+    indicesChanged = true;
+}
+
+void CellPalette::updateLookupTable()
+{
+    if(colors.empty())
+        return;
+    //Index i is mapped on entry i when the range goes from 0 to the last index; a second entry keeps it valid
+    vtkIdType colorsNumber = std::max(static_cast<vtkIdType>(colors.size()), static_cast<vtkIdType>(2));
+    lookupTable->SetNumberOfTableValues(colorsNumber);
+    for(vtkIdType i = 0; i < colorsNumber; i++)
+    {
+        uint32_t color = colors[std::min(static_cast<size_t>(i), colors.size() - 1)];
+        lookupTable->SetTableValue(i, ((color >> 16) & 0xFF) / 255.0, ((color >> 8) & 0xFF) / 255.0, (color & 0xFF) / 255.0, 1.0);
+    }
+    lookupTable->SetTableRange(0, static_cast<double>(colorsNumber - 1));
+    lookupTableChanged = false;
+}
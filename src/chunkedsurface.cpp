@@ -0,0 +1,306 @@
+#include "chunkedsurface.hpp"
+
+#include <vtkCallbackCommand.h>
+#include <vtkCamera.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyDataMapper.h>
+
+#include <algorithm>
+#include <cmath>
+
+static void cullChunks(vtkObject* caller, unsigned long, void* clientData, void*)
+{
+    static_cast<ChunkedSurface*>(clientData)->cull(static_cast<vtkRenderer*>(caller));
+}
+
+ChunkedSurface::ChunkedSurface()
+{
+    canvas = vtkSmartPointer<vtkPropAssembly>::New();
+    renderObserver = 0;
+    anyModified = false;
+}
+
+ChunkedSurface::~ChunkedSurface()
+{
+    setRenderer(nullptr);
+}
+
+bool ChunkedSurface::needsChunks(const vtkSmartPointer<vtkActor> &surfaceActor)
+{
+    if(surfaceActor == nullptr || surfaceActor->GetMapper() == nullptr)
+        return false;
+    auto surface = vtkPolyData::SafeDownCast(surfaceActor->GetMapper()->GetInputAsDataSet());
+    return surface != nullptr && surface->GetNumberOfPolys() >= MIN_TRIANGLES;
+}
+
+vtkIdType ChunkedSurface::toGlobalCellId(vtkDataSet *dataset, vtkIdType cell)
+{
+    if(dataset == nullptr || cell < 0)
+        return cell;
+    auto globalIds = vtkIdTypeArray::SafeDownCast(dataset->GetCellData()->GetArray(GLOBAL_IDS_ARRAY_NAME));
+    if(globalIds == nullptr || cell >= globalIds->GetNumberOfTuples())
+        return cell;
+    return globalIds->GetValue(cell);
+}
+
+void ChunkedSurface::build(const vtkSmartPointer<vtkActor> &newSurfaceActor)
+{
+    clear();
+    if(!needsChunks(newSurfaceActor))
+        return;
+    surfaceActor = newSurfaceActor;
+    surface = vtkPolyData::SafeDownCast(surfaceActor->GetMapper()->GetInputAsDataSet());
+    auto points = surface->GetPoints();
+    vtkIdType cellsNumber = surface->GetNumberOfCells();
+    vtkIdType firstTriangle = surface->GetNumberOfVerts() + surface->GetNumberOfLines();
+
+    //The grid is refined until it has about one cell per chunk, flat cities get a single layer
+    double bounds[6];
+    surface->GetBounds(bounds);
+    double extent[3] = {bounds[1] - bounds[0], bounds[3] - bounds[2], bounds[5] - bounds[4]};
+    double cellSize = std::max(extent[0], std::max(extent[1], extent[2]));
+    if(cellSize <= 0)
+        cellSize = 1;
+    vtkIdType wantedChunks = std::max(static_cast<vtkIdType>(1), surface->GetNumberOfPolys() / TRIANGLES_PER_CHUNK);
+    int divisions[3] = {1, 1, 1};
+    while(static_cast<vtkIdType>(divisions[0]) * divisions[1] * divisions[2] < wantedChunks)
+    {
+        cellSize *= 0.8;
+        for(int i = 0; i < 3; i++)
+            divisions[i] = std::max(1, static_cast<int>(std::ceil(extent[i] / cellSize)));
+    }
+
+    //Triangles are bucketed by their centroid
+    std::vector<int> buckets(static_cast<size_t>(divisions[0]) * divisions[1] * divisions[2], -1);
+    cellChunks.assign(static_cast<size_t>(cellsNumber), 0);
+    auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+    auto polys = surface->GetPolys();
+    polys->InitTraversal();
+    for(vtkIdType cell = firstTriangle; polys->GetNextCell(cellPoints); cell++)
+    {
+        double centroid[3] = {0, 0, 0};
+        for(vtkIdType i = 0; i < cellPoints->GetNumberOfIds(); i++)
+        {
+            double p[3];
+            points->GetPoint(cellPoints->GetId(i), p);
+            centroid[0] += p[0];
+            centroid[1] += p[1];
+            centroid[2] += p[2];
+        }
+        size_t bucket = 0;
+        for(int i = 2; i >= 0; i--)
+        {
+            double position = cellPoints->GetNumberOfIds() > 0 ? centroid[i] / cellPoints->GetNumberOfIds() : bounds[2 * i];
+            int coordinate = extent[i] > 0 ? static_cast<int>((position - bounds[2 * i]) / extent[i] * divisions[i]) : 0;
+            coordinate = std::min(divisions[i] - 1, std::max(0, coordinate));
+            bucket = bucket * static_cast<size_t>(divisions[i]) + static_cast<size_t>(coordinate);
+        }
+        if(buckets[bucket] < 0)
+        {
+            buckets[bucket] = static_cast<int>(chunks.size());
+            chunks.push_back(Chunk());
+        }
+        cellChunks[static_cast<size_t>(cell)] = static_cast<unsigned int>(buckets[bucket]);
+        chunks[static_cast<size_t>(buckets[bucket])].cells.push_back(cell);
+    }
+
+    //Each chunk keeps only the points of its triangles
+    std::vector<vtkIdType> localIds(static_cast<size_t>(surface->GetNumberOfPoints()), -1);
+    for(auto &chunk : chunks)
+    {
+        auto chunkPoints = vtkSmartPointer<vtkPoints>::New();
+        chunkPoints->SetDataType(points->GetDataType());
+        auto chunkPolys = vtkSmartPointer<vtkCellArray>::New();
+        std::vector<vtkIdType> usedPoints;
+        auto chunkCell = vtkSmartPointer<vtkIdList>::New();
+        for(auto cell : chunk.cells)
+        {
+            surface->GetCellPoints(cell, cellPoints);
+            chunkCell->SetNumberOfIds(cellPoints->GetNumberOfIds());
+            for(vtkIdType i = 0; i < cellPoints->GetNumberOfIds(); i++)
+            {
+                vtkIdType point = cellPoints->GetId(i);
+                if(localIds[static_cast<size_t>(point)] < 0)
+                {
+                    localIds[static_cast<size_t>(point)] = chunkPoints->InsertNextPoint(points->GetPoint(point));
+                    usedPoints.push_back(point);
+                }
+                chunkCell->SetId(i, localIds[static_cast<size_t>(point)]);
+            }
+            chunkPolys->InsertNextCell(chunkCell);
+        }
+        for(auto point : usedPoints)
+            localIds[static_cast<size_t>(point)] = -1;
+
+        chunk.polydata = vtkSmartPointer<vtkPolyData>::New();
+        chunk.polydata->SetPoints(chunkPoints);
+        chunk.polydata->SetPolys(chunkPolys);
+        chunk.polydata->GetBounds(chunk.bounds);
+        copyCellData(chunk);
+
+        auto mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+        mapper->SetInputData(chunk.polydata);
+        chunk.actor = vtkSmartPointer<vtkActor>::New();
+        chunk.actor->SetMapper(mapper);
+        chunk.actor->SetProperty(surfaceActor->GetProperty());
+        copyColoring(chunk);
+        chunk.modified = false;
+        canvas->AddPart(chunk.actor);
+    }
+    anyModified = false;
+}
+
+void ChunkedSurface::clear()
+{
+    for(auto &chunk : chunks)
+        canvas->RemovePart(chunk.actor);
+    chunks.clear();
+    cellChunks.clear();
+    surfaceActor = nullptr;
+    surface = nullptr;
+    anyModified = false;
+}
+
+bool ChunkedSurface::isBuilt() const
+{
+    return !chunks.empty();
+}
+
+void ChunkedSurface::markCellModified(vtkIdType cell)
+{
+    if(cell < 0 || static_cast<size_t>(cell) >= cellChunks.size())
+        return;
+    chunks[cellChunks[static_cast<size_t>(cell)]].modified = true;
+    anyModified = true;
+}
+
+void ChunkedSurface::markAllModified()
+{
+    for(auto &chunk : chunks)
+        chunk.modified = true;
+    anyModified = !chunks.empty();
+}
+
+void ChunkedSurface::update()
+{
+    if(!anyModified)
+        return;
+    for(auto &chunk : chunks)
+        if(chunk.modified)
+        {
+            copyCellData(chunk);
+            copyColoring(chunk);
+            chunk.modified = false;
+        }
+    anyModified = false;
+}
+
+void ChunkedSurface::cull(vtkRenderer *currentRenderer)
+{
+    if(chunks.empty() || currentRenderer == nullptr || currentRenderer->GetActiveCamera() == nullptr)
+        return;
+    //The planes of the frustum point inwards: a box is outside if its corner farthest along a normal is behind it.
+    //Only the side planes (left, right, bottom, top) are tested: the near and far ones come from the clipping range,
+    //which vtk resets from the visible props, so testing them would shrink the range at every hidden chunk
+    double planes[24];
+    currentRenderer->GetActiveCamera()->GetFrustumPlanes(currentRenderer->GetTiledAspectRatio(), planes);
+    for(auto &chunk : chunks)
+    {
+        bool inside = true;
+        for(int i = 0; i < 4 && inside; i++)
+        {
+            const double* plane = planes + 4 * i;
+            double corner[3];
+            for(int j = 0; j < 3; j++)
+                corner[j] = plane[j] >= 0 ? chunk.bounds[2 * j + 1] : chunk.bounds[2 * j];
+            inside = plane[0] * corner[0] + plane[1] * corner[1] + plane[2] * corner[2] + plane[3] >= 0;
+        }
+        chunk.actor->SetVisibility(inside);
+    }
+}
+
+void ChunkedSurface::addToPickList(const vtkSmartPointer<vtkCellPicker> &picker) const
+{
+    for(auto &chunk : chunks)
+        picker->AddPickList(chunk.actor);
+}
+
+vtkSmartPointer<vtkActor> ChunkedSurface::getSurfaceActor() const
+{
+    return surfaceActor;
+}
+
+vtkSmartPointer<vtkPropAssembly> ChunkedSurface::getCanvas() const
+{
+    return canvas;
+}
+
+size_t ChunkedSurface::getChunksNumber() const
+{
+    return chunks.size();
+}
+
+size_t ChunkedSurface::getVisibleChunksNumber() const
+{
+    return static_cast<size_t>(std::count_if(chunks.begin(), chunks.end(), [](const Chunk &chunk){ return chunk.actor->GetVisibility() != 0; }));
+}
+
+vtkSmartPointer<vtkRenderer> ChunkedSurface::getRenderer() const
+{
+    return renderer;
+}
+
+void ChunkedSurface::setRenderer(const vtkSmartPointer<vtkRenderer> &newRenderer)
+{
+    if(newRenderer == renderer)
+        return;
+    if(renderer != nullptr)
+        renderer->RemoveObserver(renderObserver);
+    renderer = newRenderer;
+    renderObserver = 0;
+    if(renderer == nullptr)
+        return;
+    auto callback = vtkSmartPointer<vtkCallbackCommand>::New();
+    callback->SetCallback(cullChunks);
+    callback->SetClientData(this);
+    renderObserver = renderer->AddObserver(vtkCommand::StartEvent, callback);
+}
+
+void ChunkedSurface::copyCellData(Chunk &chunk)
+{
+    auto source = surface->GetCellData();
+    auto target = chunk.polydata->GetCellData();
+    target->Initialize();
+    vtkIdType cellsNumber = static_cast<vtkIdType>(chunk.cells.size());
+    target->CopyAllocate(source, cellsNumber);
+    for(vtkIdType i = 0; i < cellsNumber; i++)
+        target->CopyData(source, chunk.cells[static_cast<size_t>(i)], i);
+    target->Squeeze();
+
+    auto globalIds = vtkSmartPointer<vtkIdTypeArray>::New();
+    globalIds->SetName(GLOBAL_IDS_ARRAY_NAME);
+    globalIds->SetNumberOfTuples(cellsNumber);
+    std::copy(chunk.cells.begin(), chunk.cells.end(), globalIds->GetPointer(0));
+    target->AddArray(globalIds);
+    chunk.polydata->Modified();
+}
+
+void ChunkedSurface::copyColoring(Chunk &chunk)
+{
+    //The palette of the surface, if any, is shared: its lookup table is the same object
+    auto source = surfaceActor->GetMapper();
+    auto target = chunk.actor->GetMapper();
+    target->SetScalarVisibility(source->GetScalarVisibility());
+    target->SetScalarMode(source->GetScalarMode());
+    target->SetColorMode(source->GetColorMode());
+    if(source->GetArrayName() != nullptr && source->GetArrayName()[0] != '\0')
+        target->SelectColorArray(source->GetArrayName());
+    target->SetLookupTable(source->GetLookupTable());
+    target->SetUseLookupTableScalarRange(source->GetUseLookupTableScalarRange());
+    target->SetScalarRange(source->GetScalarRange());
+    target->SetInterpolateScalarsBeforeMapping(source->GetInterpolateScalarsBeforeMapping());
+}
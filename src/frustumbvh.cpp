@@ -0,0 +1,231 @@
+#include "frustumbvh.hpp"
+
+#include <vtkDataArray.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <thread>
+
+FrustumBVH::FrustumBVH()
+{
+    threadsNumber = 0;
+    std::fill(origin, origin + 3, 0.0);
+}
+
+void FrustumBVH::build(vtkPoints *points)
+{
+    clear();
+    if(points == nullptr || points->GetNumberOfPoints() == 0 ||
+       points->GetNumberOfPoints() > static_cast<vtkIdType>(std::numeric_limits<uint32_t>::max()))
+        return;
+
+    uint32_t pointsNumber = static_cast<uint32_t>(points->GetNumberOfPoints());
+    double bounds[6];
+    points->GetBounds(bounds);
+    for(unsigned int j = 0; j < 3; j++)
+        origin[j] = bounds[2 * j];
+    //The offsets are taken in double precision, only what is left is rounded
+    std::vector<float> source(3 * static_cast<size_t>(pointsNumber));
+    for(uint32_t i = 0; i < pointsNumber; i++)
+    {
+        double p[3];
+        points->GetPoint(i, p);
+        for(unsigned int j = 0; j < 3; j++)
+            source[3 * static_cast<size_t>(i) + j] = static_cast<float>(p[j] - origin[j]);
+    }
+    std::vector<vtkIdType> order(pointsNumber);
+    std::iota(order.begin(), order.end(), 0);
+    nodes.reserve(2 * (pointsNumber / LEAF_SIZE + 1));
+    buildNode(order, source, 0, pointsNumber);
+
+    //Points are stored as the leaves visit them
+    coordinates.resize(source.size());
+    for(size_t i = 0; i < order.size(); i++)
+        for(unsigned int j = 0; j < 3; j++)
+            coordinates[3 * i + j] = source[3 * static_cast<size_t>(order[i]) + j];
+    ids.swap(order);
+}
+
+void FrustumBVH::clear()
+{
+    nodes.clear();
+    coordinates.clear();
+    ids.clear();
+    std::fill(origin, origin + 3, 0.0);
+}
+
+bool FrustumBVH::isBuilt() const
+{
+    return !nodes.empty();
+}
+
+vtkIdType FrustumBVH::getPointsNumber() const
+{
+    return static_cast<vtkIdType>(ids.size());
+}
+
+std::vector<vtkIdType> FrustumBVH::query(vtkPlanes *frustum) const
+{
+    std::vector<vtkIdType> selected;
+    if(!isBuilt() || frustum == nullptr || frustum->GetNormals() == nullptr || frustum->GetPoints() == nullptr)
+        return selected;
+
+    //vtkPlanes evaluates the distance from the farthest plane: inside points are behind all of them.
+    //The planes are expressed in the frame of the stored offsets
+    std::vector<Plane> planes;
+    for(vtkIdType i = 0; i < frustum->GetNumberOfPlanes(); i++)
+    {
+        Plane plane;
+        double point[3];
+        frustum->GetNormals()->GetTuple(i, plane.normal);
+        frustum->GetPoints()->GetPoint(i, point);
+        plane.offset = 0;
+        for(unsigned int j = 0; j < 3; j++)
+            plane.offset -= plane.normal[j] * (point[j] - origin[j]);
+        planes.push_back(plane);
+    }
+
+    unsigned int threads = threadsNumber > 0 ? threadsNumber : std::max(1u, std::thread::hardware_concurrency());
+    if(threads == 1 || getPointsNumber() < MIN_PARALLEL_POINTS)
+    {
+        collect(0, planes, selected);
+        return selected;
+    }
+
+    //The first levels are split in enough subtrees to balance the threads, whatever the frustum discards
+    std::vector<uint32_t> subtrees = {0};
+    while(subtrees.size() < 4 * threads)
+    {
+        std::vector<uint32_t> next;
+        for(auto index : subtrees)
+            if(nodes[index].right == 0)
+                next.push_back(index);
+            else
+            {
+                next.push_back(index + 1);
+                next.push_back(nodes[index].right);
+            }
+        if(next.size() == subtrees.size())
+            break;
+        subtrees.swap(next);
+    }
+
+    std::vector<std::vector<vtkIdType> > partial(threads);
+    std::atomic<size_t> nextSubtree(0);
+    std::vector<std::thread> workers;
+    for(unsigned int i = 0; i < threads; i++)
+        workers.push_back(std::thread([this, &subtrees, &planes, &partial, &nextSubtree, i]()
+        {
+            for(size_t s = nextSubtree++; s < subtrees.size(); s = nextSubtree++)
+                collect(subtrees[s], planes, partial[i]);
+        }));
+    for(auto &worker : workers)
+        worker.join();
+
+    size_t selectedNumber = 0;
+    for(auto &part : partial)
+        selectedNumber += part.size();
+    selected.reserve(selectedNumber);
+    for(auto &part : partial)
+        selected.insert(selected.end(), part.begin(), part.end());
+    return selected;
+}
+
+unsigned int FrustumBVH::getThreadsNumber() const
+{
+    return threadsNumber;
+}
+
+void FrustumBVH::setThreadsNumber(unsigned int newThreadsNumber)
+{
+    threadsNumber = newThreadsNumber;
+}
+
+uint32_t FrustumBVH::buildNode(std::vector<vtkIdType> &order, const std::vector<float> &source, uint32_t first, uint32_t count)
+{
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    Node node;
+    for(unsigned int j = 0; j < 3; j++)
+    {
+        node.min[j] = std::numeric_limits<double>::max();
+        node.max[j] = std::numeric_limits<double>::lowest();
+    }
+    for(uint32_t i = first; i < first + count; i++)
+        for(unsigned int j = 0; j < 3; j++)
+        {
+            double c = source[3 * static_cast<size_t>(order[i]) + j];
+            node.min[j] = std::min(node.min[j], c);
+            node.max[j] = std::max(node.max[j], c);
+        }
+    node.first = first;
+    node.count = count;
+    node.right = 0;
+    nodes.push_back(node);
+    if(count <= LEAF_SIZE)
+        return index;
+
+    //Median split along the longest side
+    unsigned int axis = 0;
+    for(unsigned int j = 1; j < 3; j++)
+        if(node.max[j] - node.min[j] > node.max[axis] - node.min[axis])
+            axis = j;
+    uint32_t half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                     [&source, axis](vtkIdType a, vtkIdType b)
+    {
+        return source[3 * static_cast<size_t>(a) + axis] < source[3 * static_cast<size_t>(b) + axis];
+    });
+    buildNode(order, source, first, half);
+    uint32_t right = buildNode(order, source, first + half, count - half);
+    nodes[index].right = right;
+    return index;
+}
+
+FrustumBVH::Side FrustumBVH::classify(const Node &node, const std::vector<Plane> &planes) const
+{
+    bool inside = true;
+    for(auto &plane : planes)
+    {
+        double nearest = plane.offset, farthest = plane.offset;
+        for(unsigned int j = 0; j < 3; j++)
+        {
+            nearest += plane.normal[j] * (plane.normal[j] > 0 ? node.min[j] : node.max[j]);
+            farthest += plane.normal[j] * (plane.normal[j] > 0 ? node.max[j] : node.min[j]);
+        }
+        if(nearest > 0)
+            return Side::OUTSIDE;
+        if(farthest > 0)
+            inside = false;
+    }
+    return inside ? Side::INSIDE : Side::CROSSING;
+}
+
+void FrustumBVH::collect(uint32_t index, const std::vector<Plane> &planes, std::vector<vtkIdType> &selected) const
+{
+    const Node &node = nodes[index];
+    Side side = classify(node, planes);
+    if(side == Side::OUTSIDE)
+        return;
+    if(side == Side::INSIDE)
+    {
+        selected.insert(selected.end(), ids.begin() + node.first, ids.begin() + node.first + node.count);
+        return;
+    }
+    if(node.right != 0)
+    {
+        collect(index + 1, planes, selected);
+        collect(node.right, planes, selected);
+        return;
+    }
+    for(uint32_t i = node.first; i < node.first + node.count; i++)
+    {
+        const float* p = &coordinates[3 * static_cast<size_t>(i)];
+        bool inside = true;
+        for(auto it = planes.begin(); inside && it != planes.end(); it++)
+            inside = it->normal[0] * p[0] + it->normal[1] * p[1] + it->normal[2] * p[2] + it->offset <= 0;
+        if(inside)
+            selected.push_back(ids[i]);
+    }
+}
@@ -0,0 +1,301 @@
+#include "idbuffer.hpp"
+
+#include <vtkCamera.h>
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPoints.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+//Needed in C++11, as std::vector::assign takes it by reference
+constexpr uint32_t IdBuffer::NO_ID;
+
+IdBuffer::IdBuffer()
+{
+    std::fill(matrix, matrix + 16, 0.0);
+    width = 0;
+    height = 0;
+    threadsNumber = 0;
+    geometryTime = 0;
+    cameraTime = 0;
+}
+
+void IdBuffer::render(vtkPolyData *surface, const double matrix[16], int width, int height)
+{
+    if(surface != this->surface || getGeometryTime(surface) != geometryTime)
+    {
+        this->surface = surface;
+        readTriangles();
+        geometryTime = getGeometryTime(surface);
+    }
+    std::copy(matrix, matrix + 16, this->matrix);
+    this->width = std::max(0, width);
+    this->height = std::max(0, height);
+    size_t pixelsNumber = static_cast<size_t>(this->width) * static_cast<size_t>(this->height);
+    ids.assign(pixelsNumber, NO_ID);
+    depths.assign(pixelsNumber, std::numeric_limits<float>::max());
+    visibleTriangles.assign(triangles.size() / 3, 0);
+    if(surface == nullptr || surface->GetPoints() == nullptr || pixelsNumber == 0)
+        return;
+
+    unsigned int threads = threadsNumber > 0 ? threadsNumber : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+
+    //Points are projected once, then every band reads them
+    vtkIdType pointsNumber = surface->GetNumberOfPoints();
+    std::vector<float> projected(3 * static_cast<size_t>(pointsNumber));
+    std::vector<char> valid(static_cast<size_t>(pointsNumber), 0);
+    for(unsigned int i = 0; i < threads; i++)
+        workers.push_back(std::thread([this, &projected, &valid, pointsNumber, threads, i]()
+        {
+            double p[3];
+            for(vtkIdType j = pointsNumber * i / threads; j < pointsNumber * (i + 1) / threads; j++)
+            {
+                this->surface->GetPoint(j, p);
+                valid[static_cast<size_t>(j)] = project(p, &projected[3 * static_cast<size_t>(j)]);
+            }
+        }));
+    for(auto &worker : workers)
+        worker.join();
+    workers.clear();
+
+    //Each band of rows is written by one thread only
+    unsigned int bands = std::min(threads, static_cast<unsigned int>(this->height));
+    for(unsigned int i = 0; i < bands; i++)
+        workers.push_back(std::thread([this, &projected, &valid, bands, i]()
+        {
+            rasterise(projected, valid, this->height * static_cast<int>(i) / static_cast<int>(bands),
+                      this->height * static_cast<int>(i + 1) / static_cast<int>(bands));
+        }));
+    for(auto &worker : workers)
+        worker.join();
+
+    for(auto id : ids)
+        if(id != NO_ID)
+            visibleTriangles[id] = 1;
+
+    //Triangles smaller than a pixel may cover no pixel centre: they are visible if a neighbour is drawn at one of their vertices
+    workers.clear();
+    size_t trianglesNumber = triangles.size() / 3;
+    for(unsigned int i = 0; i < threads; i++)
+        workers.push_back(std::thread([this, &projected, &valid, trianglesNumber, threads, i]()
+        {
+            for(size_t t = trianglesNumber * i / threads; t < trianglesNumber * (i + 1) / threads; t++)
+            {
+                const uint32_t* v = &triangles[3 * t];
+                if(visibleTriangles[t] != 0 || v[0] == NO_ID)
+                    continue;
+                for(unsigned int j = 0; j < 3 && visibleTriangles[t] == 0; j++)
+                    if(valid[v[j]] && isNeighbourDrawn(t, &projected[3 * static_cast<size_t>(v[j])]))
+                        visibleTriangles[t] = 1;
+            }
+        }));
+    for(auto &worker : workers)
+        worker.join();
+}
+
+bool IdBuffer::update(vtkPolyData *surface, vtkRenderer *renderer)
+{
+    if(surface == nullptr || renderer == nullptr)
+        return false;
+    int* size = renderer->GetSize();
+    vtkCamera* camera = renderer->GetActiveCamera();
+    if(!ids.empty() && surface == this->surface && getGeometryTime(surface) == geometryTime &&
+       size[0] == width && size[1] == height && camera->GetMTime() == cameraTime)
+        return false;
+
+    vtkMatrix4x4* composite = camera->GetCompositeProjectionTransformMatrix(renderer->GetTiledAspectRatio(), -1, 1);
+    render(surface, composite->GetData(), size[0], size[1]);
+    cameraTime = camera->GetMTime();
+    return true;
+}
+
+void IdBuffer::clear()
+{
+    surface = nullptr;
+    triangles.clear();
+    ids.clear();
+    depths.clear();
+    visibleTriangles.clear();
+    width = 0;
+    height = 0;
+    geometryTime = 0;
+    cameraTime = 0;
+}
+
+int IdBuffer::getWidth() const
+{
+    return width;
+}
+
+int IdBuffer::getHeight() const
+{
+    return height;
+}
+
+uint32_t IdBuffer::getId(int x, int y) const
+{
+    if(x < 0 || y < 0 || x >= width || y >= height)
+        return NO_ID;
+    return ids[static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)];
+}
+
+bool IdBuffer::isTriangleVisible(vtkIdType triangleId) const
+{
+    return triangleId >= 0 && static_cast<size_t>(triangleId) < visibleTriangles.size() && visibleTriangles[static_cast<size_t>(triangleId)] != 0;
+}
+
+bool IdBuffer::isPointVisible(vtkIdType pointId) const
+{
+    if(surface == nullptr || pointId < 0 || pointId >= surface->GetNumberOfPoints())
+        return false;
+    double p[3];
+    float projected[3];
+    surface->GetPoint(pointId, p);
+    if(!project(p, projected))
+        return false;
+
+    //A point has no area of its own: it is visible if one of its triangles covers its pixel or one next to it
+    int px = static_cast<int>(std::floor(projected[0])), py = static_cast<int>(std::floor(projected[1]));
+    for(int y = py - 1; y <= py + 1; y++)
+        for(int x = px - 1; x <= px + 1; x++)
+        {
+            uint32_t id = getId(x, y);
+            if(id == NO_ID)
+                continue;
+            for(unsigned int j = 0; j < 3; j++)
+                if(triangles[3 * static_cast<size_t>(id) + j] == static_cast<uint32_t>(pointId))
+                    return true;
+        }
+    return false;
+}
+
+unsigned int IdBuffer::getThreadsNumber() const
+{
+    return threadsNumber;
+}
+
+void IdBuffer::setThreadsNumber(unsigned int newThreadsNumber)
+{
+    threadsNumber = newThreadsNumber;
+}
+
+vtkMTimeType IdBuffer::getGeometryTime(vtkPolyData *polydata) const
+{
+    vtkMTimeType time = 0;
+    if(polydata == nullptr)
+        return time;
+    if(polydata->GetPoints() != nullptr)
+        time = std::max(time, polydata->GetPoints()->GetMTime());
+    if(polydata->GetPolys() != nullptr)
+        time = std::max(time, polydata->GetPolys()->GetMTime());
+    return time;
+}
+
+void IdBuffer::readTriangles()
+{
+    triangles.clear();
+    if(surface == nullptr || surface->GetPolys() == nullptr)
+        return;
+    vtkCellArray* polys = surface->GetPolys();
+    triangles.reserve(3 * static_cast<size_t>(polys->GetNumberOfCells()));
+    //Every poly keeps its slot, so that its index is still its id
+    auto points = vtkSmartPointer<vtkIdList>::New();
+    polys->InitTraversal();
+    while(polys->GetNextCell(points))
+        for(vtkIdType j = 0; j < 3; j++)
+            triangles.push_back(points->GetNumberOfIds() >= 3 ? static_cast<uint32_t>(points->GetId(j)) : NO_ID);
+}
+
+bool IdBuffer::project(const double p[3], float projected[3]) const
+{
+    double x = matrix[0] * p[0] + matrix[1] * p[1] + matrix[2] * p[2] + matrix[3];
+    double y = matrix[4] * p[0] + matrix[5] * p[1] + matrix[6] * p[2] + matrix[7];
+    double z = matrix[8] * p[0] + matrix[9] * p[1] + matrix[10] * p[2] + matrix[11];
+    double w = matrix[12] * p[0] + matrix[13] * p[1] + matrix[14] * p[2] + matrix[15];
+    //Behind the camera
+    if(w <= std::numeric_limits<double>::epsilon())
+        return false;
+    projected[0] = static_cast<float>((x / w + 1) / 2 * width);
+    projected[1] = static_cast<float>((y / w + 1) / 2 * height);
+    projected[2] = static_cast<float>(z / w);
+    return true;
+}
+
+bool IdBuffer::isNeighbourDrawn(size_t triangle, const float projected[2]) const
+{
+    //As for the points, the pixel of the vertex and the ones next to it are read: a vertex on the border of its
+    //neighbours falls in a pixel whose centre they do not cover
+    const uint32_t* v = &triangles[3 * triangle];
+    int px = static_cast<int>(std::floor(projected[0])), py = static_cast<int>(std::floor(projected[1]));
+    for(int y = py - 1; y <= py + 1; y++)
+        for(int x = px - 1; x <= px + 1; x++)
+        {
+            uint32_t id = getId(x, y);
+            if(id == NO_ID)
+                continue;
+            for(unsigned int i = 0; i < 3; i++)
+                for(unsigned int j = 0; j < 3; j++)
+                    if(v[i] == triangles[3 * static_cast<size_t>(id) + j])
+                        return true;
+        }
+    return false;
+}
+
+void IdBuffer::rasterise(const std::vector<float> &projected, const std::vector<char> &valid, int firstRow, int lastRow)
+{
+    size_t trianglesNumber = triangles.size() / 3;
+    for(size_t t = 0; t < trianglesNumber; t++)
+    {
+        const uint32_t* v = &triangles[3 * t];
+        if(v[0] == NO_ID || !valid[v[0]] || !valid[v[1]] || !valid[v[2]])
+            continue;
+        const float* p0 = &projected[3 * static_cast<size_t>(v[0])];
+        const float* p1 = &projected[3 * static_cast<size_t>(v[1])];
+        const float* p2 = &projected[3 * static_cast<size_t>(v[2])];
+
+        //Pixel centres covered by the bounding box, within the band
+        float minY = std::min(p0[1], std::min(p1[1], p2[1])), maxY = std::max(p0[1], std::max(p1[1], p2[1]));
+        int yBegin = std::max(firstRow, static_cast<int>(std::ceil(minY - 0.5f)));
+        int yEnd = std::min(lastRow - 1, static_cast<int>(std::floor(maxY - 0.5f)));
+        if(yBegin > yEnd)
+            continue;
+        float minX = std::min(p0[0], std::min(p1[0], p2[0])), maxX = std::max(p0[0], std::max(p1[0], p2[0]));
+        int xBegin = std::max(0, static_cast<int>(std::ceil(minX - 0.5f)));
+        int xEnd = std::min(width - 1, static_cast<int>(std::floor(maxX - 0.5f)));
+        if(xBegin > xEnd)
+            continue;
+        double area = (static_cast<double>(p1[0]) - p0[0]) * (static_cast<double>(p2[1]) - p0[1]) -
+                      (static_cast<double>(p1[1]) - p0[1]) * (static_cast<double>(p2[0]) - p0[0]);
+        if(area == 0.0)
+            continue;
+
+        for(int y = yBegin; y <= yEnd; y++)
+        {
+            double cy = y + 0.5;
+            for(int x = xBegin; x <= xEnd; x++)
+            {
+                double cx = x + 0.5;
+                //Both faces are drawn, as the surface actor does: the weights only need the sign of the area
+                double w0 = ((static_cast<double>(p2[0]) - p1[0]) * (cy - p1[1]) - (static_cast<double>(p2[1]) - p1[1]) * (cx - p1[0])) / area;
+                double w1 = ((static_cast<double>(p0[0]) - p2[0]) * (cy - p2[1]) - (static_cast<double>(p0[1]) - p2[1]) * (cx - p2[0])) / area;
+                double w2 = 1.0 - w0 - w1;
+                if(w0 < 0 || w1 < 0 || w2 < 0)
+                    continue;
+                float depth = static_cast<float>(w0 * p0[2] + w1 * p1[2] + w2 * p2[2]);
+                if(depth < -1.0f || depth > 1.0f)
+                    continue;
+                size_t pixel = static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x);
+                if(depth < depths[pixel])
+                {
+                    depths[pixel] = depth;
+                    ids[pixel] = static_cast<uint32_t>(t);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#include "lodproxy.hpp"
+#include "cellpalette.hpp"
+#include "lodproxybuilder.hpp"
+#include "meshindex.hpp"
+
+#include <drawablesurfaceannotation.hpp>
+
+#include <vtkCellData.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkLookupTable.h>
+#include <vtkPoints.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkProperty.h>
+#include <vtkTypeUInt16Array.h>
+#include <vtkUnsignedCharArray.h>
+
+using namespace std;
+using namespace SemantisedTriangleMesh;
+using namespace Drawables;
+
+static void centroid(vtkPolyData* polydata, vtkIdType cell, vtkIdList* cellPoints, double c[3])
+{
+    c[0] = c[1] = c[2] = 0;
+    polydata->GetCellPoints(cell, cellPoints);
+    vtkIdType pointsNumber = cellPoints->GetNumberOfIds();
+    for(vtkIdType i = 0; i < pointsNumber; i++)
+    {
+        double p[3];
+        polydata->GetPoint(cellPoints->GetId(i), p);
+        c[0] += p[0];
+        c[1] += p[1];
+        c[2] += p[2];
+    }
+    if(pointsNumber > 0)
+        for(int i = 0; i < 3; i++)
+            c[i] /= pointsNumber;
+}
+
+static vtkMTimeType getPaletteTime(vtkPolyData* surface)
+{
+    vtkDataArray* indices = surface->GetCellData()->GetArray(CellPalette::ARRAY_NAME);
+    return indices != nullptr ? indices->GetMTime() : 0;
+}
+
+LODProxy::LODProxy()
+{
+    coloredVersion = 0;
+    coloredPaletteTime = 0;
+    colored = false;
+}
+
+void LODProxy::show(const vtkSmartPointer<vtkPropAssembly> &assembly, unsigned long sceneVersion)
+{
+    if(!isReady() || assembly == nullptr || isShown())
+        return;
+    auto surfaceActor = mesh->getSurfaceActor();
+    if(surfaceActor == nullptr || surfaceActor->GetMapper() == nullptr)
+        return;
+    auto surface = vtkPolyData::SafeDownCast(surfaceActor->GetMapper()->GetInputAsDataSet());
+    if(surface == nullptr)
+        return;
+
+    //Selections only write palette indices, which do not change the version of the scene
+    vtkMTimeType paletteTime = getPaletteTime(surface);
+    if(!colored || sceneVersion != coloredVersion || paletteTime != coloredPaletteTime)
+    {
+        updateColors(surface);
+        coloredVersion = sceneVersion;
+        coloredPaletteTime = paletteTime;
+        colored = true;
+    }
+    actor->GetProperty()->DeepCopy(surfaceActor->GetProperty());
+
+    //The surface and the surface annotations are painted on the proxy, the other annotations stay as they are
+    hiddenProps.clear();
+    if(surfaceActor->GetVisibility())
+        hiddenProps.push_back(surfaceActor);
+    if(chunkedSurface != nullptr && chunkedSurface->getSurfaceActor() == surfaceActor && chunkedSurface->getCanvas()->GetVisibility())
+        hiddenProps.push_back(chunkedSurface->getCanvas());
+    for(auto annotation : mesh->getAnnotations())
+    {
+        auto surfaceAnnotation = dynamic_pointer_cast<DrawableSurfaceAnnotation>(annotation);
+        if(surfaceAnnotation != nullptr && surfaceAnnotation->getCanvas() != nullptr && surfaceAnnotation->getCanvas()->GetVisibility())
+            hiddenProps.push_back(surfaceAnnotation->getCanvas());
+    }
+    for(auto prop : hiddenProps)
+        prop->VisibilityOff();
+    assembly->AddPart(actor);
+    shownIn = assembly;
+}
+
+void LODProxy::hide()
+{
+    if(!isShown())
+        return;
+    shownIn->RemovePart(actor);
+    shownIn = nullptr;
+    for(auto prop : hiddenProps)
+        prop->VisibilityOn();
+    hiddenProps.clear();
+}
+
+bool LODProxy::isReady() const
+{
+    return mesh != nullptr && proxy != nullptr;
+}
+
+bool LODProxy::isShown() const
+{
+    return shownIn != nullptr;
+}
+
+std::shared_ptr<DrawableTriangleMesh> LODProxy::getMesh() const
+{
+    return mesh;
+}
+
+void LODProxy::setMesh(const std::shared_ptr<DrawableTriangleMesh> &newMesh)
+{
+    if(newMesh == mesh)
+        return;
+    hide();
+    mesh = newMesh;
+    setProxy(nullptr);
+}
+
+vtkSmartPointer<vtkPolyData> LODProxy::getProxy() const
+{
+    return proxy;
+}
+
+void LODProxy::setProxy(const vtkSmartPointer<vtkPolyData> &newProxy)
+{
+    hide();
+    proxy = newProxy;
+    colored = false;
+    actor = nullptr;
+    centroidsLocator = nullptr;
+    if(proxy == nullptr)
+        return;
+
+    auto mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    mapper->SetInputData(proxy);
+    mapper->SetScalarModeToUseCellData();
+    mapper->SetColorModeToDirectScalars();
+    actor = vtkSmartPointer<vtkActor>::New();
+    actor->SetMapper(mapper);
+    actor->PickableOff();
+
+    auto centroids = vtkSmartPointer<vtkPoints>::New();
+    centroids->SetNumberOfPoints(proxy->GetNumberOfCells());
+    auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+    for(vtkIdType i = 0; i < proxy->GetNumberOfCells(); i++)
+    {
+        double c[3];
+        centroid(proxy, i, cellPoints, c);
+        centroids->SetPoint(i, c);
+    }
+    auto centroidsData = vtkSmartPointer<vtkPolyData>::New();
+    centroidsData->SetPoints(centroids);
+    centroidsLocator = vtkSmartPointer<vtkPointLocator>::New();
+    centroidsLocator->SetDataSet(centroidsData);
+    centroidsLocator->BuildLocator();
+}
+
+std::shared_ptr<ChunkedSurface> LODProxy::getChunkedSurface() const
+{
+    return chunkedSurface;
+}
+
+void LODProxy::setChunkedSurface(const std::shared_ptr<ChunkedSurface> &newChunkedSurface)
+{
+    chunkedSurface = newChunkedSurface;
+}
+
+void LODProxy::updateColors(const vtkSmartPointer<vtkPolyData> &surface)
+{
+    vtkIdType cellsNumber = proxy->GetNumberOfCells();
+    auto colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    colors->SetName("Colors");
+    colors->SetNumberOfComponents(3);
+    colors->SetNumberOfTuples(cellsNumber);
+
+    //Each triangle of the proxy takes the colour of the triangle it comes from: its palette entry when the surface is
+    //coloured by a palette, its scalars otherwise
+    auto originalIds = vtkIdTypeArray::SafeDownCast(proxy->GetCellData()->GetArray(LODProxyBuilder::CELL_IDS_ARRAY_NAME));
+    auto surfaceColors = vtkUnsignedCharArray::SafeDownCast(surface->GetCellData()->GetScalars());
+    auto paletteIndices = vtkTypeUInt16Array::SafeDownCast(surface->GetCellData()->GetArray(CellPalette::ARRAY_NAME));
+    auto paletteTable = vtkLookupTable::SafeDownCast(mesh->getSurfaceActor()->GetMapper()->GetLookupTable());
+    bool usePalette = originalIds != nullptr && paletteIndices != nullptr && paletteTable != nullptr &&
+                      paletteIndices->GetNumberOfTuples() == surface->GetNumberOfCells();
+    double* actorColor = mesh->getSurfaceActor()->GetProperty()->GetColor();
+    unsigned char defaultColor[3] = {static_cast<unsigned char>(actorColor[0] * 255),
+                                     static_cast<unsigned char>(actorColor[1] * 255),
+                                     static_cast<unsigned char>(actorColor[2] * 255)};
+    bool useSurfaceColors = originalIds != nullptr && surfaceColors != nullptr && surfaceColors->GetNumberOfComponents() >= 3 &&
+                            surfaceColors->GetNumberOfTuples() == surface->GetNumberOfCells();
+    unsigned char* data = colors->GetPointer(0);
+    for(vtkIdType i = 0; i < cellsNumber; i++)
+    {
+        const unsigned char* color = defaultColor;
+        if(usePalette)
+        {
+            vtkIdType originalId = originalIds->GetValue(i);
+            if(originalId >= 0 && originalId < paletteIndices->GetNumberOfTuples())
+            {
+                vtkIdType index = paletteIndices->GetValue(originalId);
+                if(index < paletteTable->GetNumberOfTableValues())
+                    color = paletteTable->GetPointer(index);
+            }
+        } else if(useSurfaceColors)
+        {
+            vtkIdType originalId = originalIds->GetValue(i);
+            if(originalId >= 0 && originalId < surfaceColors->GetNumberOfTuples())
+                color = surfaceColors->GetPointer(originalId * surfaceColors->GetNumberOfComponents());
+        }
+        data[3 * i] = color[0];
+        data[3 * i + 1] = color[1];
+        data[3 * i + 2] = color[2];
+    }
+
+    //The triangles of the visible surface annotations paint the triangle of the proxy nearest to them
+    auto cellPoints = vtkSmartPointer<vtkIdList>::New();
+    for(auto annotation : mesh->getAnnotations())
+    {
+        auto surfaceAnnotation = dynamic_pointer_cast<DrawableSurfaceAnnotation>(annotation);
+        if(surfaceAnnotation == nullptr || !surfaceAnnotation->getDrawAnnotation())
+            continue;
+        unsigned char* color = annotation->getColor();
+        for(auto id : surfaceAnnotation->getTrianglesIds())
+        {
+            vtkIdType triangle = static_cast<vtkIdType>(toIndex(id));
+            if(triangle >= surface->GetNumberOfCells())
+                continue;
+            double c[3];
+            centroid(surface, triangle, cellPoints, c);
+            vtkIdType proxyTriangle = centroidsLocator->FindClosestPoint(c);
+            if(proxyTriangle < 0)
+                continue;
+            data[3 * proxyTriangle] = color[0];
+            data[3 * proxyTriangle + 1] = color[1];
+            data[3 * proxyTriangle + 2] = color[2];
+        }
+    }
+    proxy->GetCellData()->SetScalars(colors);
+    proxy->Modified();
+}
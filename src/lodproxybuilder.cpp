@@ -0,0 +1,120 @@
+#include "lodproxybuilder.hpp"
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPoints.h>
+#include <vtkQuadricClustering.h>
+
+#include <cmath>
+
+LODProxyBuilder::LODProxyBuilder(QObject *parent) : QThread(parent)
+{
+}
+
+LODProxyBuilder::~LODProxyBuilder()
+{
+    cancel();
+    wait();
+}
+
+bool LODProxyBuilder::needsProxy(const vtkSmartPointer<vtkPolyData> &surface)
+{
+    return surface != nullptr && surface->GetNumberOfPolys() >= MIN_TRIANGLES;
+}
+
+void LODProxyBuilder::build(const vtkSmartPointer<vtkPolyData> &surface)
+{
+    if(isRunning() || !needsProxy(surface))
+        return;
+
+    //The worker reads the points while the surface is rendered: their bounds are computed here, so that nothing
+    //is written in them on the worker
+    double bounds[6];
+    surface->GetPoints()->GetBounds(bounds);
+    input = vtkSmartPointer<vtkPolyData>::New();
+    input->SetPoints(surface->GetPoints());
+    auto polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->DeepCopy(surface->GetPolys());
+    input->SetPolys(polys);
+    auto cellIds = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellIds->SetName(CELL_IDS_ARRAY_NAME);
+    cellIds->SetNumberOfTuples(polys->GetNumberOfCells());
+    for(vtkIdType i = 0; i < polys->GetNumberOfCells(); i++)
+        cellIds->SetValue(i, i);
+    input->GetCellData()->AddArray(cellIds);
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        result = nullptr;
+    }
+    start();
+}
+
+void LODProxyBuilder::cancel()
+{
+    requestInterruption();
+}
+
+bool LODProxyBuilder::getCanceled() const
+{
+    return isInterruptionRequested();
+}
+
+vtkSmartPointer<vtkPolyData> LODProxyBuilder::takeResult()
+{
+    std::lock_guard<std::mutex> lock(resultMutex);
+    auto taken = result;
+    result = nullptr;
+    return taken;
+}
+
+void LODProxyBuilder::run()
+{
+    //The grid cells are sized on the area of the surface: about two triangles are left in each occupied cell
+    double area = 0;
+    auto polys = input->GetPolys();
+    auto points = input->GetPoints();
+    auto cell = vtkSmartPointer<vtkIdList>::New();
+    polys->InitTraversal();
+    for(vtkIdType i = 0; polys->GetNextCell(cell); i++)
+    {
+        if(i % 1000000 == 0 && isInterruptionRequested())
+            return;
+        if(cell->GetNumberOfIds() < 3)
+            continue;
+        double p0[3], p1[3], p2[3];
+        points->GetPoint(cell->GetId(0), p0);
+        points->GetPoint(cell->GetId(1), p1);
+        points->GetPoint(cell->GetId(2), p2);
+        double u[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        double v[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        double n[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+        area += std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) / 2;
+    }
+    if(area <= 0)
+        return;
+
+    double cellSize = std::sqrt(area / (TARGET_TRIANGLES / 2.0));
+    double bounds[6];
+    points->GetBounds(bounds);
+    int divisions[3];
+    for(int i = 0; i < 3; i++)
+    {
+        int axisDivisions = static_cast<int>(std::ceil((bounds[2 * i + 1] - bounds[2 * i]) / cellSize));
+        divisions[i] = axisDivisions < 1 ? 1 : (axisDivisions > MAX_DIVISIONS ? MAX_DIVISIONS : axisDivisions);
+    }
+
+    auto clustering = vtkSmartPointer<vtkQuadricClustering>::New();
+    clustering->SetInputData(input);
+    clustering->AutoAdjustNumberOfDivisionsOff();
+    clustering->SetNumberOfDivisions(divisions);
+    clustering->CopyCellDataOn();
+    clustering->Update();
+    input = nullptr;
+    if(isInterruptionRequested())
+        return;
+
+    std::lock_guard<std::mutex> lock(resultMutex);
+    result = clustering->GetOutput();
+}
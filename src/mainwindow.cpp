@@ -1,15 +1,17 @@
 #include "mainwindow.hpp"
 
 #include "./ui_mainwindow.h"
-#include <vtkDataSetMapper.h>
-#include <vtkPoints.h>
 #include <vtkPropAssembly.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderer.h>
-#include <vtkUnstructuredGrid.h>
 #include <vtkProperty.h>
-#include <vtkNamedColors.h>
 #include <vtkGenericOpenGLRenderWindow.h>
+#include <vtkCamera.h>
+#include <vtkCommand.h>
+#include <vtkMapper.h>
+#include <QTimer>
+#include <QScreen>
+#include <QGuiApplication>
 
 
 #include <drawablesurfaceannotation.hpp>
@@ -17,7 +19,6 @@
 #include <semanticsfilemanager.hpp>
 #include <QFileDialog>
 #include <vtkAreaPicker.h>
-#include <vtkIdFilter.h>
 #include <annotationdialog.hpp>
 #include <qmessagebox.h>
 #include <QInputDialog>
@@ -25,6 +26,7 @@
 #include <semanticattribute.hpp>
 
 #include "annotationselectioninteractorstyle.hpp"
+#include "binaryannotationfilemanager.hpp"
 #include "lineselectionstyle.hpp"
 #include "measurestyle.hpp"
 #include "triangleselectionstyle.hpp"
@@ -52,8 +54,30 @@ void MainWindow::init()
     annotationDialog = std::make_shared<AnnotationDialog>(this);
     relationshipDialog = std::make_shared<AnnotationsRelationshipDialog>(this);
     semanticAttributeDialog = std::make_shared<SemanticAttributeDialog>(this);
-    renderer = vtkSmartPointer<vtkRenderer>::New();
-    canvas = vtkSmartPointer<vtkPropAssembly>::New();
+    meshLoader = std::make_shared<MeshLoader>(this);
+    annotationLoader = std::make_shared<AnnotationLoader>(this);
+    annotationJournal = std::make_shared<AnnotationJournal>();
+    relationships = std::make_shared<BinaryRelationshipStore>();
+    tileManager = std::make_shared<TileManager>();
+    //The renderer, the canvas and the cache belong to the scene and live as long as the window
+    scene = std::make_shared<ViewerScene>();
+    scene->attach(this->ui->meshViewer->renderWindow());
+    renderer = scene->getRenderer();
+    canvas = scene->getCanvas();
+    sceneCache = scene->getSceneCache();
+    cellPalette = std::make_shared<CellPalette>();
+    sceneCache->setPalette(cellPalette);
+    renderScheduler = std::make_shared<RenderScheduler>(this);
+    lodBuilder = std::make_shared<LODProxyBuilder>(this);
+    lodProxy = std::make_shared<LODProxy>();
+    lodProxy->setChunkedSurface(sceneCache->getChunkedSurface());
+    lodSettleTimer = std::make_shared<QTimer>(this);
+    lodSettleTimer->setSingleShot(true);
+    lodSettleTimer->setInterval(LOD_SETTLE_TIME);
+    //One render per frame of the display the window starts on
+    if(QGuiApplication::primaryScreen() != nullptr && QGuiApplication::primaryScreen()->refreshRate() > 0)
+        renderScheduler->setFrameInterval(static_cast<int>(1000 / QGuiApplication::primaryScreen()->refreshRate()));
+    cameraConnections = vtkSmartPointer<vtkEventQtSlotConnect>::New();
 
     verticesSelectionStyle = vtkSmartPointer<VerticesSelectionStyle>::New();
     linesSelectionStyle = vtkSmartPointer<LineSelectionStyle>::New();
@@ -67,13 +91,16 @@ void MainWindow::init()
     selectVertices = false;
     selectEdges = false;
     selectTrianglesWithLasso = false;
+    selectTrianglesFreehand = false;
     selectAnnotations = false;
     this->setWindowTitle("CityViewer");
     reachedId = 0;
+    activeTile = -1;
 
     connect(verticesSelectionStyle, SIGNAL(updateView()), this, SLOT(slotUpdateView()));
     connect(linesSelectionStyle, SIGNAL(updateView()), this, SLOT(slotUpdateView()));
     connect(trianglesSelectionStyle, SIGNAL(updateView()), this, SLOT(slotUpdateView()));
+    connect(annotationsSelectionStyle, SIGNAL(annotationViewChanged(std::string)), this, SLOT(slotAnnotationViewChanged(std::string)));
     connect(annotationsSelectionStyle, SIGNAL(updateView()), this, SLOT(slotUpdateView()));
     connect(measureStyle, SIGNAL(updateView()), this, SLOT(slotUpdateView()));
     connect(annotationDialog.get(), SIGNAL(finalizationCalled(std::string, uchar*)), this, SLOT(slotFinalization(std::string, uchar*)));
@@ -81,60 +108,71 @@ void MainWindow::init()
     connect(semanticAttributeDialog.get(), SIGNAL(textFinalized(std::string, std::string)), this, SLOT(slotAddSemanticAttribute(std::string, std::string)));
     connect(ui->measuresListWidget, SIGNAL(updateSignal()), this, SLOT(slotUpdate()));
     connect(ui->measuresListWidget, SIGNAL(updateViewSignal()), this, SLOT(slotUpdateView()));
+    connect(ui->measuresListWidget, SIGNAL(annotationChanged(std::string)), this, SLOT(slotAnnotationChanged(std::string)));
+    connect(ui->measuresListWidget, SIGNAL(annotationRemoved(std::string)), this, SLOT(slotAnnotationRemoved(std::string)));
+    connect(ui->measuresListWidget, SIGNAL(annotationViewChanged(std::string)), this, SLOT(slotAnnotationViewChanged(std::string)));
+    connect(ui->measuresListWidget, SIGNAL(attributeViewChanged(std::string, unsigned int)), this, SLOT(slotAttributeViewChanged(std::string, unsigned int)));
+    connect(meshLoader.get(), SIGNAL(loadingFailed(QString)), this, SLOT(slotMeshLoadingFailed(QString)));
+    connect(meshLoader.get(), SIGNAL(finished()), this, SLOT(slotMeshLoaded()));
+    connect(annotationLoader.get(), SIGNAL(batchLoaded()), this, SLOT(slotAnnotationsBatchLoaded()));
+    connect(annotationLoader.get(), SIGNAL(progressChanged(int)), this, SLOT(slotAnnotationsLoadingProgress(int)));
+    connect(annotationLoader.get(), SIGNAL(loadingFailed(QString)), this, SLOT(slotAnnotationsLoadingFailed(QString)));
+    connect(annotationLoader.get(), SIGNAL(finished()), this, SLOT(slotAnnotationsLoaded()));
+    connect(renderScheduler.get(), SIGNAL(render()), this, SLOT(slotRender()));
+    connect(lodBuilder.get(), SIGNAL(finished()), this, SLOT(slotLODProxyBuilt()));
+    connect(lodSettleTimer.get(), SIGNAL(timeout()), this, SLOT(slotInteractionSettled()));
+    connect(tileManager.get(), SIGNAL(tileLoaded(unsigned int)), this, SLOT(slotTileLoaded(unsigned int)));
+    connect(tileManager.get(), SIGNAL(tileEvicted(unsigned int)), this, SLOT(slotTileEvicted(unsigned int)));
+    connect(tileManager.get(), SIGNAL(loadingFailed(QString)), this, SLOT(slotTileLoadingFailed(QString)));
+
+    //Whatever the interaction style, the camera may have moved once one of these events has been handled
+    auto interactor = ui->meshViewer->interactor();
+    cameraConnections->Connect(interactor, vtkCommand::LeftButtonReleaseEvent, this, SLOT(slotCameraMoved()));
+    cameraConnections->Connect(interactor, vtkCommand::MiddleButtonReleaseEvent, this, SLOT(slotCameraMoved()));
+    cameraConnections->Connect(interactor, vtkCommand::RightButtonReleaseEvent, this, SLOT(slotCameraMoved()));
+    cameraConnections->Connect(interactor, vtkCommand::MouseWheelForwardEvent, this, SLOT(slotCameraMoved()));
+    cameraConnections->Connect(interactor, vtkCommand::MouseWheelBackwardEvent, this, SLOT(slotCameraMoved()));
+
+    //The proxy of the mesh is drawn while any of the styles moves the camera
+    std::vector<vtkObject*> styles = {verticesSelectionStyle, linesSelectionStyle, trianglesSelectionStyle, annotationsSelectionStyle, measureStyle};
+    for(auto style : styles)
+    {
+        cameraConnections->Connect(style, vtkCommand::StartInteractionEvent, this, SLOT(slotInteractionStarted()));
+        cameraConnections->Connect(style, vtkCommand::EndInteractionEvent, this, SLOT(slotInteractionEnded()));
+    }
 
 }
 
 MainWindow::~MainWindow()
 {
+    cameraConnections->Disconnect();
+    lodBuilder->cancel();
+    lodBuilder->wait();
+    tileManager->close();
     delete ui;
 }
 
 void MainWindow::draw()
 {
-    renderer = vtkSmartPointer<vtkRenderer>::New();
-    canvas = vtkSmartPointer<vtkPropAssembly>::NewInstance(canvas);
-    linesSelectionStyle->setRen(renderer);
-    trianglesSelectionStyle->setRen(renderer);
+    //The content is replaced in place: what is still there (e.g. the surface when annotations are loaded) is kept
+    lodProxy->hide();
+    scene->setContent(currentMesh);
     drawMesh();
     slotUpdateView();
 }
 
 void MainWindow::drawMesh()
 {
-
-    if(currentMesh != nullptr)
-    {
-        currentMesh->setDrawAnnotations(true);
-        currentMesh->setDrawWireframe(false);
-        currentMesh->draw(canvas);
-    } else
-    {
-
-        vtkNew<vtkNamedColors> colors;
-        vtkNew<vtkPoints> points;
-        points->InsertNextPoint(1, 0, 0);
-        points->InsertNextPoint(0, 1, 0);
-        points->InsertNextPoint(0, 0, 1);
-        points->InsertNextPoint(-1, -1, 0);
-        vtkNew<vtkUnstructuredGrid> unstructuredGrid1;
-        unstructuredGrid1->SetPoints(points);
-
-        vtkIdType ptIds[] = {0, 1, 2, 3};
-        unstructuredGrid1->InsertNextCell(VTK_TETRA, 4, ptIds);
-        vtkNew<vtkDataSetMapper> mapper1;
-        mapper1->SetInputData(unstructuredGrid1);
-
-        vtkNew<vtkActor> actor1;
-        actor1->SetMapper(mapper1);
-        actor1->GetProperty()->SetColor(colors->GetColor3d("Cyan").GetData());
-        canvas->AddPart(actor1);
-    }
-
-
+    //Without a mesh the tiles of a closed city are removed as well
+    scene->setPlaceholderVisible(currentMesh == nullptr && !tileManager->isOpen());
+    drawTiles();
+    scene->update();
 }
 
 void MainWindow::on_clearCanvasButton_clicked()
 {
+    tileManager->close();
+    activeTile = -1;
     currentMesh.reset();
     draw();
     update();
@@ -150,6 +188,11 @@ void MainWindow::setCurrentMesh(const std::shared_ptr<DrawableTriangleMesh> &new
     currentMesh = newCurrentMesh;
 }
 
+const std::shared_ptr<RenderScheduler> &MainWindow::getRenderScheduler() const
+{
+    return renderScheduler;
+}
+
 void MainWindow::openContextualMenu(vtkObject *obj, unsigned long, void *, void *)
 {
     QMenu contextMenu(tr("Context menu"), this);
@@ -162,77 +205,108 @@ void MainWindow::openContextualMenu(vtkObject *obj, unsigned long, void *, void
 
 void MainWindow::on_actionOpenMesh_triggered()
 {
+    if(meshLoader->isRunning())
+        return;
+
     QString filename = QFileDialog::getOpenFileName(nullptr,
                        "Choose an annotation file",
                        QString::fromStdString(currentPath),
                        "PLY(*.ply);;All(*.*)");
 
     if (!filename.isEmpty()){
-        currentMesh.reset();
-        currentMesh = std::make_shared<DrawableTriangleMesh>();
-        currentMesh->load(filename.toStdString());
-
-        vtkSmartPointer<vtkIdFilter> verticesIdFilter = vtkSmartPointer<vtkIdFilter>::New();
-        verticesIdFilter->SetInputData(currentMesh->getPointsActor()->GetMapper()->GetInputAsDataSet());
-        verticesIdFilter->PointIdsOn();
-        verticesIdFilter->SetPointIdsArrayName("OriginalMeshIds");
-        verticesIdFilter->Update();
-
-        vtkSmartPointer<vtkPolyData> inputPoints = static_cast<vtkPolyData*>(verticesIdFilter->GetOutput());
-        verticesSelectionStyle->setVisiblePointsOnly(selectOnlyVisible);
-        verticesSelectionStyle->setSelectionMode(!eraseSelected);
-        verticesSelectionStyle->setMesh(currentMesh);
-        verticesSelectionStyle->setAssembly(canvas);
-        verticesSelectionStyle->setPoints(inputPoints);
-        verticesSelectionStyle->setQvtkwidget(ui->meshViewer);
-        verticesSelectionStyle->setRenderer(renderer);
-
-        vtkSmartPointer<vtkIdFilter> linesIdFilter = vtkSmartPointer<vtkIdFilter>::New();
-        linesIdFilter->SetInputData(currentMesh->getSurfaceActor()->GetMapper()->GetInputAsDataSet());
-        linesIdFilter->PointIdsOn();
-        linesIdFilter->SetPointIdsArrayName("OriginalMeshIds");
-        linesIdFilter->Update();
+        loadingDialog = std::make_shared<QProgressDialog>("Loading " + QFileInfo(filename).fileName() + "...", "Cancel", 0, 100, this);
+        loadingDialog->setWindowModality(Qt::WindowModal);
+        loadingDialog->setMinimumDuration(0);
+        loadingDialog->setAutoClose(false);
+        connect(meshLoader.get(), SIGNAL(progressChanged(int)), loadingDialog.get(), SLOT(setValue(int)));
+        connect(loadingDialog.get(), SIGNAL(canceled()), meshLoader.get(), SLOT(cancel()));
+        meshLoader->load(filename.toStdString());
+    }
+}
 
-        vtkSmartPointer<vtkPolyData> inputEdges = static_cast<vtkPolyData*>(linesIdFilter->GetOutput());
-        linesSelectionStyle->setVisiblePointsOnly(selectOnlyVisible);
-        linesSelectionStyle->setSelectionMode(!eraseSelected);
-        linesSelectionStyle->setMesh(currentMesh);
-        linesSelectionStyle->setAssembly(canvas);
-        linesSelectionStyle->setPoints(inputEdges);
-        linesSelectionStyle->setQvtkwidget(ui->meshViewer);
-        linesSelectionStyle->setRen(renderer);
+void MainWindow::slotMeshLoaded()
+{
+    if(loadingDialog != nullptr)
+    {
+        loadingDialog->hide();
+        loadingDialog.reset();
+    }
+    auto loaded = meshLoader->takeResult();
+    if(meshLoader->getCanceled() || loaded.mesh == nullptr || loaded.idDataset == nullptr)
+        return;
+
+    //Annotations still streaming in belong to the previous mesh
+    annotationLoader->cancel();
+    annotationLoader->wait();
+    annotationLoader->takeBatch();
+    annotationJournal->detach();
+    tileManager->close();
+    activeTile = -1;
+
+    //Everything has been built by the loader: the swap happens here, before any rendering
+    currentMesh = loaded.mesh;
+    idDataset = loaded.idDataset;
+    meshCache = loaded.cache;
+    resetRelationships();
+    setupInteractorStyles();
+    update();
+    draw();
+    buildLODProxy();
+}
 
-        vtkSmartPointer<vtkIdFilter> trianglesIdFilter = vtkSmartPointer<vtkIdFilter>::New();
-        verticesIdFilter->SetInputData(currentMesh->getSurfaceActor()->GetMapper()->GetInputAsDataSet());
-        verticesIdFilter->CellIdsOn();
-        verticesIdFilter->SetPointIdsArrayName("OriginalMeshIds");
-        verticesIdFilter->Update();
+void MainWindow::slotMeshLoadingFailed(QString message)
+{
+    auto dialog = new QMessageBox(this);
+    dialog->setWindowTitle("Error");
+    dialog->setText("Unable to load the mesh: " + message);
+    dialog->show();
+}
 
-        vtkSmartPointer<vtkPolyData> inputTriangles = static_cast<vtkPolyData*>(verticesIdFilter->GetOutput());
-        trianglesSelectionStyle->setMesh(currentMesh);
-        trianglesSelectionStyle->setAssembly(canvas);
-        trianglesSelectionStyle->SetTriangles(inputTriangles);
-        trianglesSelectionStyle->setQvtkWidget(ui->meshViewer);
-        trianglesSelectionStyle->setRen(renderer);
+void MainWindow::setupInteractorStyles()
+{
+    verticesSelectionStyle->setMeshCache(meshCache);
+    linesSelectionStyle->setMeshCache(meshCache);
+    trianglesSelectionStyle->setMeshCache(meshCache);
+    trianglesSelectionStyle->setPalette(cellPalette);
+    annotationsSelectionStyle->setMeshCache(meshCache);
+    measureStyle->setMeshCache(meshCache);
+
+    verticesSelectionStyle->setVisiblePointsOnly(selectOnlyVisible);
+    verticesSelectionStyle->setSelectionMode(!eraseSelected);
+    verticesSelectionStyle->setMesh(currentMesh);
+    verticesSelectionStyle->setAssembly(canvas);
+    verticesSelectionStyle->setIdDataset(idDataset);
+    verticesSelectionStyle->setQvtkwidget(ui->meshViewer);
+    verticesSelectionStyle->setRenderer(renderer);
+
+    linesSelectionStyle->setVisiblePointsOnly(selectOnlyVisible);
+    linesSelectionStyle->setSelectionMode(!eraseSelected);
+    linesSelectionStyle->setMesh(currentMesh);
+    linesSelectionStyle->setAssembly(canvas);
+    linesSelectionStyle->setIdDataset(idDataset);
+    linesSelectionStyle->setQvtkwidget(ui->meshViewer);
+    linesSelectionStyle->setRen(renderer);
 
-        annotationsSelectionStyle->setMesh(currentMesh);
-        annotationsSelectionStyle->setAssembly(canvas);
-        annotationsSelectionStyle->setQvtkWidget(ui->meshViewer);
-        annotationsSelectionStyle->setRen(renderer);
+    trianglesSelectionStyle->setMesh(currentMesh);
+    trianglesSelectionStyle->setAssembly(canvas);
+    trianglesSelectionStyle->setIdDataset(idDataset);
+    trianglesSelectionStyle->setQvtkWidget(ui->meshViewer);
+    trianglesSelectionStyle->setRen(renderer);
 
-        measureStyle->setMeasureAssembly(canvas);
-        measureStyle->setMesh(currentMesh);
-        measureStyle->setMeshRenderer(renderer);
-        measureStyle->setQvtkwidget(this->ui->meshViewer);
+    annotationsSelectionStyle->setMesh(currentMesh);
+    annotationsSelectionStyle->setAssembly(canvas);
+    annotationsSelectionStyle->setQvtkWidget(ui->meshViewer);
+    annotationsSelectionStyle->setRen(renderer);
 
-        linesSelectionStyle->resetSelection();
-        trianglesSelectionStyle->resetSelection();
-        annotationsSelectionStyle->resetSelection();
-        measureStyle->reset();
+    measureStyle->setMeasureAssembly(canvas);
+    measureStyle->setMesh(currentMesh);
+    measureStyle->setMeshRenderer(renderer);
+    measureStyle->setQvtkwidget(this->ui->meshViewer);
 
-        update();
-        draw();
-    }
+    linesSelectionStyle->resetSelection();
+    trianglesSelectionStyle->resetSelection();
+    annotationsSelectionStyle->resetSelection();
+    measureStyle->reset();
 }
 
 
@@ -241,9 +315,26 @@ void MainWindow::on_actionOpenAnnotations_triggered()
     QString filename = QFileDialog::getOpenFileName(nullptr,
          "Choose an annotation file",
          QString::fromStdString(currentPath),
-         "ANT(*.ant);;FCT(*.fct);;TRIANT(*.triant);;All(*.*)");
+         "ANT(*.ant);;FCT(*.fct);;TRIANT(*.triant);;BANT(*.bant);;All(*.*)");
     if(!filename.isEmpty() && currentMesh != nullptr)
     {
+        if(annotationLoader->isRunning())
+            return;
+        if(BinaryAnnotationFileManager::isBinaryAnnotationFile(filename.toStdString()))
+        {
+            //Binary files are streamed: the annotations show up batch by batch (see slotAnnotationsBatchLoaded)
+            currentMesh->clearAnnotations();
+            reachedId = 0;
+            resetRelationships();
+            //Changes made from now on go to the journal, which is replayed once the file is loaded
+            annotationJournal->attach(filename.toStdString(), currentMesh, true);
+            this->ui->measuresListWidget->setMesh(currentMesh);
+            this->ui->measuresListWidget->update();
+            draw();
+            annotationLoader->load(filename.toStdString(), currentMesh);
+            return;
+        }
+        annotationJournal->detach();
         SemantisedTriangleMesh::SemanticsFileManager manager;
         manager.setMesh(currentMesh);
         auto annotations = manager.readAndStoreAnnotations(filename.toStdString());
@@ -269,21 +360,280 @@ void MainWindow::on_actionOpenAnnotations_triggered()
 }
 
 
+void MainWindow::slotAnnotationsBatchLoaded()
+{
+    auto batch = annotationLoader->takeBatch();
+    if(batch.empty() || annotationLoader->getMesh() != currentMesh)
+        return;
+    //The worker only decoded the records: the annotations are built here, where the mesh lives
+    BinaryAnnotationFileManager manager;
+    manager.setMesh(currentMesh);
+    auto annotations = manager.buildAnnotations(batch);
+    if(!manager.getError().empty())
+    {
+        annotationLoader->cancel();
+        slotAnnotationsLoadingFailed(QString::fromStdString(manager.getError()));
+        return;
+    }
+    for(auto annotation : annotations)
+        currentMesh->addAnnotation(annotation);
+    updateReachedId();
+    draw();
+}
+
+void MainWindow::slotAnnotationsLoaded()
+{
+    slotAnnotationsBatchLoaded();
+    this->ui->statusbar->clearMessage();
+    if(annotationLoader->getMesh() != currentMesh)
+        return;
+    //Recover what has been changed after the last compaction of the file
+    auto records = annotationLoader->takeRelationships();
+    if(annotationJournal->getMainFilename() == annotationLoader->getFilename())
+        annotationJournal->replay(records);
+    //Resolved against the annotations only when they are needed
+    for(auto record : records)
+        relationships->addRelationship(record);
+    updateReachedId();
+    draw();
+    //The measures list is rebuilt once, when everything has arrived
+    this->ui->measuresListWidget->setMesh(currentMesh);
+    this->ui->measuresListWidget->update();
+    update();
+}
+
+void MainWindow::slotAnnotationsLoadingProgress(int progress)
+{
+    this->ui->statusbar->showMessage("Loading annotations: " + QString::number(progress) + "%");
+}
+
+void MainWindow::slotAnnotationsLoadingFailed(QString message)
+{
+    auto dialog = new QMessageBox(this);
+    dialog->setWindowTitle("Error");
+    dialog->setText("Unable to load the annotations: " + message);
+    dialog->show();
+}
+
+void MainWindow::slotAnnotationChanged(std::string id)
+{
+    annotationJournal->recordAnnotation(currentMesh->getAnnotation(toIndex(id)));
+    sceneCache->markAnnotationDirty(id);
+}
+
+void MainWindow::slotAnnotationRemoved(std::string id)
+{
+    annotationJournal->recordAnnotationRemoval(id);
+}
+
+void MainWindow::slotAnnotationViewChanged(std::string id)
+{
+    sceneCache->markAnnotationViewDirty(id);
+}
+
+void MainWindow::slotAttributeViewChanged(std::string annotationId, unsigned int attributeId)
+{
+    sceneCache->markAttributeDirty(annotationId, attributeId);
+}
+
+void MainWindow::updateReachedId()
+{
+    reachedId = 0;
+    for(auto annotation : currentMesh->getAnnotations())
+        reachedId = std::max(reachedId, toIndex(annotation->getId()) + 1);
+}
+
+void MainWindow::on_actionOpenCityTiles_triggered()
+{
+    QStringList filenames = QFileDialog::getOpenFileNames(nullptr,
+                            "Choose the tiles of the city",
+                            QString::fromStdString(currentPath),
+                            "PLY(*.ply);;All(*.*)");
+    if(filenames.isEmpty())
+        return;
+
+    currentPath = QFileInfo(filenames.first()).absolutePath().toStdString();
+    std::vector<std::string> tiles;
+    for(auto filename : filenames)
+        tiles.push_back(filename.toStdString());
+
+    //A mesh still loading is discarded: its late finished() then finds no result to swap in
+    meshLoader->cancel();
+    meshLoader->wait();
+    meshLoader->takeResult();
+    annotationLoader->cancel();
+    annotationLoader->wait();
+    annotationLoader->takeBatch();
+    annotationJournal->detach();
+    currentMesh.reset();
+    idDataset.reset();
+    meshCache.reset();
+    resetRelationships();
+    activeTile = -1;
+
+    if(!tileManager->open(tiles))
+        return;
+
+    //The whole city is framed, the tiles nearest to the camera are then paged in
+    draw();
+    double bounds[6];
+    tileManager->getBounds(bounds);
+    scene->resetCamera(bounds);
+    slotUpdateTiles();
+}
+
+void MainWindow::slotTileLoaded(unsigned int id)
+{
+    //The notification may come from tiles that have been closed meanwhile
+    auto tile = tileManager->getTile(id);
+    if(tile == nullptr || tile->mesh == nullptr)
+        return;
+    if(activeTile < 0)
+        activateTile(tile);
+    else
+        slotUpdateView();
+}
+
+void MainWindow::slotTileEvicted(unsigned int id)
+{
+    //The active tile is pinned, so it is never the evicted one
+    if(static_cast<int>(id) != activeTile)
+        slotUpdateView();
+}
+
+void MainWindow::slotTileLoadingFailed(QString message)
+{
+    auto dialog = new QMessageBox(this);
+    dialog->setWindowTitle("Error");
+    dialog->setText(message);
+    dialog->show();
+}
+
+void MainWindow::slotCameraMoved()
+{
+    //The interactor style may handle the event after this slot: the camera is read once it has done
+    if(tileManager->isOpen())
+        QTimer::singleShot(0, this, SLOT(slotUpdateTiles()));
+}
+
+void MainWindow::slotUpdateTiles()
+{
+    if(!tileManager->isOpen())
+        return;
+
+    auto camera = renderer->GetActiveCamera();
+    tileManager->update(camera->GetPosition());
+
+    //Annotations go to the tile the user is looking at
+    auto nearest = tileManager->getNearestResidentTile(camera->GetFocalPoint());
+    if(nearest != nullptr && static_cast<int>(nearest->id) != activeTile)
+        activateTile(nearest);
+}
+
+void MainWindow::activateTile(const std::shared_ptr<TileManager::Tile> &tile)
+{
+    annotationJournal->detach();
+
+    activeTile = static_cast<int>(tile->id);
+    tileManager->setPinnedTile(activeTile);
+    currentMesh = tile->mesh;
+    idDataset = tile->idDataset;
+    meshCache = tile->meshCache;
+    resetRelationships();
+    setupInteractorStyles();
+    updateReachedId();
+    this->ui->measuresListWidget->setMesh(currentMesh);
+    this->ui->measuresListWidget->update();
+    this->ui->statusbar->showMessage("Annotating " + QFileInfo(QString::fromStdString(tile->filename)).fileName());
+    slotUpdateView();
+    buildLODProxy();
+}
+
+void MainWindow::buildLODProxy()
+{
+    //The proxy of the previous mesh is dropped here, or its late finished() would install it
+    lodBuilder->cancel();
+    lodBuilder->wait();
+    lodBuilder->takeResult();
+    lodProxy->setMesh(currentMesh);
+    if(currentMesh == nullptr || currentMesh->getSurfaceActor() == nullptr || currentMesh->getSurfaceActor()->GetMapper() == nullptr)
+        return;
+    vtkSmartPointer<vtkPolyData> surface = vtkPolyData::SafeDownCast(currentMesh->getSurfaceActor()->GetMapper()->GetInputAsDataSet());
+    if(LODProxyBuilder::needsProxy(surface))
+        lodBuilder->build(surface);
+}
+
+void MainWindow::slotLODProxyBuilt()
+{
+    //A build started after this one has finished is the one that counts
+    if(lodBuilder->isRunning())
+        return;
+    auto proxy = lodBuilder->takeResult();
+    if(lodBuilder->getCanceled() || proxy == nullptr)
+        return;
+    lodProxy->setProxy(proxy);
+}
+
+void MainWindow::slotInteractionStarted()
+{
+    lodSettleTimer->stop();
+    lodProxy->show(canvas, sceneCache->getVersion());
+}
+
+void MainWindow::slotInteractionEnded()
+{
+    //A wheel step is an interaction of its own: the full mesh comes back only once the camera has stopped
+    if(lodProxy->isShown())
+        lodSettleTimer->start();
+}
+
+void MainWindow::slotInteractionSettled()
+{
+    lodProxy->hide();
+    slotUpdateView();
+}
+
+void MainWindow::drawTiles()
+{
+    std::vector<std::shared_ptr<DrawableTriangleMesh> > meshes;
+    for(auto tile : tileManager->getResidentTiles())
+        meshes.push_back(tile->mesh);
+    sceneCache->setBackgroundMeshes(meshes);
+}
+
 void MainWindow::on_actionSaveAnnotations_triggered()
 {
     QString filename = QFileDialog::getSaveFileName(nullptr,
                      "Save the annotations on the mesh",
                      QString::fromStdString(currentPath),
-                     "ANT(*.ant);;FCT(*.fct);;TRIANT(*.triant);;M(*.m)");
+                     "ANT(*.ant);;FCT(*.fct);;TRIANT(*.triant);;BANT(*.bant);;M(*.m)");
 
     if (!filename.isEmpty()){
 
       QFileInfo info(filename);
       currentPath = info.absolutePath().toStdString();
-      SemantisedTriangleMesh::SemanticsFileManager manager;
-      manager.setMesh(currentMesh);
-      if(!manager.writeAnnotations(filename.toStdString()))
-          std::cout << "Something went wrong during annotation file writing." << std::endl << std::flush;
+      if(BinaryAnnotationFileManager::isBinaryAnnotationFile(filename.toStdString()))
+      {
+          //Saving onto the journaled file only needs the journal to be compacted
+          if(annotationJournal->isAttached() && annotationJournal->getMainFilename() == filename.toStdString())
+          {
+              annotationJournal->compact();
+              return;
+          }
+          BinaryAnnotationFileManager manager;
+          manager.setMesh(currentMesh);
+          manager.setRelationships(relationships->getRecords());
+          if(!manager.writeAnnotations(filename.toStdString()))
+              std::cout << "Something went wrong during annotation file writing: " << manager.getError() << std::endl << std::flush;
+          else
+              annotationJournal->attach(filename.toStdString(), currentMesh, false);
+      } else
+      {
+          SemantisedTriangleMesh::SemanticsFileManager manager;
+          manager.setMesh(currentMesh);
+          if(!manager.writeAnnotations(filename.toStdString()))
+              std::cout << "Something went wrong during annotation file writing." << std::endl << std::flush;
+      }
     }
 }
 
@@ -311,13 +661,6 @@ void MainWindow::on_actionVerticesSelection_triggered(bool checked)
     {
         this->selectEdges = false;
         this->selectAnnotations = false;
-        vtkSmartPointer<vtkIdFilter> idFilter = vtkSmartPointer<vtkIdFilter>::New();
-        idFilter->SetInputData(currentMesh->getPointsActor()->GetMapper()->GetInputAsDataSet());
-        idFilter->PointIdsOn();
-        idFilter->SetPointIdsArrayName("OriginalMeshIds");
-        idFilter->Update();
-
-        vtkSmartPointer<vtkPolyData> inputPoints = static_cast<vtkPolyData*>(idFilter->GetOutput());
         verticesSelectionStyle->setVisiblePointsOnly(selectOnlyVisible);
         verticesSelectionStyle->setSelectionMode(!eraseSelected);
         verticesSelectionStyle->setAssembly(canvas);
@@ -330,6 +673,7 @@ void MainWindow::on_actionVerticesSelection_triggered(bool checked)
         this->ui->actionLinesSelection->setChecked(false);
         this->ui->actionTrianglesRectangleSelection->setChecked(false);
         this->ui->actionTrianglesLassoSelection->setChecked(false);
+        this->ui->actionTrianglesFreehandSelection->setChecked(false);
         this->ui->actionSelectAnnotations->setChecked(false);
         this->ui->actionRulerMeasure->setChecked(false);
         this->ui->actionMeasureTape->setChecked(false);
@@ -348,13 +692,6 @@ void MainWindow::on_actionLinesSelection_triggered(bool checked)
         this->selectVertices = false;
         this->selectAnnotations = false;
 
-        vtkSmartPointer<vtkIdFilter> idFilter = vtkSmartPointer<vtkIdFilter>::New();
-        idFilter->SetInputData(currentMesh->getSurfaceActor()->GetMapper()->GetInputAsDataSet());
-        idFilter->PointIdsOn();
-        idFilter->SetPointIdsArrayName("OriginalMeshIds");
-        idFilter->Update();
-
-        vtkSmartPointer<vtkPolyData> inputEdges = static_cast<vtkPolyData*>(idFilter->GetOutput());
         linesSelectionStyle->setVisiblePointsOnly(selectOnlyVisible);
         linesSelectionStyle->setSelectionMode(!eraseSelected);
         linesSelectionStyle->setAssembly(canvas);
@@ -366,6 +703,7 @@ void MainWindow::on_actionLinesSelection_triggered(bool checked)
         this->ui->actionVerticesSelection->setChecked(false);
         this->ui->actionTrianglesRectangleSelection->setChecked(false);
         this->ui->actionTrianglesLassoSelection->setChecked(false);
+        this->ui->actionTrianglesFreehandSelection->setChecked(false);
         this->ui->actionSelectAnnotations->setChecked(false);
         this->ui->actionRulerMeasure->setChecked(false);
         this->ui->actionMeasureTape->setChecked(false);
@@ -387,15 +725,9 @@ void MainWindow::on_actionTrianglesRectangleSelection_triggered(bool checked)
         this->selectEdges = false;
         this->selectAnnotations = false;
 
-        vtkSmartPointer<vtkIdFilter> idFilter = vtkSmartPointer<vtkIdFilter>::New();
-        idFilter->SetInputData(currentMesh->getSurfaceActor()->GetMapper()->GetInputAsDataSet());
-        idFilter->CellIdsOn();
-        idFilter->SetPointIdsArrayName("OriginalMeshIds");
-        idFilter->Update();
-
-        vtkSmartPointer<vtkPolyData> inputTriangles = static_cast<vtkPolyData*>(idFilter->GetOutput());
         trianglesSelectionStyle->setVisibleTrianglesOnly(selectOnlyVisible);
         trianglesSelectionStyle->setSelectionMode(!eraseSelected);
+        selectTrianglesFreehand = false;
         trianglesSelectionStyle->setSelectionType(TriangleSelectionStyle::SelectionType::RECTANGLE_AREA);
         trianglesSelectionStyle->setAssembly(canvas);
         trianglesSelectionStyle->setQvtkWidget(ui->meshViewer);
@@ -408,6 +740,7 @@ void MainWindow::on_actionTrianglesRectangleSelection_triggered(bool checked)
         this->ui->actionVerticesSelection->setChecked(false);
         this->ui->actionLinesSelection->setChecked(false);
         this->ui->actionTrianglesLassoSelection->setChecked(false);
+        this->ui->actionTrianglesFreehandSelection->setChecked(false);
         this->ui->actionSelectAnnotations->setChecked(false);
         this->ui->actionRulerMeasure->setChecked(false);
         this->ui->actionMeasureTape->setChecked(false);
@@ -428,15 +761,9 @@ void MainWindow::on_actionTrianglesLassoSelection_triggered(bool checked)
         this->selectEdges = false;
         this->selectAnnotations = false;
 
-        vtkSmartPointer<vtkIdFilter> idFilter = vtkSmartPointer<vtkIdFilter>::New();
-        idFilter->SetInputData(currentMesh->getSurfaceActor()->GetMapper()->GetInputAsDataSet());
-        idFilter->CellIdsOn();
-        idFilter->SetPointIdsArrayName("OriginalMeshIds");
-        idFilter->Update();
-
-        vtkSmartPointer<vtkPolyData> inputTriangles = static_cast<vtkPolyData*>(idFilter->GetOutput());
         trianglesSelectionStyle->setVisibleTrianglesOnly(selectOnlyVisible);
         trianglesSelectionStyle->setSelectionMode(!eraseSelected);
+        selectTrianglesFreehand = false;
         trianglesSelectionStyle->setSelectionType(TriangleSelectionStyle::SelectionType::LASSO_AREA);
         trianglesSelectionStyle->setAssembly(canvas);
         trianglesSelectionStyle->setQvtkWidget(ui->meshViewer);
@@ -450,6 +777,7 @@ void MainWindow::on_actionTrianglesLassoSelection_triggered(bool checked)
         this->ui->actionLinesSelection->setChecked(false);
         linesSelectionStyle->resetSelection();
         this->ui->actionTrianglesRectangleSelection->setChecked(false);
+        this->ui->actionTrianglesFreehandSelection->setChecked(false);
         this->ui->actionSelectAnnotations->setChecked(false);
         annotationsSelectionStyle->resetSelection();
         this->ui->actionRulerMeasure->setChecked(false);
@@ -461,6 +789,38 @@ void MainWindow::on_actionTrianglesLassoSelection_triggered(bool checked)
 
 
 
+void MainWindow::on_actionTrianglesFreehandSelection_triggered(bool checked)
+{
+    selectTrianglesFreehand = checked;
+    if(checked)
+    {
+        this->selectVertices = false;
+        this->selectEdges = false;
+        this->selectAnnotations = false;
+        selectTrianglesWithLasso = false;
+
+        trianglesSelectionStyle->setVisibleTrianglesOnly(selectOnlyVisible);
+        trianglesSelectionStyle->setSelectionMode(!eraseSelected);
+        trianglesSelectionStyle->setSelectionType(TriangleSelectionStyle::SelectionType::FREEHAND_LASSO);
+        trianglesSelectionStyle->setAssembly(canvas);
+        trianglesSelectionStyle->setQvtkWidget(ui->meshViewer);
+        trianglesSelectionStyle->setRen(renderer);
+        ui->meshViewer->interactor()->SetInteractorStyle(trianglesSelectionStyle);
+        this->ui->actionVerticesSelection->setChecked(false);
+        verticesSelectionStyle->resetSelection();
+        this->ui->actionLinesSelection->setChecked(false);
+        linesSelectionStyle->resetSelection();
+        this->ui->actionTrianglesRectangleSelection->setChecked(false);
+        this->ui->actionTrianglesLassoSelection->setChecked(false);
+        this->ui->actionSelectAnnotations->setChecked(false);
+        annotationsSelectionStyle->resetSelection();
+        this->ui->actionRulerMeasure->setChecked(false);
+        this->ui->actionMeasureTape->setChecked(false);
+        this->ui->actionCaliperMeasure->setChecked(false);
+
+    }
+}
+
 void MainWindow::on_actionSelectAnnotations_triggered(bool checked)
 {
     this->selectAnnotations = checked;
@@ -476,6 +836,7 @@ void MainWindow::on_actionSelectAnnotations_triggered(bool checked)
         this->ui->actionLinesSelection->setChecked(false);
         this->ui->actionTrianglesRectangleSelection->setChecked(false);
         this->ui->actionTrianglesLassoSelection->setChecked(false);
+        this->ui->actionTrianglesFreehandSelection->setChecked(false);
         this->ui->actionRulerMeasure->setChecked(false);
         this->ui->actionMeasureTape->setChecked(false);
         this->ui->actionCaliperMeasure->setChecked(false);
@@ -489,50 +850,53 @@ void MainWindow::on_actionSelectAnnotations_triggered(bool checked)
 
 void MainWindow::slotUpdateView()
 {
-    this->ui->meshViewer->renderWindow()->RemoveRenderer(renderer);
-    if(currentMesh != nullptr)
+    //Requests arriving before the next frame are served by the same render
+    renderScheduler->requestRender();
+}
+
+void MainWindow::slotRender()
+{
+    //Only what changed since the previous frame is rebuilt, the other actors stay in the canvas
+    bool proxyShown = lodProxy->isShown();
+    if(currentMesh != nullptr || tileManager->isOpen())
     {
-        auto collection = canvas->GetParts();
-        collection->InitTraversal();
-        uint partsNumber = collection->GetNumberOfItems();
-        for (vtkIdType i = 0; i < partsNumber; i++)
-        {
-          canvas->RemovePart(collection->GetNextProp());
-        }
-        currentMesh->draw(canvas);
+        lodProxy->hide();
+        sceneCache->setMesh(currentMesh);
+        drawTiles();
+        scene->update();
+        if(proxyShown)
+            lodProxy->show(canvas, sceneCache->getVersion());
     }
-    renderer->AddActor(canvas);
     canvas->Modified();
-    renderer->SetBackground(255,255,255);
     //ui->measuresListWidget->update();
-    this->ui->meshViewer->renderWindow()->AddRenderer(renderer);
     this->ui->meshViewer->renderWindow()->Render();
     this->ui->meshViewer->update();
 }
 
 void MainWindow::slotAddAnnotationsRelationship(std::string type, double weight, double minValue, double maxValue, unsigned int measureId1, unsigned int measureId2, bool directed)
 {
-    auto relationship = std::make_shared<SemantisedTriangleMesh::Relationship>();
-
-    relationship->setId(annotationsRelationships.size());
-    relationship->setAnnotations(relationshipDialog->getSubjects());
-    relationship->setType(type);
-    relationship->setWeight(weight);
-    relationship->setMinValue(minValue);
-    relationship->setMaxValue(maxValue);
-
-    for (unsigned int i = 0; i < relationship->getAnnotations().size(); i++) {
-        for (unsigned int j = i; j < relationship->getAnnotations().size(); j++) {
-            if( i == j && relationship->getAnnotations().size() != 1)
-                continue;
-            currentMesh->addAnnotationsRelationship(relationship->getAnnotations()[i], relationship->getAnnotations()[j], type, directed);
-        }
-    }
-
+    BinaryAnnotationFileManager::RelationshipRecord record;
+    record.id = relationships->getNextId();
+    record.type = type;
+    record.weight = weight;
+    record.minValue = minValue;
+    record.maxValue = maxValue;
+    record.directed = directed;
+    for(auto subject : relationshipDialog->getSubjects())
+        record.subjects.push_back(toIndex(subject->getId()));
+
+    relationships->getRelationship(relationships->addRelationship(record));
+    annotationJournal->recordRelationship(record);
 
     slotUpdateView();
 }
 
+void MainWindow::resetRelationships()
+{
+    relationships->clear();
+    relationships->setMesh(currentMesh);
+}
+
 void MainWindow::slotAddSemanticAttribute(std::string key, std::string value)
 {
     auto selected = currentMesh->getSelectedAnnotations();
@@ -545,6 +909,8 @@ void MainWindow::slotAddSemanticAttribute(std::string key, std::string value)
         attribute->setKey(key);
         attribute->setValue(value);
         selected[0]->addAttribute(attribute);
+        annotationJournal->recordAnnotation(selected[0]);
+        sceneCache->markAnnotationDirty(selected[0]->getId());
         this->ui->measuresListWidget->update();
         slotUpdateView();
     } else {
@@ -557,13 +923,13 @@ void MainWindow::slotAddSemanticAttribute(std::string key, std::string value)
 
 void MainWindow::slotFinalization(std::string tag, uchar * color)
 {
-    std::string id;
+    AnnotationIndex id;
     if(isAnnotationBeingModified){
-        id = annotationBeingModified->getId();
+        id = toIndex(annotationBeingModified->getId());
         isAnnotationBeingModified = false;
         annotationBeingModified = nullptr;
     }else
-        id = std::to_string(reachedId++);
+        id = reachedId++;
 
     if(selectVertices)
         verticesSelectionStyle->finalizeAnnotation(id, tag, color);
@@ -572,7 +938,7 @@ void MainWindow::slotFinalization(std::string tag, uchar * color)
     else
         trianglesSelectionStyle->finalizeAnnotation(id, tag, color);
 
-    auto annotation = currentMesh->getAnnotation(std::stoi(id));
+    auto annotation = currentMesh->getAnnotation(id);
     auto involved = annotation->getInvolvedVertices();
     std::vector<std::shared_ptr<SemantisedTriangleMesh::Point> > points;
     for_each(involved.begin(), involved.end(), [&points](std::shared_ptr<SemantisedTriangleMesh::Vertex> v )
@@ -610,22 +976,22 @@ void MainWindow::slotFinalization(std::string tag, uchar * color)
     depth->setType(SemantisedTriangleMesh::GeometricAttributeType::BOUNDING_MEASURE);
 
     auto extrema = SemantisedTriangleMesh::Point::findExtremePoints(points, *up);
-    height->addMeasurePointID(std::stoi(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.first)->getId()));
-    height->addMeasurePointID(std::stoi(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.second)->getId()));
+    height->addMeasurePointID(toIndex(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.first)));
+    height->addMeasurePointID(toIndex(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.second)));
     height->setMesh(currentMesh);
     height->update();
     height->setDrawValue(false);
     height->setDrawPlanes(false);
     extrema = SemantisedTriangleMesh::Point::findExtremePoints(points, *side);
-    width->addMeasurePointID(std::stoi(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.first)->getId()));
-    width->addMeasurePointID(std::stoi(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.second)->getId()));
+    width->addMeasurePointID(toIndex(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.first)));
+    width->addMeasurePointID(toIndex(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.second)));
     width->setMesh(currentMesh);
     width->update();
     width->setDrawValue(false);
     width->setDrawPlanes(false);
     extrema = SemantisedTriangleMesh::Point::findExtremePoints(points, *inDepth);
-    depth->addMeasurePointID(std::stoi(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.first)->getId()));
-    depth->addMeasurePointID(std::stoi(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.second)->getId()));
+    depth->addMeasurePointID(toIndex(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.first)));
+    depth->addMeasurePointID(toIndex(std::static_pointer_cast<SemantisedTriangleMesh::Vertex>(extrema.second)));
     depth->setMesh(currentMesh);
     depth->update();
     depth->setDrawValue(false);
@@ -634,6 +1000,8 @@ void MainWindow::slotFinalization(std::string tag, uchar * color)
     annotation->addAttribute(width);
     annotation->addAttribute(depth);
     std::dynamic_pointer_cast<DrawableAnnotation>(annotation)->setDrawAttributes(true);
+    annotationJournal->recordAnnotation(annotation);
+    sceneCache->markAnnotationDirty(annotation->getId());
     this->ui->measuresListWidget->setMesh(currentMesh);
     this->ui->measuresListWidget->update();
     slotUpdateView();
@@ -647,7 +1015,7 @@ void MainWindow::on_actionEditAnnotations_triggered(bool checked)
         annotationBeingModified = selectedAnnotations[0];
         annotationsSelectionStyle->resetSelection();
         canvas->RemovePart(std::dynamic_pointer_cast<DrawableAnnotation>(annotationBeingModified)->getCanvas());
-        currentMesh->removeAnnotation(std::stoi(annotationBeingModified->getId()));
+        currentMesh->removeAnnotation(toIndex(annotationBeingModified->getId()));
 
         if(annotationBeingModified->getType() == SemantisedTriangleMesh::AnnotationType::Point){
             auto selectedPoints = std::dynamic_pointer_cast<DrawablePointAnnotation>(annotationBeingModified)->getPoints();
@@ -672,12 +1040,17 @@ void MainWindow::on_actionEditAnnotations_triggered(bool checked)
             auto selectedTriangles = std::dynamic_pointer_cast<DrawableSurfaceAnnotation>(annotationBeingModified)->getTrianglesIds();
             trianglesSelectionStyle->resetSelection();
             trianglesSelectionStyle->setAssembly(canvas);
-            trianglesSelectionStyle->defineSelection(selectedTriangles);
+            trianglesSelectionStyle->defineSelection(toIndices(selectedTriangles));
             if(selectTrianglesWithLasso)
             {
                 this->ui->actionTrianglesLassoSelection->setChecked(true);
                 this->ui->actionTrianglesLassoSelection->triggered(true);
             }
+            else if(selectTrianglesFreehand)
+            {
+                this->ui->actionTrianglesFreehandSelection->setChecked(true);
+                this->ui->actionTrianglesFreehandSelection->triggered(true);
+            }
             else
             {
                 this->ui->actionTrianglesRectangleSelection->setChecked(true);
@@ -707,6 +1080,7 @@ void MainWindow::on_actionRulerMeasure_triggered(bool checked)
         ui->actionLinesSelection->setChecked(false);
         ui->actionTrianglesRectangleSelection->setChecked(false);
         ui->actionTrianglesLassoSelection->setChecked(false);
+        ui->actionTrianglesFreehandSelection->setChecked(false);
         ui->actionSelectAnnotations->setChecked(false);
         ui->actionMeasureTape->setChecked(false);
         ui->actionCaliperMeasure->setChecked(false);
@@ -729,6 +1103,7 @@ void MainWindow::on_actionMeasureTape_triggered(bool checked)
         ui->actionLinesSelection->setChecked(false);
         ui->actionTrianglesRectangleSelection->setChecked(false);
         ui->actionTrianglesLassoSelection->setChecked(false);
+        ui->actionTrianglesFreehandSelection->setChecked(false);
         ui->actionSelectAnnotations->setChecked(false);
         ui->actionRulerMeasure->setChecked(false);
         ui->actionCaliperMeasure->setChecked(false);
@@ -751,6 +1126,7 @@ void MainWindow::on_actionCaliperMeasure_triggered(bool checked)
         ui->actionLinesSelection->setChecked(false);
         ui->actionTrianglesRectangleSelection->setChecked(false);
         ui->actionTrianglesLassoSelection->setChecked(false);
+        ui->actionTrianglesFreehandSelection->setChecked(false);
         ui->actionSelectAnnotations->setChecked(false);
         ui->actionRulerMeasure->setChecked(false);
         ui->actionMeasureTape->setChecked(false);
@@ -779,6 +1155,8 @@ void MainWindow::on_actionAddMeasure_triggered()
             auto attribute = measureStyle->finalizeAttribute(selected[0]->getAttributes().size(), text.toStdString());
             attribute->setIsGeometric(true);
             selected[0]->addAttribute(attribute);
+            annotationJournal->recordAnnotation(selected[0]);
+            sceneCache->markAnnotationDirty(selected[0]->getId());
         }
 
         this->ui->measuresListWidget->setMesh(currentMesh);
@@ -795,6 +1173,7 @@ void MainWindow::on_actionAddMeasure_triggered()
 void MainWindow::slotUpdate()
 {
     currentMesh->update();
+    sceneCache->markAllDirty();
     slotUpdateView();
     update();
 }
@@ -814,12 +1193,20 @@ void MainWindow::on_actionSave_relationships_triggered()
     QString filename = QFileDialog::getSaveFileName(nullptr,
                      "Save the annotations' relationships",
                      QString::fromStdString(currentPath),
-                     "REL(*.rel);;");
+                     "REL(*.rel);;BREL(*.brel);;");
 
     if (!filename.isEmpty()){
 
       QFileInfo info(filename);
       currentPath = info.absolutePath().toStdString();
+      if(BinaryRelationshipStore::isBinaryRelationshipFile(filename.toStdString()))
+      {
+          if(!relationships->write(filename.toStdString()))
+              std::cout << "Something went wrong during relationships file writing: " << relationships->getError() << std::endl << std::flush;
+          return;
+      }
+      //The text format is written from the mesh, which must know every relationship
+      relationships->resolveAll();
       SemantisedTriangleMesh::SemanticsFileManager manager;
       manager.setMesh(currentMesh);
       if(!manager.writeRelationships(filename.toStdString()))
@@ -833,16 +1220,28 @@ void MainWindow::on_actionOpen_relationships_triggered()
     QString filename = QFileDialog::getOpenFileName(nullptr,
                      "Load the annotations' relationships",
                      QString::fromStdString(currentPath),
-                     "REL(*.rel);;");
+                     "REL(*.rel);;BREL(*.brel);;");
 
     if (!filename.isEmpty()){
 
       QFileInfo info(filename);
       currentPath = info.absolutePath().toStdString();
+      if(BinaryRelationshipStore::isBinaryRelationshipFile(filename.toStdString()))
+      {
+          if(!relationships->read(filename.toStdString()))
+              std::cout << "Something went wrong during relationships file load: " << relationships->getError() << std::endl << std::flush;
+          return;
+      }
       SemantisedTriangleMesh::SemanticsFileManager manager;
       manager.setMesh(currentMesh);
       if(!manager.readRelationships(filename.toStdString()))
+      {
           std::cout << "Something went wrong during relationships file load." << std::endl << std::flush;
+          return;
+      }
+      //The text format is read into the mesh: the store takes its relationships too, or the binary formats would lose them
+      for(auto index : relationships->importRelationships(currentMesh->getRelationships()))
+          annotationJournal->recordRelationship(relationships->getRecord(index));
     }
 }
 
@@ -878,6 +1277,7 @@ void MainWindow::on_actionComputeAccessibility_triggered()
             annotationsFilename.append("/annotations.ant");
             std::string relationsFilename = dir;
             relationsFilename.append("/relations.rel");
+            relationships->resolveAll();
             SemantisedTriangleMesh::SemanticsFileManager manager;
             manager.setMesh(currentMesh);
             uint annRetValue = manager.writeAnnotations(annotationsFilename);
@@ -943,6 +1343,7 @@ void MainWindow::slotSelectAnnotation(std::string id, bool selected)
 {
 
     std::dynamic_pointer_cast<DrawableAnnotation>(currentMesh->getAnnotation(id))->setSelected(selected);
+    sceneCache->markAnnotationViewDirty(id);
     slotUpdateView();
 }
 
@@ -0,0 +1,59 @@
+#include "mappedfile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile()
+{
+    data = nullptr;
+    size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+    if(data != nullptr)
+        munmap(const_cast<char*>(data), size);
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        return nullptr;
+
+    struct stat sb;
+    if(fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size == 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    void* mapped = mmap(nullptr, static_cast<size_t>(sb.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED)
+        return nullptr;
+    madvise(mapped, static_cast<size_t>(sb.st_size), MADV_SEQUENTIAL);
+
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    file->filename = filename;
+    file->data = static_cast<const char*>(mapped);
+    file->size = static_cast<size_t>(sb.st_size);
+    return file;
+}
+
+const char *MappedFile::getData() const
+{
+    return data;
+}
+
+size_t MappedFile::getSize() const
+{
+    return size;
+}
+
+const std::string &MappedFile::getFilename() const
+{
+    return filename;
+}
@@ -0,0 +1,195 @@
+#include "measurebatchrenderer.hpp"
+
+#include <drawableannotation.hpp>
+#include <drawableboundingmeasure.hpp>
+#include <drawableeuclideanmeasure.hpp>
+#include <drawablegeodesicmeasure.hpp>
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDoubleArray.h>
+#include <vtkLabelPlacementMapper.h>
+#include <vtkPointData.h>
+#include <vtkPointSetToLabelHierarchy.h>
+#include <vtkPoints.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkProperty.h>
+#include <vtkStringArray.h>
+#include <vtkTextProperty.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+using namespace SemantisedTriangleMesh;
+using namespace Drawables;
+
+MeasureBatchRenderer::MeasureBatchRenderer()
+{
+    lines = vtkSmartPointer<vtkPolyData>::New();
+    labels = vtkSmartPointer<vtkPolyData>::New();
+    measuresNumber = 0;
+
+    auto linesMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    linesMapper->SetInputData(lines);
+    linesMapper->SetScalarModeToUseCellData();
+    linesMapper->SetColorModeToDirectScalars();
+    linesActor = vtkSmartPointer<vtkActor>::New();
+    linesActor->SetMapper(linesMapper);
+    linesActor->GetProperty()->SetLineWidth(3);
+    linesActor->GetProperty()->LightingOff();
+    linesActor->PickableOff();
+
+    //Labels are placed in one pass over all of them, the hierarchy decides which ones fit on the screen
+    auto hierarchy = vtkSmartPointer<vtkPointSetToLabelHierarchy>::New();
+    hierarchy->SetInputData(labels);
+    hierarchy->SetLabelArrayName(LABELS_ARRAY_NAME);
+    hierarchy->SetPriorityArrayName(PRIORITIES_ARRAY_NAME);
+    hierarchy->GetTextProperty()->SetColor(0, 0, 0);
+    hierarchy->GetTextProperty()->SetFontSize(12);
+    hierarchy->GetTextProperty()->SetJustificationToCentered();
+    auto labelsMapper = vtkSmartPointer<vtkLabelPlacementMapper>::New();
+    labelsMapper->SetInputConnection(hierarchy->GetOutputPort());
+    labelsMapper->PlaceAllLabelsOff();
+    labelsActor = vtkSmartPointer<vtkActor2D>::New();
+    labelsActor->SetMapper(labelsMapper);
+    labelsActor->PickableOff();
+
+    canvas = vtkSmartPointer<vtkPropAssembly>::New();
+    canvas->AddPart(linesActor);
+    canvas->AddPart(labelsActor);
+    clear();
+}
+
+bool MeasureBatchRenderer::isBatched(const std::shared_ptr<Attribute> &attribute)
+{
+    return dynamic_pointer_cast<DrawableBoundingMeasure>(attribute) != nullptr ||
+           dynamic_pointer_cast<DrawableEuclideanMeasure>(attribute) != nullptr ||
+           dynamic_pointer_cast<DrawableGeodesicMeasure>(attribute) != nullptr;
+}
+
+void MeasureBatchRenderer::build(const std::shared_ptr<DrawableTriangleMesh> &mesh)
+{
+    clear();
+    if(mesh == nullptr)
+        return;
+
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    auto polylines = vtkSmartPointer<vtkCellArray>::New();
+    auto colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    colors->SetNumberOfComponents(3);
+    auto labelPoints = vtkSmartPointer<vtkPoints>::New();
+    auto labelTexts = vtkSmartPointer<vtkStringArray>::New();
+    labelTexts->SetName(LABELS_ARRAY_NAME);
+    auto priorities = vtkSmartPointer<vtkDoubleArray>::New();
+    priorities->SetName(PRIORITIES_ARRAY_NAME);
+
+    for(auto annotation : mesh->getAnnotations())
+    {
+        auto drawableAnnotation = dynamic_pointer_cast<DrawableAnnotation>(annotation);
+        if(drawableAnnotation == nullptr || !drawableAnnotation->getDrawAnnotation() || !drawableAnnotation->getDrawAttributes())
+            continue;
+        unsigned char* color = annotation->getColor();
+        for(auto attribute : annotation->getAttributes())
+        {
+            auto drawable = dynamic_pointer_cast<DrawableAttribute>(attribute);
+            auto geometric = dynamic_pointer_cast<GeometricAttribute>(attribute);
+            if(drawable == nullptr || geometric == nullptr || !isBatched(attribute) || !drawable->getDrawAttribute())
+                continue;
+            auto ids = geometric->getMeasurePointsID();
+            if(ids.size() < 2)
+                continue;
+
+            //Bounding measures are drawn along their direction, the others through their points
+            std::vector<std::array<double, 3> > path;
+            auto bounding = dynamic_pointer_cast<DrawableBoundingMeasure>(attribute);
+            if(bounding != nullptr && bounding->getOrigin() != nullptr && bounding->getDirection() != nullptr)
+            {
+                auto o = bounding->getOrigin();
+                auto d = bounding->getDirection();
+                double dLength = std::sqrt(d->getX() * d->getX() + d->getY() * d->getY() + d->getZ() * d->getZ());
+                if(dLength == 0.0)
+                    continue;
+                double direction[3] = {d->getX() / dLength, d->getY() / dLength, d->getZ() / dLength};
+                for(auto id : {ids.front(), ids.back()})
+                {
+                    auto v = mesh->getVertex(static_cast<unsigned long>(id));
+                    double t = (v->getX() - o->getX()) * direction[0] + (v->getY() - o->getY()) * direction[1] + (v->getZ() - o->getZ()) * direction[2];
+                    path.push_back({{o->getX() + t * direction[0], o->getY() + t * direction[1], o->getZ() + t * direction[2]}});
+                }
+            } else
+                for(auto id : ids)
+                {
+                    auto v = mesh->getVertex(static_cast<unsigned long>(id));
+                    path.push_back({{v->getX(), v->getY(), v->getZ()}});
+                }
+
+            double length = 0;
+            polylines->InsertNextCell(static_cast<vtkIdType>(path.size()));
+            for(size_t i = 0; i < path.size(); i++)
+            {
+                polylines->InsertCellPoint(points->InsertNextPoint(path[i].data()));
+                if(i > 0)
+                    length += std::sqrt(std::pow(path[i][0] - path[i - 1][0], 2) + std::pow(path[i][1] - path[i - 1][1], 2) + std::pow(path[i][2] - path[i - 1][2], 2));
+            }
+            colors->InsertNextTypedTuple(color);
+            measuresNumber++;
+
+            if(drawable->getDrawValue())
+            {
+                double value = attribute->getValue() != nullptr ? *static_cast<double*>(attribute->getValue()) : length;
+                std::ostringstream text;
+                text << std::fixed << std::setprecision(2) << value;
+                const std::array<double, 3> &middle = path[path.size() / 2];
+                const std::array<double, 3> &previous = path[(path.size() - 1) / 2];
+                labelPoints->InsertNextPoint((middle[0] + previous[0]) / 2, (middle[1] + previous[1]) / 2, (middle[2] + previous[2]) / 2);
+                labelTexts->InsertNextValue(text.str());
+                priorities->InsertNextValue(length);
+            }
+        }
+    }
+
+    lines->SetPoints(points);
+    lines->SetLines(polylines);
+    colors->SetName("Colors");
+    lines->GetCellData()->SetScalars(colors);
+    lines->Modified();
+    labels->SetPoints(labelPoints);
+    labels->GetPointData()->AddArray(labelTexts);
+    labels->GetPointData()->AddArray(priorities);
+    labels->Modified();
+    linesActor->SetVisibility(measuresNumber > 0);
+    labelsActor->SetVisibility(labelPoints->GetNumberOfPoints() > 0);
+}
+
+void MeasureBatchRenderer::clear()
+{
+    lines->Initialize();
+    labels->Initialize();
+    measuresNumber = 0;
+    linesActor->VisibilityOff();
+    labelsActor->VisibilityOff();
+}
+
+vtkSmartPointer<vtkPropAssembly> MeasureBatchRenderer::getCanvas() const
+{
+    return canvas;
+}
+
+vtkIdType MeasureBatchRenderer::getMeasuresNumber() const
+{
+    return measuresNumber;
+}
+
+double MeasureBatchRenderer::getLineWidth() const
+{
+    return linesActor->GetProperty()->GetLineWidth();
+}
+
+void MeasureBatchRenderer::setLineWidth(double newLineWidth)
+{
+    linesActor->GetProperty()->SetLineWidth(static_cast<float>(newLineWidth));
+}
@@ -72,6 +72,8 @@ void MeasuresListWidget::update()
         w->update();
         connect(w, SIGNAL(updateSignal()), this, SLOT(updateSlot()));
         connect(w, SIGNAL(updateViewSignal()), this, SLOT(updateViewSlot()));
+        connect(w, SIGNAL(attributesChanged()), this, SLOT(slotAttributesChanged()));
+        connect(w, SIGNAL(attributeViewChanged(unsigned int)), this, SLOT(slotAttributeViewChanged(unsigned int)));
 
         QTreeWidgetItem* pContainer = new QTreeWidgetItem();
         pContainer->setDisabled(true);
@@ -110,6 +112,7 @@ void MeasuresListWidget::slotShowAnnotation(bool checked)
 {
     auto annotation = buttonAnnotationMap.at(static_cast<QPushButton*>(sender()));
     std::dynamic_pointer_cast<DrawableAnnotation>(annotation)->setDrawAnnotation(checked);
+    emit(annotationViewChanged(annotation->getId()));
     emit(updateViewSignal());
 }
 
@@ -117,6 +120,7 @@ void MeasuresListWidget::slotDeleteAnnotation()
 {
     auto annotation = buttonAnnotationMap.at(static_cast<QPushButton*>(sender()));
     mesh->removeAnnotation(annotation->getId());
+    emit(annotationRemoved(annotation->getId()));
     emit(updateViewSignal());
     update();
 
@@ -130,6 +134,18 @@ void MeasuresListWidget::slotSelectAnnotation(bool selected)
     emit(selectAnnotation(id, selected));
 }
 
+void MeasuresListWidget::slotAttributesChanged()
+{
+    auto widget = static_cast<AttributeWidget*>(sender());
+    emit(annotationChanged(widget->getAnnotation()->getId()));
+}
+
+void MeasuresListWidget::slotAttributeViewChanged(unsigned int attributeId)
+{
+    auto widget = static_cast<AttributeWidget*>(sender());
+    emit(attributeViewChanged(widget->getAnnotation()->getId(), attributeId));
+}
+
 void MeasuresListWidget::updateSlot()
 {
     emit updateSignal();
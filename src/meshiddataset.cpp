@@ -0,0 +1,118 @@
+#include "meshiddataset.hpp"
+
+#include <vtkIdFilter.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+
+#include <algorithm>
+
+MeshIdDataset::MeshIdDataset()
+{
+    builtGeometryTime = 0;
+}
+
+void MeshIdDataset::setSurface(vtkSmartPointer<vtkPolyData> surface, vtkSmartPointer<vtkPolyData> geometry)
+{
+    this->surface = surface;
+    this->geometry = geometry;
+    invalidate();
+}
+
+vtkSmartPointer<vtkPolyData> MeshIdDataset::getDataset()
+{
+    if(surface == nullptr)
+        return nullptr;
+    if(!isValid())
+    {
+        //Once the surface changed, the alternative geometry no longer describes it
+        if(dataset != nullptr)
+            geometry = nullptr;
+        build();
+    }
+    return dataset;
+}
+
+std::shared_ptr<FrustumBVH> MeshIdDataset::getBVH()
+{
+    //Built with the dataset, so it is as up to date as that
+    if(getDataset() == nullptr)
+        return nullptr;
+    return bvh;
+}
+
+std::vector<vtkIdType> MeshIdDataset::selectPoints(vtkPlanes *frustum)
+{
+    auto tree = getBVH();
+    if(tree == nullptr)
+        return std::vector<vtkIdType>();
+    return tree->query(frustum);
+}
+
+std::shared_ptr<IdBuffer> MeshIdDataset::getIdBuffer(vtkRenderer *renderer)
+{
+    if(getDataset() == nullptr || renderer == nullptr)
+        return nullptr;
+    if(idBuffer == nullptr)
+        idBuffer = std::make_shared<IdBuffer>();
+    //Rendered again only if the camera moved since the previous selection
+    idBuffer->update(dataset, renderer);
+    return idBuffer;
+}
+
+std::vector<vtkIdType> MeshIdDataset::selectVisiblePoints(const std::vector<vtkIdType> &pointIds, vtkRenderer *renderer)
+{
+    std::vector<vtkIdType> visible;
+    auto buffer = getIdBuffer(renderer);
+    if(buffer == nullptr)
+        return visible;
+    for(auto id : pointIds)
+        if(buffer->isPointVisible(id))
+            visible.push_back(id);
+    return visible;
+}
+
+vtkSmartPointer<vtkPolyData> MeshIdDataset::getSurface() const
+{
+    return surface;
+}
+
+void MeshIdDataset::invalidate()
+{
+    dataset = nullptr;
+    bvh = nullptr;
+    idBuffer = nullptr;
+    builtGeometryTime = 0;
+}
+
+bool MeshIdDataset::isValid() const
+{
+    return dataset != nullptr && getGeometryTime() == builtGeometryTime;
+}
+
+vtkMTimeType MeshIdDataset::getGeometryTime() const
+{
+    vtkMTimeType time = 0;
+    if(surface->GetPoints() != nullptr)
+        time = std::max(time, surface->GetPoints()->GetMTime());
+    if(surface->GetPolys() != nullptr)
+        time = std::max(time, surface->GetPolys()->GetMTime());
+    return time;
+}
+
+void MeshIdDataset::build()
+{
+    vtkSmartPointer<vtkIdFilter> idFilter = vtkSmartPointer<vtkIdFilter>::New();
+    idFilter->SetInputData(geometry != nullptr ? geometry : surface);
+    idFilter->PointIdsOn();
+    idFilter->CellIdsOn();
+    idFilter->SetPointIdsArrayName(IDS_ARRAY_NAME);
+    idFilter->SetCellIdsArrayName(IDS_ARRAY_NAME);
+    idFilter->Update();
+
+    dataset = static_cast<vtkPolyData*>(idFilter->GetOutput());
+    //Point to cell links are needed by every triangle selection, better to pay for them here
+    dataset->BuildLinks();
+    bvh = std::make_shared<FrustumBVH>();
+    bvh->build(dataset->GetPoints());
+    builtGeometryTime = getGeometryTime();
+}
@@ -0,0 +1,133 @@
+#include "meshloader.hpp"
+#include "plyasciireader.hpp"
+
+#include <vtkActor.h>
+#include <vtkMapper.h>
+
+#include <QDir>
+#include <QTemporaryFile>
+
+#include <exception>
+
+using namespace std;
+using namespace Drawables;
+
+MeshLoader::MeshLoader(QObject *parent) : QThread(parent)
+{
+}
+
+MeshLoader::~MeshLoader()
+{
+    cancel();
+    wait();
+}
+
+void MeshLoader::load(const std::string &filename)
+{
+    if(isRunning())
+        return;
+    this->filename = filename;
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        result = Result();
+    }
+    start();
+}
+
+void MeshLoader::cancel()
+{
+    requestInterruption();
+}
+
+bool MeshLoader::getCanceled() const
+{
+    return isInterruptionRequested();
+}
+
+MeshLoader::Result MeshLoader::takeResult()
+{
+    std::lock_guard<std::mutex> lock(resultMutex);
+    Result taken = result;
+    result = Result();
+    return taken;
+}
+
+const std::string &MeshLoader::getFilename() const
+{
+    return filename;
+}
+
+void MeshLoader::run()
+{
+    Result loaded;
+    emit(progressChanged(0));
+    try
+    {
+        //ASCII PLY files holding nothing but the geometry are parsed on all the cores and the mesh is loaded from a
+        //binary copy, sparing the library the scan of the text. Any other file is left to the library alone: it would
+        //parse the text anyway, and a parallel parse would only come on top of it
+        vtkSmartPointer<vtkPolyData> geometry;
+        QTemporaryFile binaryCopy(QDir::temp().filePath("meshXXXXXX.ply"));
+        if(PLYAsciiReader::canRead(filename) && PLYAsciiReader::hasOnlyGeometry(filename) && binaryCopy.open())
+        {
+            binaryCopy.close();
+            PLYAsciiReader asciiReader;
+            if(asciiReader.read(filename) && asciiReader.writeBinary(binaryCopy.fileName().toStdString()))
+                geometry = asciiReader.getOutput();
+            else
+                binaryCopy.remove();
+        }
+        if(!stageCompleted(30))
+            return;
+
+        loaded.mesh = std::make_shared<DrawableTriangleMesh>();
+        if(geometry != nullptr && binaryCopy.exists())
+        {
+            loaded.mesh->load(binaryCopy.fileName().toStdString());
+            if(loaded.mesh->getVerticesNumber() != static_cast<unsigned long>(geometry->GetNumberOfPoints()))
+            {
+                loaded.mesh = std::make_shared<DrawableTriangleMesh>();
+                loaded.mesh->load(filename);
+            }
+        } else
+            loaded.mesh->load(filename);
+        if(!stageCompleted(60))
+            return;
+
+        //The id-tagged dataset shares the double coordinates of the ASCII parse, when the mesh comes from its binary copy;
+        //other files are parsed only by the library, whose object model is needed anyway, and the dataset is built from
+        //its surface
+        vtkSmartPointer<vtkPolyData> surface = vtkPolyData::SafeDownCast(loaded.mesh->getSurfaceActor()->GetMapper()->GetInputAsDataSet());
+        if(geometry != nullptr && (geometry->GetNumberOfPoints() != surface->GetNumberOfPoints() ||
+                                   geometry->GetNumberOfCells() != surface->GetNumberOfCells()))
+            geometry = nullptr;
+        if(!stageCompleted(70))
+            return;
+
+        loaded.idDataset = std::make_shared<MeshIdDataset>();
+        loaded.idDataset->setSurface(surface, geometry);
+        loaded.idDataset->getDataset();
+        if(!stageCompleted(85))
+            return;
+
+        //Mapped from the sidecar when the file did not change since the last time, built and written otherwise
+        loaded.cache = MeshSidecarCache::open(filename, surface);
+        if(!stageCompleted(100))
+            return;
+    } catch(const std::exception &e)
+    {
+        emit(loadingFailed(QString::fromStdString(e.what())));
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(resultMutex);
+    result = loaded;
+}
+
+bool MeshLoader::stageCompleted(int progress)
+{
+    if(isInterruptionRequested())
+        return false;
+    emit(progressChanged(progress));
+    return true;
+}
@@ -0,0 +1,303 @@
+#include "meshsidecarcache.hpp"
+
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkPoints.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+static const char MAGIC[8] = {'M', 'S', 'H', 'C', 'A', 'C', 'H', 'E'};
+
+MeshSidecarCache::MeshSidecarCache()
+{
+    std::memset(&header, 0, sizeof(Header));
+    cellStart = nullptr;
+    cellVertices = nullptr;
+    cellPoints = nullptr;
+}
+
+std::shared_ptr<MeshSidecarCache> MeshSidecarCache::open(const std::string &meshFilename, vtkSmartPointer<vtkPolyData> surface)
+{
+    uint64_t fileSize, fileHash;
+    {
+        auto meshFile = MappedFile::open(meshFilename);
+        if(meshFile == nullptr)
+            return nullptr;
+        fileSize = meshFile->getSize();
+        fileHash = hash(meshFile->getData(), meshFile->getSize());
+    }
+
+    auto cache = load(meshFilename, fileSize, fileHash);
+    if(cache != nullptr && surface != nullptr &&
+       cache->getVerticesNumber() == static_cast<size_t>(surface->GetNumberOfPoints()) &&
+       cache->getTrianglesNumber() == static_cast<size_t>(surface->GetNumberOfPolys()))
+        return cache;
+
+    cache = build(surface, fileSize, fileHash);
+    if(cache != nullptr && !cache->write(meshFilename))
+        std::cout << "Unable to write the cache of " << meshFilename << std::endl << std::flush;
+    return cache;
+}
+
+std::shared_ptr<MeshSidecarCache> MeshSidecarCache::load(const std::string &meshFilename, uint64_t fileSize, uint64_t fileHash)
+{
+    auto mapped = MappedFile::open(getCacheFilename(meshFilename));
+    if(mapped == nullptr || mapped->getSize() < sizeof(Header))
+        return nullptr;
+
+    std::shared_ptr<MeshSidecarCache> cache(new MeshSidecarCache());
+    std::memcpy(&cache->header, mapped->getData(), sizeof(Header));
+    const Header &h = cache->header;
+    if(std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION ||
+       h.fileSize != fileSize || h.fileHash != fileHash)
+        return nullptr;
+
+    //Sizes are checked before any pointer into the mapping is taken
+    uint64_t cellsNumber = static_cast<uint64_t>(h.gridSize[0]) * h.gridSize[1] * h.gridSize[2];
+    if(cellsNumber != h.cellsNumber || cellsNumber == 0 || h.verticesNumber > std::numeric_limits<uint32_t>::max())
+        return nullptr;
+    size_t startOffset = align(sizeof(Header));
+    size_t verticesOffset = startOffset + align((h.cellsNumber + 1) * sizeof(uint32_t));
+    size_t pointsOffset = verticesOffset + align(h.verticesNumber * sizeof(uint32_t));
+    size_t end = pointsOffset + h.verticesNumber * 3 * sizeof(double);
+    if(end != mapped->getSize())
+        return nullptr;
+
+    cache->file = mapped;
+    cache->cellStart = reinterpret_cast<const uint32_t*>(mapped->getData() + startOffset);
+    cache->cellVertices = reinterpret_cast<const uint32_t*>(mapped->getData() + verticesOffset);
+    cache->cellPoints = reinterpret_cast<const double*>(mapped->getData() + pointsOffset);
+    if(cache->cellStart[h.cellsNumber] != h.verticesNumber)
+        return nullptr;
+    return cache;
+}
+
+std::shared_ptr<MeshSidecarCache> MeshSidecarCache::build(vtkSmartPointer<vtkPolyData> surface, uint64_t fileSize, uint64_t fileHash)
+{
+    if(surface == nullptr || surface->GetNumberOfPoints() == 0 ||
+       surface->GetNumberOfPoints() > static_cast<vtkIdType>(std::numeric_limits<uint32_t>::max()))
+        return nullptr;
+
+    std::shared_ptr<MeshSidecarCache> cache(new MeshSidecarCache());
+    Header &h = cache->header;
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.fileSize = fileSize;
+    h.fileHash = fileHash;
+    h.verticesNumber = static_cast<uint64_t>(surface->GetNumberOfPoints());
+    h.trianglesNumber = static_cast<uint64_t>(surface->GetNumberOfPolys());
+
+    vtkPoints* points = surface->GetPoints();
+    double bounds[6];
+    points->GetBounds(bounds);
+    double extent[3], maxExtent = 0;
+    for(unsigned int i = 0; i < 3; i++)
+    {
+        extent[i] = bounds[2 * i + 1] - bounds[2 * i];
+        maxExtent = std::max(maxExtent, extent[i]);
+        h.origin[i] = bounds[2 * i];
+    }
+    h.diagonalLength = std::sqrt(extent[0] * extent[0] + extent[1] * extent[1] + extent[2] * extent[2]);
+
+    //Minimum edge length, on the triangles
+    double minSquaredLength = std::numeric_limits<double>::max();
+    vtkSmartPointer<vtkCellArray> polys = surface->GetPolys();
+    vtkSmartPointer<vtkIdList> triangle = vtkSmartPointer<vtkIdList>::New();
+    polys->InitTraversal();
+    while(polys->GetNextCell(triangle))
+    {
+        vtkIdType n = triangle->GetNumberOfIds();
+        for(vtkIdType i = 0; i < n; i++)
+        {
+            double p[3], q[3];
+            points->GetPoint(triangle->GetId(i), p);
+            points->GetPoint(triangle->GetId((i + 1) % n), q);
+            double squaredLength = (p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) + (p[2] - q[2]) * (p[2] - q[2]);
+            minSquaredLength = std::min(minSquaredLength, squaredLength);
+        }
+    }
+    h.minEdgeLength = h.trianglesNumber > 0 ? std::sqrt(minSquaredLength) : 0;
+
+    //Around two vertices per cell; flat meshes get a thin slab of cells rather than a degenerate grid
+    double thickness = std::max(maxExtent * 1e-3, 1e-9);
+    double volume = 1;
+    for(unsigned int i = 0; i < 3; i++)
+        volume *= std::max(extent[i], thickness);
+    h.cellSize = std::cbrt(volume * 2 / static_cast<double>(h.verticesNumber));
+    for(unsigned int i = 0; i < 3; i++)
+        h.cellSize = std::max(h.cellSize, extent[i] / MAX_GRID_SIZE);
+    h.cellSize = std::max(h.cellSize, thickness);
+    for(unsigned int i = 0; i < 3; i++)
+        h.gridSize[i] = std::max(1u, std::min(static_cast<unsigned int>(MAX_GRID_SIZE), static_cast<unsigned int>(std::ceil(extent[i] / h.cellSize))));
+    h.cellsNumber = static_cast<uint64_t>(h.gridSize[0]) * h.gridSize[1] * h.gridSize[2];
+
+    //Counting sort of the vertices by cell
+    std::vector<uint32_t> vertexCells(h.verticesNumber);
+    cache->builtCellStart.assign(h.cellsNumber + 1, 0);
+    for(uint64_t v = 0; v < h.verticesNumber; v++)
+    {
+        double p[3];
+        unsigned int cell[3];
+        points->GetPoint(static_cast<vtkIdType>(v), p);
+        vertexCells[v] = static_cast<uint32_t>(cache->getCell(p, cell));
+        cache->builtCellStart[vertexCells[v] + 1]++;
+    }
+    for(uint64_t c = 0; c < h.cellsNumber; c++)
+        cache->builtCellStart[c + 1] += cache->builtCellStart[c];
+
+    std::vector<uint32_t> next(cache->builtCellStart.begin(), cache->builtCellStart.end() - 1);
+    cache->builtCellVertices.resize(h.verticesNumber);
+    cache->builtCellPoints.resize(h.verticesNumber * 3);
+    for(uint64_t v = 0; v < h.verticesNumber; v++)
+    {
+        uint32_t position = next[vertexCells[v]]++;
+        cache->builtCellVertices[position] = static_cast<uint32_t>(v);
+        points->GetPoint(static_cast<vtkIdType>(v), &cache->builtCellPoints[position * 3]);
+    }
+
+    cache->cellStart = cache->builtCellStart.data();
+    cache->cellVertices = cache->builtCellVertices.data();
+    cache->cellPoints = cache->builtCellPoints.data();
+    return cache;
+}
+
+bool MeshSidecarCache::write(const std::string &meshFilename) const
+{
+    //Written aside and renamed, so that a reader never maps a half written cache
+    std::string filename = getCacheFilename(meshFilename);
+    std::string temporary = filename + ".tmp";
+    FILE* out = fopen(temporary.c_str(), "wb");
+    if(out == nullptr)
+        return false;
+
+    const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    auto writeAligned = [out, &padding](const void* data, size_t size)
+    {
+        if(size > 0 && fwrite(data, 1, size, out) != size)
+            return false;
+        size_t padded = align(size) - size;
+        return padded == 0 || fwrite(padding, 1, padded, out) == padded;
+    };
+
+    bool written = writeAligned(&header, sizeof(Header)) &&
+                   writeAligned(cellStart, (header.cellsNumber + 1) * sizeof(uint32_t)) &&
+                   writeAligned(cellVertices, header.verticesNumber * sizeof(uint32_t)) &&
+                   writeAligned(cellPoints, header.verticesNumber * 3 * sizeof(double));
+    written = (fclose(out) == 0) && written;
+    if(!written || std::rename(temporary.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string MeshSidecarCache::getCacheFilename(const std::string &meshFilename)
+{
+    return meshFilename + "." + EXTENSION;
+}
+
+uint64_t MeshSidecarCache::hash(const char *data, size_t size)
+{
+    //FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i = 0; i < size; i++)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+double MeshSidecarCache::getMinEdgeLength() const
+{
+    return header.minEdgeLength;
+}
+
+double MeshSidecarCache::getAABBDiagonalLength() const
+{
+    return header.diagonalLength;
+}
+
+size_t MeshSidecarCache::getVerticesNumber() const
+{
+    return static_cast<size_t>(header.verticesNumber);
+}
+
+size_t MeshSidecarCache::getTrianglesNumber() const
+{
+    return static_cast<size_t>(header.trianglesNumber);
+}
+
+bool MeshSidecarCache::isMapped() const
+{
+    return file != nullptr;
+}
+
+long MeshSidecarCache::getClosestVertex(const double point[3]) const
+{
+    if(header.verticesNumber == 0)
+        return -1;
+
+    unsigned int center[3];
+    getCell(point, center);
+    long closest = -1;
+    double minSquaredDistance = std::numeric_limits<double>::max();
+    unsigned int maxRing = std::max(std::max(header.gridSize[0], header.gridSize[1]), header.gridSize[2]);
+    for(unsigned int ring = 0; ring <= maxRing; ring++)
+    {
+        int min[3], max[3];
+        for(unsigned int i = 0; i < 3; i++)
+        {
+            min[i] = std::max(0, static_cast<int>(center[i]) - static_cast<int>(ring));
+            max[i] = std::min(static_cast<int>(header.gridSize[i]) - 1, static_cast<int>(center[i] + ring));
+        }
+        for(int z = min[2]; z <= max[2]; z++)
+            for(int y = min[1]; y <= max[1]; y++)
+                for(int x = min[0]; x <= max[0]; x++)
+                {
+                    //Only the cells on the border of the ring, the inner ones have already been visited
+                    unsigned int distance = static_cast<unsigned int>(std::max(std::max(std::abs(x - static_cast<int>(center[0])), std::abs(y - static_cast<int>(center[1]))), std::abs(z - static_cast<int>(center[2]))));
+                    if(distance != ring)
+                        continue;
+                    size_t cell = static_cast<size_t>(x) + header.gridSize[0] * (static_cast<size_t>(y) + static_cast<size_t>(header.gridSize[1]) * z);
+                    for(uint32_t j = cellStart[cell]; j < cellStart[cell + 1]; j++)
+                    {
+                        const double* p = &cellPoints[static_cast<size_t>(j) * 3];
+                        double squaredDistance = (p[0] - point[0]) * (p[0] - point[0]) + (p[1] - point[1]) * (p[1] - point[1]) + (p[2] - point[2]) * (p[2] - point[2]);
+                        if(squaredDistance < minSquaredDistance)
+                        {
+                            minSquaredDistance = squaredDistance;
+                            closest = cellVertices[j];
+                        }
+                    }
+                }
+        //Cells beyond this ring are at least ring * cellSize away from the point
+        double reach = ring * header.cellSize;
+        if(closest >= 0 && minSquaredDistance <= reach * reach)
+            break;
+    }
+    return closest;
+}
+
+size_t MeshSidecarCache::getCell(const double point[3], unsigned int cell[3]) const
+{
+    for(unsigned int i = 0; i < 3; i++)
+    {
+        double coordinate = std::max(0.0, (point[i] - header.origin[i]) / header.cellSize);
+        cell[i] = std::min(header.gridSize[i] - 1, static_cast<unsigned int>(std::min(coordinate, static_cast<double>(MAX_GRID_SIZE))));
+    }
+    return cell[0] + header.gridSize[0] * (cell[1] + static_cast<size_t>(header.gridSize[1]) * cell[2]);
+}
+
+size_t MeshSidecarCache::align(size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
@@ -0,0 +1,509 @@
+#include "plyasciireader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+#include <vtkVersion.h>
+#include <vtkPoints.h>
+#include <vtkDoubleArray.h>
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkTypeInt32Array.h>
+
+using namespace std;
+
+//Powers of ten exactly representable as doubles
+static const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief parseDouble reads a number and moves past it. Numbers with at most 19 significant digits and a small exponent
+ * are converted exactly with a single multiplication or division, the others (and inf/nan) are left to strtod.
+ */
+static bool parseDouble(const char *&position, const char *end, double &value)
+{
+    while(position < end && isBlank(*position))
+        position++;
+    const char* begin = position;
+    bool negative = false;
+    if(position < end && (*position == '-' || *position == '+'))
+        negative = (*position++ == '-');
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool found = false;
+    for(; position < end && isDigit(*position); position++, found = true)
+    {
+        if(digits < 19)
+        {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*position - '0');
+            if(mantissa != 0)
+                digits++;
+        } else
+            exponent++;
+    }
+    if(position < end && *position == '.')
+        for(position++; position < end && isDigit(*position); position++, found = true)
+            if(digits < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*position - '0');
+                exponent--;
+                if(mantissa != 0)
+                    digits++;
+            }
+    if(found && position < end && (*position == 'e' || *position == 'E'))
+    {
+        const char* exponentBegin = position++;
+        bool negativeExponent = false;
+        if(position < end && (*position == '-' || *position == '+'))
+            negativeExponent = (*position++ == '-');
+        if(position == end || !isDigit(*position))
+            position = exponentBegin;
+        else
+        {
+            int explicitExponent = 0;
+            for(; position < end && isDigit(*position); position++)
+                if(explicitExponent < 100000)
+                    explicitExponent = explicitExponent * 10 + (*position - '0');
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+    }
+
+    if(found && mantissa < (static_cast<uint64_t>(1) << 53) && exponent >= -22 && exponent <= 22)
+    {
+        value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / POWERS_OF_TEN[-exponent] : value * POWERS_OF_TEN[exponent];
+        if(negative)
+            value = -value;
+    } else
+    {
+        //The mapping is not null terminated: the token is copied before handing it to strtod
+        const char* tokenEnd = begin;
+        while(tokenEnd < end && !isBlank(*tokenEnd) && *tokenEnd != '\n')
+            tokenEnd++;
+        std::string token(begin, tokenEnd);
+        char* parsedEnd = nullptr;
+        value = strtod(token.c_str(), &parsedEnd);
+        if(parsedEnd == token.c_str())
+            return false;
+        position = begin + (parsedEnd - token.c_str());
+    }
+    return position == end || isBlank(*position) || *position == '\n';
+}
+
+static bool parseInteger(const char *&position, const char *end, long long &value)
+{
+    while(position < end && isBlank(*position))
+        position++;
+    bool negative = false;
+    if(position < end && (*position == '-' || *position == '+'))
+        negative = (*position++ == '-');
+    if(position == end || !isDigit(*position))
+        return false;
+    value = 0;
+    for(; position < end && isDigit(*position); position++)
+        if(value < std::numeric_limits<int>::max())
+            value = value * 10 + (*position - '0');
+    if(negative)
+        value = -value;
+    return position == end || isBlank(*position) || *position == '\n';
+}
+
+//Moves past the next line holding something, returns false if there is none before end
+static bool nextLine(const char *&position, const char *end, const char *&lineEnd)
+{
+    while(position < end)
+    {
+        const char* newline = static_cast<const char*>(memchr(position, '\n', static_cast<size_t>(end - position)));
+        lineEnd = newline != nullptr ? newline : end;
+        const char* first = position;
+        while(first < lineEnd && isBlank(*first))
+            first++;
+        if(first < lineEnd)
+        {
+            position = first;
+            return true;
+        }
+        position = lineEnd < end ? lineEnd + 1 : end;
+    }
+    return false;
+}
+
+//Vertex coordinates and triangles only, nothing that the library would read and the reader would not
+static bool isGeometryOnly(const PLYHeader &header)
+{
+    const PLYHeader::Element* vertices = header.getElement("vertex");
+    const PLYHeader::Element* faces = header.getElement("face");
+    return header.getElements().size() == 2 && vertices != nullptr && faces != nullptr &&
+           vertices->properties.size() == 3 && vertices->getPropertyIndex("x") >= 0 &&
+           vertices->getPropertyIndex("y") >= 0 && vertices->getPropertyIndex("z") >= 0 &&
+           faces->properties.size() == 1 && faces->properties[0].isList;
+}
+
+PLYAsciiReader::PLYAsciiReader()
+{
+    threadsNumber = 0;
+}
+
+bool PLYAsciiReader::canRead(const std::string &filename)
+{
+    std::ifstream stream(filename, std::ios::binary);
+    if(!stream.is_open())
+        return false;
+    std::string magic, formatKeyword, format;
+    std::getline(stream, magic);
+    stream >> formatKeyword >> format;
+    if(magic.compare(0, 3, "ply") != 0 || formatKeyword.compare("format") != 0)
+        return false;
+    return format.compare("ascii") == 0;
+}
+
+bool PLYAsciiReader::read(const std::string &filename)
+{
+    output = nullptr;
+    file = MappedFile::open(filename);
+    if(file == nullptr)
+        return false;
+    if(!header.parse(file->getData(), file->getSize()) || header.getFormat() != PLYHeader::Format::ASCII)
+        return false;
+
+    const PLYHeader::Element* vertices = header.getElement("vertex");
+    const PLYHeader::Element* faces = header.getElement("face");
+    if(vertices == nullptr || faces == nullptr ||
+       vertices->getPropertyIndex("x") < 0 || vertices->getPropertyIndex("y") < 0 || vertices->getPropertyIndex("z") < 0 ||
+       (faces->getPropertyIndex("vertex_indices") < 0 && faces->getPropertyIndex("vertex_index") < 0) ||
+       vertices->count > static_cast<size_t>(std::numeric_limits<vtkTypeInt32>::max()) ||
+       faces->count > static_cast<size_t>(std::numeric_limits<vtkTypeInt32>::max() / 3))
+        return false;
+    vtkIdType pointsNumber = static_cast<vtkIdType>(vertices->count);
+    vtkIdType trianglesNumber = static_cast<vtkIdType>(faces->count);
+
+    auto coordinates = vtkSmartPointer<vtkDoubleArray>::New();
+    coordinates->SetNumberOfComponents(3);
+    coordinates->SetNumberOfTuples(pointsNumber);
+    auto offsets = vtkSmartPointer<vtkTypeInt32Array>::New();
+    auto connectivity = vtkSmartPointer<vtkTypeInt32Array>::New();
+    offsets->SetNumberOfValues(trianglesNumber + 1);
+    connectivity->SetNumberOfValues(3 * trianglesNumber);
+
+    unsigned int chunksNumber = threadsNumber > 0 ? threadsNumber : std::max(1u, std::thread::hardware_concurrency());
+    auto chunks = split(file->getData() + header.getHeaderLength(), file->getData() + file->getSize(), chunksNumber);
+    size_t linesNumber = 0;
+    for(auto &chunk : chunks)
+    {
+        chunk.firstLine = linesNumber;
+        linesNumber += chunk.linesNumber;
+    }
+    size_t expectedLines = 0;
+    for(auto &element : header.getElements())
+        expectedLines += element.count;
+    if(linesNumber < expectedLines)
+        return false;
+
+    std::vector<char> parsed(chunks.size(), 0);
+    std::vector<std::thread> threads;
+    double* coordinatesData = coordinates->GetPointer(0);
+    vtkTypeInt32* connectivityData = connectivity->GetPointer(0);
+    for(unsigned int i = 0; i < chunks.size(); i++)
+        threads.push_back(std::thread([this, &chunks, &parsed, i, coordinatesData, connectivityData]()
+        {
+            parsed[i] = parseChunk(chunks[i], coordinatesData, connectivityData);
+        }));
+    for(auto &thread : threads)
+        thread.join();
+    for(auto chunkParsed : parsed)
+        if(!chunkParsed)
+            return false;
+
+    vtkTypeInt32* offsetsData = offsets->GetPointer(0);
+    for(vtkIdType i = 0; i <= trianglesNumber; i++)
+        offsetsData[i] = static_cast<vtkTypeInt32>(3 * i);
+
+    auto polydata = vtkSmartPointer<vtkPolyData>::New();
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData(coordinates);
+    polydata->SetPoints(points);
+    auto triangles = vtkSmartPointer<vtkCellArray>::New();
+#if VTK_MAJOR_VERSION >= 9
+    triangles->SetData(offsets, connectivity);
+#else
+    for(vtkIdType i = 0; i < trianglesNumber; i++)
+    {
+        vtkIdType ids[3] = {connectivityData[3 * i], connectivityData[3 * i + 1], connectivityData[3 * i + 2]};
+        triangles->InsertNextCell(3, ids);
+    }
+#endif
+    polydata->SetPolys(triangles);
+    output = polydata;
+    return true;
+}
+
+bool PLYAsciiReader::readBounds(const std::string &filename, double bounds[6])
+{
+    auto file = MappedFile::open(filename);
+    PLYHeader header;
+    if(file == nullptr || !header.parse(file->getData(), file->getSize()) || header.getFormat() != PLYHeader::Format::ASCII)
+        return false;
+    int vertexElement = header.getElementIndex("vertex");
+    if(vertexElement < 0)
+        return false;
+    const PLYHeader::Element& vertices = header.getElements()[static_cast<unsigned int>(vertexElement)];
+    int coordinateIndex[3] = {vertices.getPropertyIndex("x"), vertices.getPropertyIndex("y"), vertices.getPropertyIndex("z")};
+    if(vertices.count == 0 || coordinateIndex[0] < 0 || coordinateIndex[1] < 0 || coordinateIndex[2] < 0)
+        return false;
+    unsigned int propertiesNumber = static_cast<unsigned int>(std::max(coordinateIndex[0], std::max(coordinateIndex[1], coordinateIndex[2]))) + 1;
+
+    const char* position = file->getData() + header.getHeaderLength();
+    const char* end = file->getData() + file->getSize();
+    const char* lineEnd;
+    //Lines of the elements before the vertices
+    size_t skippedLines = 0;
+    for(int i = 0; i < vertexElement; i++)
+        skippedLines += header.getElements()[static_cast<unsigned int>(i)].count;
+    for(size_t line = 0; line < skippedLines; line++)
+    {
+        if(!nextLine(position, end, lineEnd))
+            return false;
+        position = lineEnd < end ? lineEnd + 1 : end;
+    }
+
+    for(unsigned int j = 0; j < 3; j++)
+    {
+        bounds[2 * j] = std::numeric_limits<double>::max();
+        bounds[2 * j + 1] = std::numeric_limits<double>::lowest();
+    }
+    //The coordinates are the first properties in practice: the rest of each line is not parsed
+    for(size_t record = 0; record < vertices.count; record++)
+    {
+        if(!nextLine(position, end, lineEnd))
+            return false;
+        for(unsigned int i = 0; i < propertiesNumber; i++)
+        {
+            double value;
+            if(vertices.properties[i].isList || !parseDouble(position, lineEnd, value))
+                return false;
+            for(unsigned int j = 0; j < 3; j++)
+                if(coordinateIndex[j] == static_cast<int>(i))
+                {
+                    bounds[2 * j] = std::min(bounds[2 * j], value);
+                    bounds[2 * j + 1] = std::max(bounds[2 * j + 1], value);
+                }
+        }
+        position = lineEnd < end ? lineEnd + 1 : end;
+    }
+    return true;
+}
+
+std::vector<PLYAsciiReader::Chunk> PLYAsciiReader::split(const char *begin, const char *end, unsigned int chunksNumber) const
+{
+    std::vector<Chunk> chunks;
+    size_t size = static_cast<size_t>(end - begin);
+    const char* chunkBegin = begin;
+    for(unsigned int i = 1; i <= chunksNumber && chunkBegin < end; i++)
+    {
+        //Each chunk ends right after a newline, so that no line is shared
+        const char* chunkEnd = i == chunksNumber ? end : begin + size / chunksNumber * i;
+        if(chunkEnd < chunkBegin)
+            chunkEnd = chunkBegin;
+        const char* newline = chunkEnd < end ? static_cast<const char*>(memchr(chunkEnd, '\n', static_cast<size_t>(end - chunkEnd))) : nullptr;
+        chunkEnd = newline != nullptr ? newline + 1 : end;
+        Chunk chunk;
+        chunk.begin = chunkBegin;
+        chunk.end = chunkEnd;
+        chunk.firstLine = 0;
+        chunk.linesNumber = 0;
+        chunks.push_back(chunk);
+        chunkBegin = chunkEnd;
+    }
+
+    //Line counting runs concurrently as well
+    std::vector<std::thread> threads;
+    for(auto &chunk : chunks)
+        threads.push_back(std::thread([&chunk]()
+        {
+            const char* position = chunk.begin;
+            const char* lineEnd;
+            while(nextLine(position, chunk.end, lineEnd))
+            {
+                chunk.linesNumber++;
+                position = lineEnd < chunk.end ? lineEnd + 1 : chunk.end;
+            }
+        }));
+    for(auto &thread : threads)
+        thread.join();
+    return chunks;
+}
+
+bool PLYAsciiReader::parseChunk(const Chunk &chunk, double *coordinates, vtkTypeInt32 *connectivity) const
+{
+    const std::vector<PLYHeader::Element> &elements = header.getElements();
+    //Element of the first line of the chunk
+    unsigned int elementIndex = 0;
+    size_t elementFirstLine = 0;
+    while(elementIndex < elements.size() && chunk.firstLine >= elementFirstLine + elements[elementIndex].count)
+        elementFirstLine += elements[elementIndex++].count;
+
+    const PLYHeader::Element* vertices = header.getElement("vertex");
+    int coordinateIndex[3] = {vertices->getPropertyIndex("x"), vertices->getPropertyIndex("y"), vertices->getPropertyIndex("z")};
+    const PLYHeader::Element* faces = header.getElement("face");
+    int listIndex = faces->getPropertyIndex("vertex_indices");
+    if(listIndex < 0)
+        listIndex = faces->getPropertyIndex("vertex_index");
+    long long pointsNumber = static_cast<long long>(vertices->count);
+
+    const char* position = chunk.begin;
+    const char* lineEnd;
+    for(size_t line = chunk.firstLine; nextLine(position, chunk.end, lineEnd); line++)
+    {
+        while(elementIndex < elements.size() && line >= elementFirstLine + elements[elementIndex].count)
+            elementFirstLine += elements[elementIndex++].count;
+        //Lines after the last element are ignored
+        if(elementIndex == elements.size())
+            break;
+
+        const PLYHeader::Element& element = elements[elementIndex];
+        size_t record = line - elementFirstLine;
+        if(&element == vertices)
+        {
+            double* point = coordinates + 3 * record;
+            for(unsigned int i = 0; i < element.properties.size(); i++)
+            {
+                double value;
+                if(element.properties[i].isList || !parseDouble(position, lineEnd, value))
+                    return false;
+                for(unsigned int j = 0; j < 3; j++)
+                    if(coordinateIndex[j] == static_cast<int>(i))
+                        point[j] = value;
+            }
+        } else if(&element == faces)
+        {
+            for(unsigned int i = 0; i < element.properties.size(); i++)
+            {
+                long long count;
+                double value;
+                if(!element.properties[i].isList)
+                {
+                    if(!parseDouble(position, lineEnd, value))
+                        return false;
+                    continue;
+                }
+                if(!parseInteger(position, lineEnd, count) || count < 0)
+                    return false;
+                if(static_cast<int>(i) == listIndex)
+                {
+                    if(count != 3)
+                        return false;
+                    for(unsigned int j = 0; j < 3; j++)
+                    {
+                        long long index;
+                        if(!parseInteger(position, lineEnd, index) || index < 0 || index >= pointsNumber)
+                            return false;
+                        connectivity[3 * record + j] = static_cast<vtkTypeInt32>(index);
+                    }
+                } else
+                    for(long long j = 0; j < count; j++)
+                        if(!parseDouble(position, lineEnd, value))
+                            return false;
+            }
+        }
+        position = lineEnd < chunk.end ? lineEnd + 1 : chunk.end;
+    }
+    return true;
+}
+
+bool PLYAsciiReader::hasOnlyGeometry() const
+{
+    return output != nullptr && isGeometryOnly(header);
+}
+
+bool PLYAsciiReader::hasOnlyGeometry(const std::string &filename)
+{
+    auto file = MappedFile::open(filename);
+    PLYHeader header;
+    return file != nullptr && header.parse(file->getData(), file->getSize()) &&
+           header.getFormat() == PLYHeader::Format::ASCII && isGeometryOnly(header);
+}
+
+bool PLYAsciiReader::writeBinary(const std::string &filename) const
+{
+    if(output == nullptr || !PLYHeader::isHostLittleEndian())
+        return false;
+    FILE* out = fopen(filename.c_str(), "wb");
+    if(out == nullptr)
+        return false;
+
+    vtkIdType pointsNumber = output->GetNumberOfPoints();
+    vtkIdType trianglesNumber = output->GetNumberOfPolys();
+    std::string plyHeader = "ply\nformat binary_little_endian 1.0\n"
+                            "element vertex " + std::to_string(pointsNumber) + "\n"
+                            "property double x\nproperty double y\nproperty double z\n"
+                            "element face " + std::to_string(trianglesNumber) + "\n"
+                            "property list uchar int vertex_indices\nend_header\n";
+    bool written = fwrite(plyHeader.data(), 1, plyHeader.size(), out) == plyHeader.size();
+
+    const double* coordinates = vtkDoubleArray::SafeDownCast(output->GetPoints()->GetData())->GetPointer(0);
+    size_t coordinatesSize = static_cast<size_t>(pointsNumber) * 3 * sizeof(double);
+    written = written && fwrite(coordinates, 1, coordinatesSize, out) == coordinatesSize;
+
+    //Face records are packed in blocks, a count byte and three indices each
+    const size_t RECORD_SIZE = 1 + 3 * sizeof(vtkTypeInt32);
+    const vtkIdType BLOCK_SIZE = 65536;
+    std::vector<char> block(static_cast<size_t>(BLOCK_SIZE) * RECORD_SIZE);
+    vtkSmartPointer<vtkIdList> triangle = vtkSmartPointer<vtkIdList>::New();
+    vtkSmartPointer<vtkCellArray> polys = output->GetPolys();
+    polys->InitTraversal();
+    for(vtkIdType first = 0; written && first < trianglesNumber; first += BLOCK_SIZE)
+    {
+        vtkIdType blockTriangles = std::min(BLOCK_SIZE, trianglesNumber - first);
+        char* record = block.data();
+        for(vtkIdType i = 0; i < blockTriangles; i++, record += RECORD_SIZE)
+        {
+            polys->GetNextCell(triangle);
+            record[0] = 3;
+            for(vtkIdType j = 0; j < 3; j++)
+            {
+                vtkTypeInt32 index = static_cast<vtkTypeInt32>(triangle->GetId(j));
+                memcpy(record + 1 + j * sizeof(vtkTypeInt32), &index, sizeof(vtkTypeInt32));
+            }
+        }
+        size_t blockSize = static_cast<size_t>(blockTriangles) * RECORD_SIZE;
+        written = fwrite(block.data(), 1, blockSize, out) == blockSize;
+    }
+    return (fclose(out) == 0) && written;
+}
+
+vtkSmartPointer<vtkPolyData> PLYAsciiReader::getOutput() const
+{
+    return output;
+}
+
+const PLYHeader &PLYAsciiReader::getHeader() const
+{
+    return header;
+}
+
+unsigned int PLYAsciiReader::getThreadsNumber() const
+{
+    return threadsNumber;
+}
+
+void PLYAsciiReader::setThreadsNumber(unsigned int newThreadsNumber)
+{
+    threadsNumber = newThreadsNumber;
+}
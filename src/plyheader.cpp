@@ -0,0 +1,186 @@
+#include "plyheader.hpp"
+
+#include <cstring>
+#include <sstream>
+
+using namespace std;
+
+int PLYHeader::Element::getPropertyIndex(const std::string &name) const
+{
+    for(unsigned int i = 0; i < properties.size(); i++)
+        if(properties[i].name.compare(name) == 0)
+            return static_cast<int>(i);
+    return -1;
+}
+
+PLYHeader::PLYHeader()
+{
+    format = Format::ASCII;
+    headerLength = 0;
+}
+
+bool PLYHeader::parse(const char *data, size_t size)
+{
+    elements.clear();
+    headerLength = 0;
+    if(size < 4 || strncmp(data, "ply", 3) != 0)
+        return false;
+
+    size_t position = 0;
+    bool formatFound = false;
+    while(position < size)
+    {
+        size_t lineEnd = position;
+        while(lineEnd < size && data[lineEnd] != '\n')
+            lineEnd++;
+        if(lineEnd == size)
+            return false;
+        string line(data + position, lineEnd - position);
+        if(!line.empty() && line.back() == '\r')
+            line.pop_back();
+        position = lineEnd + 1;
+
+        istringstream stream(line);
+        string keyword;
+        stream >> keyword;
+        if(keyword.compare("end_header") == 0)
+        {
+            headerLength = position;
+            return formatFound;
+        } else if(keyword.compare("format") == 0)
+        {
+            string formatName;
+            stream >> formatName;
+            if(formatName.compare("ascii") == 0)
+                format = Format::ASCII;
+            else if(formatName.compare("binary_little_endian") == 0)
+                format = Format::BINARY_LITTLE_ENDIAN;
+            else if(formatName.compare("binary_big_endian") == 0)
+                format = Format::BINARY_BIG_ENDIAN;
+            else
+                return false;
+            formatFound = true;
+        } else if(keyword.compare("element") == 0)
+        {
+            Element element;
+            stream >> element.name >> element.count;
+            if(stream.fail())
+                return false;
+            element.stride = 0;
+            elements.push_back(element);
+        } else if(keyword.compare("property") == 0)
+        {
+            if(elements.empty())
+                return false;
+            Element &element = elements.back();
+            Property property;
+            string typeName;
+            stream >> typeName;
+            property.isList = typeName.compare("list") == 0;
+            property.countType = Type::INVALID;
+            if(property.isList)
+            {
+                string countTypeName;
+                stream >> countTypeName >> typeName;
+                property.countType = getType(countTypeName);
+                if(property.countType == Type::INVALID)
+                    return false;
+            }
+            property.type = getType(typeName);
+            stream >> property.name;
+            if(property.type == Type::INVALID || stream.fail())
+                return false;
+
+            //Offsets are tracked while the record has a fixed size
+            bool fixedSize = true;
+            for(unsigned int i = 0; i < element.properties.size(); i++)
+                fixedSize = fixedSize && !element.properties[i].isList;
+            property.offset = fixedSize ? element.stride : 0;
+            if(fixedSize && !property.isList)
+                element.stride += getTypeSize(property.type);
+            else
+                element.stride = 0;
+            element.properties.push_back(property);
+        }
+        //comment and obj_info lines are ignored
+    }
+
+    return false;
+}
+
+size_t PLYHeader::getTypeSize(Type type)
+{
+    switch(type)
+    {
+        case Type::INT8:
+        case Type::UINT8:
+            return 1;
+        case Type::INT16:
+        case Type::UINT16:
+            return 2;
+        case Type::INT32:
+        case Type::UINT32:
+        case Type::FLOAT32:
+            return 4;
+        case Type::FLOAT64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+PLYHeader::Type PLYHeader::getType(const std::string &name)
+{
+    if(name.compare("char") == 0 || name.compare("int8") == 0)
+        return Type::INT8;
+    if(name.compare("uchar") == 0 || name.compare("uint8") == 0)
+        return Type::UINT8;
+    if(name.compare("short") == 0 || name.compare("int16") == 0)
+        return Type::INT16;
+    if(name.compare("ushort") == 0 || name.compare("uint16") == 0)
+        return Type::UINT16;
+    if(name.compare("int") == 0 || name.compare("int32") == 0)
+        return Type::INT32;
+    if(name.compare("uint") == 0 || name.compare("uint32") == 0)
+        return Type::UINT32;
+    if(name.compare("float") == 0 || name.compare("float32") == 0)
+        return Type::FLOAT32;
+    if(name.compare("double") == 0 || name.compare("float64") == 0)
+        return Type::FLOAT64;
+    return Type::INVALID;
+}
+
+bool PLYHeader::isHostLittleEndian()
+{
+    const unsigned int one = 1;
+    return *reinterpret_cast<const unsigned char*>(&one) == 1;
+}
+
+const PLYHeader::Element *PLYHeader::getElement(const std::string &name) const
+{
+    int index = getElementIndex(name);
+    return index < 0 ? nullptr : &elements[static_cast<unsigned int>(index)];
+}
+
+int PLYHeader::getElementIndex(const std::string &name) const
+{
+    for(unsigned int i = 0; i < elements.size(); i++)
+        if(elements[i].name.compare(name) == 0)
+            return static_cast<int>(i);
+    return -1;
+}
+
+PLYHeader::Format PLYHeader::getFormat() const
+{
+    return format;
+}
+
+size_t PLYHeader::getHeaderLength() const
+{
+    return headerLength;
+}
+
+const std::vector<PLYHeader::Element> &PLYHeader::getElements() const
+{
+    return elements;
+}
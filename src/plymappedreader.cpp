@@ -0,0 +1,104 @@
+#include "plymappedreader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+using namespace std;
+
+template<typename T>
+static T readValue(const char *position)
+{
+    T value;
+    memcpy(&value, position, sizeof(T));
+    return value;
+}
+
+static long long readInteger(const char *position, PLYHeader::Type type)
+{
+    switch(type)
+    {
+        case PLYHeader::Type::INT8:     return readValue<int8_t>(position);
+        case PLYHeader::Type::UINT8:    return readValue<uint8_t>(position);
+        case PLYHeader::Type::INT16:    return readValue<int16_t>(position);
+        case PLYHeader::Type::UINT16:   return readValue<uint16_t>(position);
+        case PLYHeader::Type::INT32:    return readValue<int32_t>(position);
+        case PLYHeader::Type::UINT32:   return readValue<uint32_t>(position);
+        case PLYHeader::Type::FLOAT32:  return static_cast<long long>(readValue<float>(position));
+        case PLYHeader::Type::FLOAT64:  return static_cast<long long>(readValue<double>(position));
+        default:                        return -1;
+    }
+}
+
+static double readDouble(const char *position, PLYHeader::Type type)
+{
+    if(type == PLYHeader::Type::FLOAT64)
+        return readValue<double>(position);
+    if(type == PLYHeader::Type::FLOAT32)
+        return readValue<float>(position);
+    return static_cast<double>(readInteger(position, type));
+}
+
+bool PLYMappedReader::canRead(const std::string &filename)
+{
+    std::ifstream stream(filename, std::ios::binary);
+    if(!stream.is_open())
+        return false;
+    std::string magic, formatKeyword, format;
+    std::getline(stream, magic);
+    stream >> formatKeyword >> format;
+    if(magic.compare(0, 3, "ply") != 0 || formatKeyword.compare("format") != 0)
+        return false;
+    return format.compare("binary_little_endian") == 0 && PLYHeader::isHostLittleEndian();
+}
+
+bool PLYMappedReader::readBounds(const std::string &filename, double bounds[6])
+{
+    auto file = MappedFile::open(filename);
+    PLYHeader header;
+    if(file == nullptr || !header.parse(file->getData(), file->getSize()) ||
+       header.getFormat() != PLYHeader::Format::BINARY_LITTLE_ENDIAN || !PLYHeader::isHostLittleEndian())
+        return false;
+
+    const char* position = file->getData() + header.getHeaderLength();
+    const char* end = file->getData() + file->getSize();
+    for(auto &element : header.getElements())
+    {
+        //Only fixed size records can be skipped without parsing them
+        if(element.stride == 0)
+            return false;
+        if(element.name.compare("vertex") != 0)
+        {
+            position += element.stride * element.count;
+            if(position > end)
+                return false;
+            continue;
+        }
+
+        int x = element.getPropertyIndex("x"), y = element.getPropertyIndex("y"), z = element.getPropertyIndex("z");
+        if(x < 0 || y < 0 || z < 0 || element.count == 0 || element.stride * element.count > static_cast<size_t>(end - position))
+            return false;
+        const PLYHeader::Property* coordinates[3] = {&element.properties[static_cast<unsigned int>(x)],
+                                                     &element.properties[static_cast<unsigned int>(y)],
+                                                     &element.properties[static_cast<unsigned int>(z)]};
+        for(unsigned int j = 0; j < 3; j++)
+        {
+            bounds[2 * j] = std::numeric_limits<double>::max();
+            bounds[2 * j + 1] = std::numeric_limits<double>::lowest();
+        }
+        for(size_t i = 0; i < element.count; i++)
+        {
+            const char* record = position + i * element.stride;
+            for(unsigned int j = 0; j < 3; j++)
+            {
+                double value = readDouble(record + coordinates[j]->offset, coordinates[j]->type);
+                bounds[2 * j] = std::min(bounds[2 * j], value);
+                bounds[2 * j + 1] = std::max(bounds[2 * j + 1], value);
+            }
+        }
+        return true;
+    }
+    return false;
+}
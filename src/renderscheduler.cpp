@@ -0,0 +1,114 @@
+#include "renderscheduler.hpp"
+
+#include <algorithm>
+
+RenderScheduler::RenderScheduler(QObject *parent) : QObject(parent)
+{
+    frameInterval = DEFAULT_FRAME_INTERVAL;
+    latencyBudget = DEFAULT_LATENCY_BUDGET;
+    pending = false;
+    lastRender = -1;
+    firstRequest = 0;
+    resetCounters();
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(slotTimeout()));
+    clock.start();
+}
+
+void RenderScheduler::requestRender()
+{
+    requestsNumber++;
+    if(pending)
+        return;
+
+    pending = true;
+    firstRequest = clock.elapsed();
+    qint64 delay = 0;
+    if(lastRender >= 0)
+        delay = std::max(static_cast<qint64>(0), lastRender + frameInterval - firstRequest);
+    delay = std::min(delay, static_cast<qint64>(latencyBudget));
+    timer.start(static_cast<int>(delay));
+}
+
+void RenderScheduler::renderNow()
+{
+    if(!pending)
+        return;
+    timer.stop();
+    slotTimeout();
+}
+
+bool RenderScheduler::isPending() const
+{
+    return pending;
+}
+
+void RenderScheduler::slotTimeout()
+{
+    pending = false;
+    lastRender = clock.elapsed();
+    qint64 latency = lastRender - firstRequest;
+    rendersNumber++;
+    totalLatency += latency;
+    maxLatency = std::max(maxLatency, latency);
+    if(latency > latencyBudget)
+        lateRendersNumber++;
+    emit(render());
+}
+
+int RenderScheduler::getFrameInterval() const
+{
+    return frameInterval;
+}
+
+void RenderScheduler::setFrameInterval(int newFrameInterval)
+{
+    frameInterval = std::max(0, newFrameInterval);
+}
+
+int RenderScheduler::getLatencyBudget() const
+{
+    return latencyBudget;
+}
+
+void RenderScheduler::setLatencyBudget(int newLatencyBudget)
+{
+    latencyBudget = std::max(0, newLatencyBudget);
+}
+
+unsigned long RenderScheduler::getRequestsNumber() const
+{
+    return requestsNumber;
+}
+
+unsigned long RenderScheduler::getRendersNumber() const
+{
+    return rendersNumber;
+}
+
+unsigned long RenderScheduler::getLateRendersNumber() const
+{
+    return lateRendersNumber;
+}
+
+qint64 RenderScheduler::getMaxLatency() const
+{
+    return maxLatency;
+}
+
+double RenderScheduler::getMeanLatency() const
+{
+    if(rendersNumber == 0)
+        return 0;
+    return static_cast<double>(totalLatency) / rendersNumber;
+}
+
+void RenderScheduler::resetCounters()
+{
+    requestsNumber = 0;
+    rendersNumber = 0;
+    lateRendersNumber = 0;
+    maxLatency = 0;
+    totalLatency = 0;
+}
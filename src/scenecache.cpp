@@ -0,0 +1,376 @@
+#include "scenecache.hpp"
+#include "meshindex.hpp"
+
+#include <algorithm>
+#include <set>
+
+using namespace std;
+using namespace SemantisedTriangleMesh;
+using namespace Drawables;
+
+SceneCache::SceneCache()
+{
+    meshDirty = true;
+    version = 0;
+    chunkedSurface = std::make_shared<ChunkedSurface>();
+    measureBatch = std::make_shared<MeasureBatchRenderer>();
+    measuresDirty = true;
+    outlineLayer = std::make_shared<AnnotationOutlineLayer>();
+}
+
+void SceneCache::update()
+{
+    if(assembly == nullptr)
+        return;
+
+    updateBackgroundMeshes();
+    if(mesh == nullptr)
+        return;
+
+    if(meshDirty)
+    {
+        //Annotations have their own entries, the mesh only draws its surface
+        if(meshCanvas != nullptr)
+            assembly->RemovePart(meshCanvas);
+        mesh->setDrawAnnotations(false);
+        mesh->setDrawWireframe(false);
+        mesh->draw(assembly);
+        meshCanvas = mesh->getCanvas();
+        meshDirty = false;
+        version++;
+        if(palette != nullptr)
+            palette->setActor(mesh->getSurfaceActor());
+        drawChunks();
+    }
+    if(palette != nullptr)
+        palette->update();
+
+    std::set<Annotation*> present;
+    for(auto annotation : mesh->getAnnotations())
+    {
+        auto drawable = dynamic_pointer_cast<DrawableAnnotation>(annotation);
+        if(drawable == nullptr)
+            continue;
+        present.insert(annotation.get());
+        auto it = entries.find(annotation.get());
+        if(it == entries.end())
+        {
+            Entry entry;
+            entry.annotation = drawable;
+            entry.dirty = false;
+            entry.viewDirty = false;
+            entry.layered = AnnotationOutlineLayer::isLayered(annotation);
+            if(entry.layered)
+                outlineLayer->add(drawable);
+            else
+            {
+                drawable->draw(assembly);
+                entry.canvas = drawable->getCanvas();
+            }
+            detachMeasures(entry);
+            entries.insert(std::make_pair(annotation.get(), entry));
+            version++;
+        } else if(it->second.dirty)
+            drawAnnotation(it->second);
+        else if(it->second.viewDirty)
+            updateAnnotationView(it->second);
+        else if(!it->second.dirtyAttributes.empty())
+            drawAttributes(it->second);
+    }
+
+    //Deleted annotations
+    for(auto it = entries.begin(); it != entries.end();)
+        if(present.find(it->first) == present.end())
+        {
+            if(it->second.layered)
+                outlineLayer->remove(it->first);
+            else
+                assembly->RemovePart(it->second.canvas);
+            it = entries.erase(it);
+            version++;
+            measuresDirty = true;
+        } else
+            it++;
+
+    outlineLayer->update();
+    assembly->AddPart(outlineLayer->getActor());
+    if(measuresDirty)
+    {
+        assembly->RemovePart(measureBatch->getCanvas());
+        measureBatch->build(mesh);
+        assembly->AddPart(measureBatch->getCanvas());
+        measuresDirty = false;
+    }
+}
+
+void SceneCache::markMeshDirty()
+{
+    meshDirty = true;
+}
+
+void SceneCache::markAnnotationDirty(const std::string &id)
+{
+    auto entry = findEntry(id);
+    if(entry != nullptr)
+        entry->dirty = true;
+}
+
+void SceneCache::markAnnotationViewDirty(const std::string &id)
+{
+    auto entry = findEntry(id);
+    if(entry != nullptr)
+        entry->viewDirty = true;
+}
+
+void SceneCache::markAttributeDirty(const std::string &annotationId, unsigned int attributeId)
+{
+    auto entry = findEntry(annotationId);
+    if(entry == nullptr || entry->dirty)
+        return;
+    for(auto attribute : entry->annotation->getAttributes())
+        if(static_cast<unsigned int>(attribute->getId()) == attributeId)
+        {
+            auto drawable = dynamic_pointer_cast<DrawableAttribute>(attribute);
+            if(drawable != nullptr)
+                entry->dirtyAttributes.push_back(drawable);
+        }
+}
+
+void SceneCache::markAllDirty()
+{
+    meshDirty = true;
+    for(auto &entry : entries)
+        entry.second.dirty = true;
+}
+
+unsigned long SceneCache::getVersion() const
+{
+    return version;
+}
+
+void SceneCache::setBackgroundMeshes(const std::vector<std::shared_ptr<DrawableTriangleMesh> > &meshes)
+{
+    backgroundMeshes = meshes;
+}
+
+vtkSmartPointer<vtkPropAssembly> SceneCache::getAssembly() const
+{
+    return assembly;
+}
+
+void SceneCache::setAssembly(const vtkSmartPointer<vtkPropAssembly> &newAssembly)
+{
+    if(newAssembly == assembly)
+        return;
+    assembly = newAssembly;
+    meshCanvas = nullptr;
+    meshDirty = true;
+    measuresDirty = true;
+    entries.clear();
+    outlineLayer->clear();
+    drawnBackgroundMeshes.clear();
+}
+
+std::shared_ptr<DrawableTriangleMesh> SceneCache::getMesh() const
+{
+    return mesh;
+}
+
+void SceneCache::setMesh(const std::shared_ptr<DrawableTriangleMesh> &newMesh)
+{
+    if(newMesh == mesh)
+        return;
+    removeMesh();
+    mesh = newMesh;
+    meshDirty = true;
+}
+
+std::shared_ptr<CellPalette> SceneCache::getPalette() const
+{
+    return palette;
+}
+
+void SceneCache::setPalette(const std::shared_ptr<CellPalette> &newPalette)
+{
+    palette = newPalette;
+    if(palette != nullptr)
+        palette->setChunks(chunkedSurface);
+}
+
+std::shared_ptr<ChunkedSurface> SceneCache::getChunkedSurface() const
+{
+    return chunkedSurface;
+}
+
+std::shared_ptr<MeasureBatchRenderer> SceneCache::getMeasureBatch() const
+{
+    return measureBatch;
+}
+
+std::shared_ptr<AnnotationOutlineLayer> SceneCache::getOutlineLayer() const
+{
+    return outlineLayer;
+}
+
+void SceneCache::setRenderer(const vtkSmartPointer<vtkRenderer> &newRenderer)
+{
+    chunkedSurface->setRenderer(newRenderer);
+}
+
+void SceneCache::drawAnnotation(Entry &entry)
+{
+    entry.annotation->update();
+    if(entry.layered)
+        outlineLayer->markGeometryDirty(entry.annotation.get());
+    else
+    {
+        assembly->RemovePart(entry.canvas);
+        entry.annotation->draw(assembly);
+        entry.canvas = entry.annotation->getCanvas();
+    }
+    detachMeasures(entry);
+    entry.dirty = false;
+    entry.viewDirty = false;
+    entry.dirtyAttributes.clear();
+    version++;
+}
+
+void SceneCache::updateAnnotationView(Entry &entry)
+{
+    //Annotations drawn by the layer only need their cells to be written, the others are drawn again
+    if(!entry.layered)
+    {
+        drawAnnotation(entry);
+        return;
+    }
+    outlineLayer->updateView(entry.annotation.get());
+    detachMeasures(entry);
+    entry.viewDirty = false;
+    version++;
+}
+
+void SceneCache::drawAttributes(Entry &entry)
+{
+    if(entry.layered)
+    {
+        //Annotations without a canvas have all their measures in the batch
+        measuresDirty = true;
+        entry.dirtyAttributes.clear();
+        version++;
+        return;
+    }
+    //Attributes are drawn in the canvas of their annotation
+    for(auto attribute : entry.dirtyAttributes)
+    {
+        entry.canvas->RemovePart(attribute->getCanvas());
+        attribute->update();
+        attribute->draw(entry.canvas);
+    }
+    detachMeasures(entry);
+    entry.dirtyAttributes.clear();
+    version++;
+}
+
+void SceneCache::detachMeasures(Entry &entry)
+{
+    //The batch draws them, their own actors would only add draw calls
+    for(auto attribute : entry.annotation->getAttributes())
+        if(MeasureBatchRenderer::isBatched(attribute))
+        {
+            auto drawable = dynamic_pointer_cast<DrawableAttribute>(attribute);
+            if(entry.canvas != nullptr && drawable != nullptr && drawable->getCanvas() != nullptr)
+                entry.canvas->RemovePart(drawable->getCanvas());
+            measuresDirty = true;
+        }
+}
+
+void SceneCache::drawChunks()
+{
+    //The chunks replace the surface actor, which stays in the canvas of the mesh for the palette
+    assembly->RemovePart(chunkedSurface->getCanvas());
+    auto surfaceActor = mesh->getSurfaceActor();
+    chunkedSurface->build(surfaceActor);
+    if(surfaceActor == nullptr)
+        return;
+    if(chunkedSurface->isBuilt())
+    {
+        surfaceActor->VisibilityOff();
+        assembly->AddPart(chunkedSurface->getCanvas());
+    } else
+        surfaceActor->VisibilityOn();
+}
+
+void SceneCache::removeMesh()
+{
+    //The mesh may be drawn again as a background one, by its own actor
+    if(chunkedSurface->getSurfaceActor() != nullptr)
+        chunkedSurface->getSurfaceActor()->VisibilityOn();
+    if(assembly != nullptr)
+    {
+        assembly->RemovePart(chunkedSurface->getCanvas());
+        assembly->RemovePart(measureBatch->getCanvas());
+        assembly->RemovePart(outlineLayer->getActor());
+        if(meshCanvas != nullptr)
+            assembly->RemovePart(meshCanvas);
+        for(auto &entry : entries)
+            if(!entry.second.layered)
+                assembly->RemovePart(entry.second.canvas);
+    }
+    meshCanvas = nullptr;
+    chunkedSurface->clear();
+    measureBatch->clear();
+    measuresDirty = true;
+    outlineLayer->clear();
+    entries.clear();
+    version++;
+}
+
+void SceneCache::removeBackgroundMesh(const std::shared_ptr<DrawableTriangleMesh> &backgroundMesh)
+{
+    assembly->RemovePart(backgroundMesh->getCanvas());
+    for(auto annotation : backgroundMesh->getAnnotations())
+    {
+        auto drawable = dynamic_pointer_cast<DrawableAnnotation>(annotation);
+        if(drawable != nullptr)
+            assembly->RemovePart(drawable->getCanvas());
+    }
+}
+
+void SceneCache::updateBackgroundMeshes()
+{
+    std::set<DrawableTriangleMesh*> wanted;
+    for(auto backgroundMesh : backgroundMeshes)
+        if(backgroundMesh != nullptr && backgroundMesh != mesh)
+            wanted.insert(backgroundMesh.get());
+
+    for(auto it = drawnBackgroundMeshes.begin(); it != drawnBackgroundMeshes.end();)
+        if(wanted.find(it->first) == wanted.end())
+        {
+            removeBackgroundMesh(it->second);
+            it = drawnBackgroundMeshes.erase(it);
+        } else
+            it++;
+
+    for(auto backgroundMesh : backgroundMeshes)
+        if(wanted.find(backgroundMesh.get()) != wanted.end() &&
+           drawnBackgroundMeshes.find(backgroundMesh.get()) == drawnBackgroundMeshes.end())
+        {
+            backgroundMesh->setDrawAnnotations(true);
+            backgroundMesh->setDrawWireframe(false);
+            backgroundMesh->draw(assembly);
+            drawnBackgroundMeshes.insert(std::make_pair(backgroundMesh.get(), backgroundMesh));
+        }
+}
+
+SceneCache::Entry *SceneCache::findEntry(const std::string &id)
+{
+    if(mesh == nullptr)
+        return nullptr;
+    auto annotation = mesh->getAnnotation(toIndex(id));
+    if(annotation == nullptr)
+        return nullptr;
+    auto it = entries.find(annotation.get());
+    if(it == entries.end())
+        return nullptr;
+    return &it->second;
+}
@@ -0,0 +1,222 @@
+#include "screenlasso.hpp"
+
+#include <vtkCamera.h>
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPoints.h>
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+ScreenLasso::ScreenLasso()
+{
+    std::fill(origin, origin + 3, 0.0);
+    geometryTime = 0;
+    threadsNumber = 0;
+}
+
+void ScreenLasso::addPoint(double x, double y)
+{
+    float fx = static_cast<float>(x), fy = static_cast<float>(y);
+    if(polygon.size() >= 2 && polygon[polygon.size() - 2] == fx && polygon.back() == fy)
+        return;
+    polygon.push_back(fx);
+    polygon.push_back(fy);
+}
+
+void ScreenLasso::clear()
+{
+    polygon.clear();
+}
+
+unsigned int ScreenLasso::getPointsNumber() const
+{
+    return static_cast<unsigned int>(polygon.size() / 2);
+}
+
+const std::vector<float> &ScreenLasso::getPolygon() const
+{
+    return polygon;
+}
+
+std::vector<vtkIdType> ScreenLasso::select(vtkPolyData *surface, const double matrix[16], int width, int height)
+{
+    std::vector<vtkIdType> selected;
+    if(surface == nullptr || surface->GetPoints() == nullptr || getPointsNumber() < 3 || width <= 0 || height <= 0)
+        return selected;
+    if(surface != this->surface || getGeometryTime(surface) != geometryTime)
+    {
+        this->surface = surface;
+        readTriangles();
+        double* bounds = surface->GetBounds();
+        for(unsigned int i = 0; i < 3; i++)
+            origin[i] = bounds[2 * i];
+        geometryTime = getGeometryTime(surface);
+    }
+
+    //Edges of the closed polygon, with the bounding box that rejects most of the points before them
+    std::vector<Edge> edges;
+    float box[4] = {polygon[0], polygon[1], polygon[0], polygon[1]};
+    unsigned int cornersNumber = getPointsNumber();
+    for(unsigned int i = 0; i < cornersNumber; i++)
+    {
+        unsigned int j = (i + 1) % cornersNumber;
+        Edge edge;
+        edge.x0 = polygon[2 * i];
+        edge.y0 = polygon[2 * i + 1];
+        edge.y1 = polygon[2 * j + 1];
+        edge.slope = edge.y1 != edge.y0 ? (polygon[2 * j] - edge.x0) / (edge.y1 - edge.y0) : 0.0f;
+        edges.push_back(edge);
+        box[0] = std::min(box[0], edge.x0);
+        box[1] = std::min(box[1], edge.y0);
+        box[2] = std::max(box[2], edge.x0);
+        box[3] = std::max(box[3], edge.y0);
+    }
+    //The points are moved to the origin before being narrowed to float, the matrix moves them back: its translation
+    //is computed in double, so that georeferenced coordinates keep their precision
+    float m[16];
+    for(unsigned int i = 0; i < 4; i++)
+    {
+        double translation = matrix[4 * i + 3];
+        for(unsigned int j = 0; j < 3; j++)
+        {
+            m[4 * i + j] = static_cast<float>(matrix[4 * i + j]);
+            translation += matrix[4 * i + j] * origin[j];
+        }
+        m[4 * i + 3] = static_cast<float>(translation);
+    }
+
+    unsigned int threads = threadsNumber > 0 ? threadsNumber : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+
+    //Each thread classifies whole batches of points
+    vtkIdType pointsNumber = surface->GetNumberOfPoints();
+    vtkIdType batchesNumber = (pointsNumber + BATCH_SIZE - 1) / BATCH_SIZE;
+    std::vector<uint8_t> inside(static_cast<size_t>(pointsNumber), 0);
+    for(unsigned int i = 0; i < threads; i++)
+        workers.push_back(std::thread([this, &m, &edges, &box, &inside, width, height, pointsNumber, batchesNumber, threads, i]()
+        {
+            vtkIdType begin = std::min(pointsNumber, batchesNumber * i / threads * BATCH_SIZE);
+            vtkIdType end = std::min(pointsNumber, batchesNumber * (i + 1) / threads * BATCH_SIZE);
+            classifyPoints(m, static_cast<float>(width), static_cast<float>(height), edges, box, begin, end, inside);
+        }));
+    for(auto &worker : workers)
+        worker.join();
+    workers.clear();
+
+    //Then the triangles, each thread keeping its own ids so that they come out in order
+    size_t trianglesNumber = triangles.size() / 3;
+    std::vector<std::vector<vtkIdType> > parts(threads);
+    for(unsigned int i = 0; i < threads; i++)
+        workers.push_back(std::thread([this, &inside, &parts, trianglesNumber, threads, i]()
+        {
+            for(size_t t = trianglesNumber * i / threads; t < trianglesNumber * (i + 1) / threads; t++)
+            {
+                const uint32_t* v = &triangles[3 * t];
+                if(v[0] != std::numeric_limits<uint32_t>::max() && inside[v[0]] && inside[v[1]] && inside[v[2]])
+                    parts[i].push_back(static_cast<vtkIdType>(t));
+            }
+        }));
+    for(auto &worker : workers)
+        worker.join();
+
+    for(auto &part : parts)
+        selected.insert(selected.end(), part.begin(), part.end());
+    return selected;
+}
+
+std::vector<vtkIdType> ScreenLasso::select(vtkPolyData *surface, vtkRenderer *renderer)
+{
+    if(surface == nullptr || renderer == nullptr)
+        return std::vector<vtkIdType>();
+    int* size = renderer->GetSize();
+    vtkMatrix4x4* composite = renderer->GetActiveCamera()->GetCompositeProjectionTransformMatrix(renderer->GetTiledAspectRatio(), -1, 1);
+    return select(surface, composite->GetData(), size[0], size[1]);
+}
+
+unsigned int ScreenLasso::getThreadsNumber() const
+{
+    return threadsNumber;
+}
+
+void ScreenLasso::setThreadsNumber(unsigned int newThreadsNumber)
+{
+    threadsNumber = newThreadsNumber;
+}
+
+vtkMTimeType ScreenLasso::getGeometryTime(vtkPolyData *polydata) const
+{
+    vtkMTimeType time = 0;
+    if(polydata == nullptr)
+        return time;
+    if(polydata->GetPoints() != nullptr)
+        time = std::max(time, polydata->GetPoints()->GetMTime());
+    if(polydata->GetPolys() != nullptr)
+        time = std::max(time, polydata->GetPolys()->GetMTime());
+    return time;
+}
+
+void ScreenLasso::readTriangles()
+{
+    triangles.clear();
+    if(surface == nullptr || surface->GetPolys() == nullptr)
+        return;
+    vtkCellArray* polys = surface->GetPolys();
+    triangles.reserve(3 * static_cast<size_t>(polys->GetNumberOfCells()));
+    //Every poly keeps its slot, so that its index is still its id
+    auto points = vtkSmartPointer<vtkIdList>::New();
+    polys->InitTraversal();
+    while(polys->GetNextCell(points))
+        for(vtkIdType j = 0; j < 3; j++)
+            triangles.push_back(points->GetNumberOfIds() >= 3 ? static_cast<uint32_t>(points->GetId(j)) : std::numeric_limits<uint32_t>::max());
+}
+
+void ScreenLasso::classifyPoints(const float matrix[16], float width, float height, const std::vector<Edge> &edges,
+                                 const float box[4], vtkIdType begin, vtkIdType end, std::vector<uint8_t> &inside) const
+{
+    float x[BATCH_SIZE], y[BATCH_SIZE], z[BATCH_SIZE];
+    float sx[BATCH_SIZE], sy[BATCH_SIZE];
+    uint8_t in[BATCH_SIZE], crossings[BATCH_SIZE];
+    double p[3];
+    for(vtkIdType first = begin; first < end; first += BATCH_SIZE)
+    {
+        unsigned int count = static_cast<unsigned int>(std::min(end - first, static_cast<vtkIdType>(BATCH_SIZE)));
+        for(unsigned int k = 0; k < count; k++)
+        {
+            surface->GetPoint(first + k, p);
+            x[k] = static_cast<float>(p[0] - origin[0]);
+            y[k] = static_cast<float>(p[1] - origin[1]);
+            z[k] = static_cast<float>(p[2] - origin[2]);
+        }
+
+        //Projection to viewport pixels, the same as the id buffer. The division is not guarded, so that the loop has no
+        //branches: the points behind the camera are rejected by their w anyway
+        const float epsilon = std::numeric_limits<float>::epsilon();
+        for(unsigned int k = 0; k < count; k++)
+        {
+            float w = matrix[12] * x[k] + matrix[13] * y[k] + matrix[14] * z[k] + matrix[15];
+            float inverse = 1.0f / w;
+            sx[k] = ((matrix[0] * x[k] + matrix[1] * y[k] + matrix[2] * z[k] + matrix[3]) * inverse + 1.0f) * 0.5f * width;
+            sy[k] = ((matrix[4] * x[k] + matrix[5] * y[k] + matrix[6] * z[k] + matrix[7]) * inverse + 1.0f) * 0.5f * height;
+            in[k] = static_cast<uint8_t>(w > epsilon);
+        }
+        for(unsigned int k = 0; k < count; k++)
+        {
+            in[k] &= static_cast<uint8_t>((sx[k] >= box[0]) & (sx[k] <= box[2]) & (sy[k] >= box[1]) & (sy[k] <= box[3]));
+            crossings[k] = 0;
+        }
+
+        //Crossing number: a point is inside if a ray towards +x crosses the polygon an odd number of times
+        for(auto &edge : edges)
+            for(unsigned int k = 0; k < count; k++)
+            {
+                uint8_t straddles = static_cast<uint8_t>((edge.y0 > sy[k]) != (edge.y1 > sy[k]));
+                crossings[k] ^= static_cast<uint8_t>(straddles & (sx[k] < edge.x0 + (sy[k] - edge.y0) * edge.slope));
+            }
+
+        for(unsigned int k = 0; k < count; k++)
+            inside[static_cast<size_t>(first + k)] = in[k] & crossings[k];
+    }
+}
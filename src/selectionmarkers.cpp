@@ -0,0 +1,112 @@
+#include "selectionmarkers.hpp"
+
+#include <vtkProperty.h>
+
+SelectionMarkers::SelectionMarkers()
+{
+    points = vtkSmartPointer<vtkPoints>::New();
+    points->SetDataTypeToDouble();
+    polydata = vtkSmartPointer<vtkPolyData>::New();
+    polydata->SetPoints(points);
+    sphere = vtkSmartPointer<vtkSphereSource>::New();
+    mapper = vtkSmartPointer<vtkGlyph3DMapper>::New();
+    mapper->SetInputData(polydata);
+    mapper->SetSourceConnection(sphere->GetOutputPort());
+    mapper->ScalingOff();
+    mapper->OrientOff();
+    actor = vtkSmartPointer<vtkActor>::New();
+    actor->SetMapper(mapper);
+    actor->GetProperty()->SetColor(0,0,1);
+}
+
+void SelectionMarkers::addPoint(long id, const double point[3])
+{
+    auto it = indices.find(id);
+    if(it != indices.end())
+        points->SetPoint(it->second, point);
+    else
+    {
+        indices.insert(std::make_pair(id, points->InsertNextPoint(point)));
+        ids.push_back(id);
+    }
+    modified();
+}
+
+void SelectionMarkers::removePoint(long id)
+{
+    auto it = indices.find(id);
+    if(it == indices.end())
+        return;
+
+    //The last marker takes the place of the removed one
+    vtkIdType index = it->second;
+    vtkIdType last = points->GetNumberOfPoints() - 1;
+    if(index != last)
+    {
+        double point[3];
+        points->GetPoint(last, point);
+        points->SetPoint(index, point);
+        ids[static_cast<size_t>(index)] = ids.back();
+        indices[ids.back()] = index;
+    }
+    indices.erase(it);
+    ids.pop_back();
+    points->SetNumberOfPoints(last);
+    modified();
+}
+
+bool SelectionMarkers::contains(long id) const
+{
+    return indices.find(id) != indices.end();
+}
+
+void SelectionMarkers::clear()
+{
+    if(ids.empty())
+        return;
+    points->Reset();
+    indices.clear();
+    ids.clear();
+    modified();
+}
+
+size_t SelectionMarkers::size() const
+{
+    return ids.size();
+}
+
+bool SelectionMarkers::empty() const
+{
+    return ids.empty();
+}
+
+std::vector<long> SelectionMarkers::getIds() const
+{
+    return ids;
+}
+
+double SelectionMarkers::getRadius() const
+{
+    return sphere->GetRadius();
+}
+
+void SelectionMarkers::setRadius(double newRadius)
+{
+    sphere->SetRadius(newRadius);
+}
+
+void SelectionMarkers::setColor(double r, double g, double b)
+{
+    actor->GetProperty()->SetColor(r, g, b);
+}
+
+vtkSmartPointer<vtkActor> SelectionMarkers::getActor() const
+{
+    return actor;
+}
+
+void SelectionMarkers::modified()
+{
+    points->Modified();
+    polydata->Modified();
+}
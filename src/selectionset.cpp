@@ -0,0 +1,85 @@
+#include "selectionset.hpp"
+
+#include <cstddef>
+
+SelectionSet::SelectionSet()
+{
+    selectedNumber = 0;
+}
+
+void SelectionSet::reserve(unsigned long elementsNumber)
+{
+    if(bits.size() * 64 < elementsNumber)
+        bits.resize((elementsNumber + 63) / 64, 0);
+}
+
+bool SelectionSet::insert(unsigned long id)
+{
+    if(contains(id))
+        return false;
+    reserve(id + 1);
+    bits[id / 64] |= uint64_t(1) << (id % 64);
+    ids.push_back(id);
+    selectedNumber++;
+    return true;
+}
+
+bool SelectionSet::erase(unsigned long id)
+{
+    if(!contains(id))
+        return false;
+    bits[id / 64] &= ~(uint64_t(1) << (id % 64));
+    selectedNumber--;
+    //The list is not searched: the id is dropped from it when the removed ones are too many
+    if(ids.size() > 2 * selectedNumber + 64)
+        compact();
+    return true;
+}
+
+bool SelectionSet::contains(unsigned long id) const
+{
+    return id / 64 < bits.size() && (bits[id / 64] & (uint64_t(1) << (id % 64))) != 0;
+}
+
+void SelectionSet::clear()
+{
+    for(auto id : ids)
+        bits[id / 64] &= ~(uint64_t(1) << (id % 64));
+    ids.clear();
+    selectedNumber = 0;
+}
+
+unsigned long SelectionSet::size() const
+{
+    return selectedNumber;
+}
+
+bool SelectionSet::empty() const
+{
+    return selectedNumber == 0;
+}
+
+const std::vector<unsigned long> &SelectionSet::getIds() const
+{
+    if(ids.size() != selectedNumber)
+        compact();
+    return ids;
+}
+
+void SelectionSet::compact() const
+{
+    //Ids removed and selected again are in the list twice: the bit of each kept id is cleared so that it is kept once
+    size_t kept = 0;
+    for(size_t i = 0; i < ids.size(); i++)
+    {
+        unsigned long id = ids[i];
+        if(contains(id))
+        {
+            bits[id / 64] &= ~(uint64_t(1) << (id % 64));
+            ids[kept++] = id;
+        }
+    }
+    ids.resize(kept);
+    for(auto id : ids)
+        bits[id / 64] |= uint64_t(1) << (id % 64);
+}
@@ -0,0 +1,494 @@
+#include "tilemanager.hpp"
+#include "binaryannotationfilemanager.hpp"
+#include "mappedfile.hpp"
+#include "plyasciireader.hpp"
+#include "plyheader.hpp"
+#include "plymappedreader.hpp"
+
+#include <vtkActor.h>
+#include <vtkMapper.h>
+#include <vtkPLYReader.h>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <limits>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace SemantisedTriangleMesh;
+using namespace Drawables;
+
+static const unsigned int MAX_GRID_SIZE = 256;
+
+double TileManager::Tile::getDistance(const double point[3]) const
+{
+    double squaredDistance = 0;
+    for(unsigned int i = 0; i < 3; i++)
+    {
+        double d = std::max(std::max(bounds[2 * i] - point[i], 0.0), point[i] - bounds[2 * i + 1]);
+        squaredDistance += d * d;
+    }
+    return std::sqrt(squaredDistance);
+}
+
+TileManager::TileManager(QObject *parent) : QObject(parent)
+{
+    memoryBudget = DEFAULT_MEMORY_BUDGET;
+    residentRadius = 0;
+    pinnedTile = -1;
+    stopping = false;
+    cellSize = 1;
+    gridSize[0] = gridSize[1] = gridSize[2] = 0;
+    std::fill(bounds, bounds + 6, 0.0);
+}
+
+TileManager::~TileManager()
+{
+    close();
+}
+
+bool TileManager::open(const std::vector<std::string> &filenames)
+{
+    close();
+    if(filenames.empty())
+        return false;
+
+    std::vector<std::shared_ptr<Tile> > opened(filenames.size());
+    for(unsigned int i = 0; i < filenames.size(); i++)
+    {
+        opened[i] = std::make_shared<Tile>();
+        opened[i]->id = i;
+        opened[i]->filename = filenames[i];
+        opened[i]->state = TileState::UNLOADED;
+        opened[i]->estimatedBytes = 0;
+    }
+
+    //Only the headers and the vertex coordinates are read here, a few tiles at a time
+    unsigned int threadsNumber = std::max(1u, std::min<unsigned int>(std::thread::hardware_concurrency(), static_cast<unsigned int>(filenames.size())));
+    std::vector<char> valid(filenames.size(), 0);
+    std::vector<std::thread> threads;
+    for(unsigned int t = 0; t < threadsNumber; t++)
+        threads.push_back(std::thread([&opened, &valid, t, threadsNumber]()
+        {
+            for(size_t i = t; i < opened.size(); i += threadsNumber)
+                valid[i] = readTileInfo(*opened[i]);
+        }));
+    for(auto &thread : threads)
+        thread.join();
+
+    for(unsigned int i = 0; i < opened.size(); i++)
+        if(!valid[i])
+        {
+            emit(loadingFailed("Unable to read the tile " + QString::fromStdString(filenames[i])));
+            return false;
+        }
+
+    tiles = opened;
+    buildIndex();
+    startWorkers();
+    return true;
+}
+
+void TileManager::close()
+{
+    stopWorkers();
+    //Pending evictions still have annotations to write, resident tiles too
+    for(auto task : tasks)
+        if(!task.load)
+            evictTile(tiles[task.tile]);
+    tasks.clear();
+    for(auto tile : tiles)
+        if(tile->state == TileState::RESIDENT)
+            writeAnnotations(tile);
+    tiles.clear();
+    cells.clear();
+    pinnedTile = -1;
+}
+
+bool TileManager::isOpen() const
+{
+    return !tiles.empty();
+}
+
+void TileManager::update(const double viewpoint[3])
+{
+    if(tiles.empty())
+        return;
+
+    auto candidates = queryIndex(viewpoint, residentRadius);
+    std::vector<double> distances(tiles.size(), 0);
+    for(auto id : candidates)
+        distances[id] = tiles[id]->getDistance(viewpoint);
+    std::sort(candidates.begin(), candidates.end(), [&distances](unsigned int a, unsigned int b){ return distances[a] < distances[b]; });
+
+    std::vector<unsigned int> evicted;
+    {
+        std::lock_guard<std::mutex> lock(tilesMutex);
+        std::vector<bool> desired(tiles.size(), false);
+        size_t used = 0;
+        if(pinnedTile >= 0)
+        {
+            desired[pinnedTile] = true;
+            used += tiles[pinnedTile]->estimatedBytes;
+        }
+        for(auto id : candidates)
+        {
+            if(desired[id])
+                continue;
+            //The nearest tile is always wanted, even if it does not fit the budget alone
+            if(used > 0 && used + tiles[id]->estimatedBytes > memoryBudget)
+                break;
+            desired[id] = true;
+            used += tiles[id]->estimatedBytes;
+        }
+
+        //Loads not started yet may no longer be needed
+        for(auto it = tasks.begin(); it != tasks.end();)
+        {
+            if(it->load && !desired[it->tile])
+            {
+                tiles[it->tile]->state = TileState::UNLOADED;
+                it = tasks.erase(it);
+            } else
+                it++;
+        }
+
+        for(auto tile : tiles)
+            if(tile->state == TileState::RESIDENT && !desired[tile->id])
+            {
+                tile->state = TileState::EVICTING;
+                evicted.push_back(tile->id);
+            }
+
+        for(auto id : candidates)
+            if(desired[id] && tiles[id]->state == TileState::UNLOADED)
+            {
+                tiles[id]->state = TileState::LOADING;
+                Task task;
+                task.tile = id;
+                task.load = true;
+                tasks.push_back(task);
+            }
+    }
+
+    //Views drop the evicted tiles before the workers release them
+    for(auto id : evicted)
+        emit(tileEvicted(id));
+
+    {
+        std::lock_guard<std::mutex> lock(tilesMutex);
+        for(auto id : evicted)
+        {
+            Task task;
+            task.tile = id;
+            task.load = false;
+            tasks.push_front(task);
+        }
+    }
+    tasksCondition.notify_all();
+}
+
+std::vector<std::shared_ptr<TileManager::Tile> > TileManager::getResidentTiles() const
+{
+    std::lock_guard<std::mutex> lock(tilesMutex);
+    std::vector<std::shared_ptr<Tile> > resident;
+    for(auto tile : tiles)
+        if(tile->state == TileState::RESIDENT)
+            resident.push_back(tile);
+    return resident;
+}
+
+std::shared_ptr<TileManager::Tile> TileManager::getNearestResidentTile(const double point[3]) const
+{
+    std::shared_ptr<Tile> nearest;
+    double minDistance = std::numeric_limits<double>::max();
+    for(auto tile : getResidentTiles())
+    {
+        double distance = tile->getDistance(point);
+        if(distance < minDistance)
+        {
+            minDistance = distance;
+            nearest = tile;
+        }
+    }
+    return nearest;
+}
+
+std::shared_ptr<TileManager::Tile> TileManager::getTile(unsigned int id) const
+{
+    std::lock_guard<std::mutex> lock(tilesMutex);
+    if(id >= tiles.size())
+        return nullptr;
+    return tiles[id];
+}
+
+size_t TileManager::getTilesNumber() const
+{
+    std::lock_guard<std::mutex> lock(tilesMutex);
+    return tiles.size();
+}
+
+void TileManager::getBounds(double bounds[6]) const
+{
+    std::copy(this->bounds, this->bounds + 6, bounds);
+}
+
+void TileManager::setPinnedTile(int id)
+{
+    std::lock_guard<std::mutex> lock(tilesMutex);
+    pinnedTile = id < static_cast<int>(tiles.size()) ? id : -1;
+}
+
+int TileManager::getPinnedTile() const
+{
+    return pinnedTile;
+}
+
+size_t TileManager::getMemoryBudget() const
+{
+    return memoryBudget;
+}
+
+void TileManager::setMemoryBudget(size_t newMemoryBudget)
+{
+    memoryBudget = newMemoryBudget;
+}
+
+double TileManager::getResidentRadius() const
+{
+    return residentRadius;
+}
+
+void TileManager::setResidentRadius(double newResidentRadius)
+{
+    residentRadius = newResidentRadius;
+}
+
+std::string TileManager::getAnnotationsFilename(const std::string &tileFilename)
+{
+    size_t dot = tileFilename.find_last_of('.');
+    size_t slash = tileFilename.find_last_of('/');
+    std::string base = (dot != std::string::npos && (slash == std::string::npos || dot > slash)) ? tileFilename.substr(0, dot) : tileFilename;
+    return base + "." + BinaryAnnotationFileManager::EXTENSION;
+}
+
+void TileManager::buildIndex()
+{
+    bounds[0] = bounds[2] = bounds[4] = std::numeric_limits<double>::max();
+    bounds[1] = bounds[3] = bounds[5] = -std::numeric_limits<double>::max();
+    double averageExtent = 0;
+    for(auto tile : tiles)
+    {
+        double extent = 0;
+        for(unsigned int i = 0; i < 3; i++)
+        {
+            bounds[2 * i] = std::min(bounds[2 * i], tile->bounds[2 * i]);
+            bounds[2 * i + 1] = std::max(bounds[2 * i + 1], tile->bounds[2 * i + 1]);
+            extent = std::max(extent, tile->bounds[2 * i + 1] - tile->bounds[2 * i]);
+        }
+        averageExtent += extent / tiles.size();
+    }
+
+    //Cells as large as an average tile, so that each tile falls in a handful of them
+    cellSize = std::max(averageExtent, 1e-6);
+    for(unsigned int i = 0; i < 3; i++)
+    {
+        double extent = bounds[2 * i + 1] - bounds[2 * i];
+        cellSize = std::max(cellSize, extent / MAX_GRID_SIZE);
+    }
+    for(unsigned int i = 0; i < 3; i++)
+        gridSize[i] = std::max(1u, static_cast<unsigned int>(std::ceil((bounds[2 * i + 1] - bounds[2 * i]) / cellSize)));
+
+    cells.assign(static_cast<size_t>(gridSize[0]) * gridSize[1] * gridSize[2], std::vector<unsigned int>());
+    for(auto tile : tiles)
+    {
+        unsigned int minCell[3], maxCell[3];
+        for(unsigned int i = 0; i < 3; i++)
+        {
+            minCell[i] = std::min(gridSize[i] - 1, static_cast<unsigned int>((tile->bounds[2 * i] - bounds[2 * i]) / cellSize));
+            maxCell[i] = std::min(gridSize[i] - 1, static_cast<unsigned int>((tile->bounds[2 * i + 1] - bounds[2 * i]) / cellSize));
+        }
+        for(unsigned int z = minCell[2]; z <= maxCell[2]; z++)
+            for(unsigned int y = minCell[1]; y <= maxCell[1]; y++)
+                for(unsigned int x = minCell[0]; x <= maxCell[0]; x++)
+                    cells[x + gridSize[0] * (y + static_cast<size_t>(gridSize[1]) * z)].push_back(tile->id);
+    }
+}
+
+std::vector<unsigned int> TileManager::queryIndex(const double point[3], double radius) const
+{
+    std::vector<unsigned int> found;
+    if(radius <= 0)
+    {
+        for(auto tile : tiles)
+            found.push_back(tile->id);
+        return found;
+    }
+
+    unsigned int minCell[3], maxCell[3];
+    for(unsigned int i = 0; i < 3; i++)
+    {
+        double minCoord = std::max(point[i] - radius - bounds[2 * i], 0.0);
+        double maxCoord = point[i] + radius - bounds[2 * i];
+        if(maxCoord < 0 || minCoord > bounds[2 * i + 1] - bounds[2 * i])
+            return found;
+        minCell[i] = std::min(gridSize[i] - 1, static_cast<unsigned int>(minCoord / cellSize));
+        maxCell[i] = std::min(gridSize[i] - 1, static_cast<unsigned int>(maxCoord / cellSize));
+    }
+
+    std::vector<bool> seen(tiles.size(), false);
+    for(unsigned int z = minCell[2]; z <= maxCell[2]; z++)
+        for(unsigned int y = minCell[1]; y <= maxCell[1]; y++)
+            for(unsigned int x = minCell[0]; x <= maxCell[0]; x++)
+                for(auto id : cells[x + gridSize[0] * (y + static_cast<size_t>(gridSize[1]) * z)])
+                    if(!seen[id] && tiles[id]->getDistance(point) <= radius)
+                    {
+                        seen[id] = true;
+                        found.push_back(id);
+                    }
+    return found;
+}
+
+void TileManager::startWorkers()
+{
+    stopping = false;
+    unsigned int workersNumber = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2));
+    for(unsigned int i = 0; i < workersNumber; i++)
+        workers.push_back(std::thread(&TileManager::work, this));
+}
+
+void TileManager::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(tilesMutex);
+        stopping = true;
+    }
+    tasksCondition.notify_all();
+    for(auto &worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+void TileManager::work()
+{
+    while(true)
+    {
+        Task task;
+        std::shared_ptr<Tile> tile;
+        {
+            std::unique_lock<std::mutex> lock(tilesMutex);
+            tasksCondition.wait(lock, [this](){ return stopping || !tasks.empty(); });
+            if(stopping)
+                return;
+            task = tasks.front();
+            tasks.pop_front();
+            tile = tiles[task.tile];
+        }
+        if(task.load)
+            loadTile(tile);
+        else
+            evictTile(tile);
+    }
+}
+
+void TileManager::loadTile(const std::shared_ptr<Tile> &tile)
+{
+    try
+    {
+        auto mesh = std::make_shared<DrawableTriangleMesh>();
+        mesh->load(tile->filename);
+
+        //The tile is parsed once, by the library: the id-tagged dataset is built from its surface
+        vtkSmartPointer<vtkPolyData> surface = vtkPolyData::SafeDownCast(mesh->getSurfaceActor()->GetMapper()->GetInputAsDataSet());
+        auto idDataset = std::make_shared<MeshIdDataset>();
+        idDataset->setSurface(surface);
+        idDataset->getDataset();
+        auto meshCache = MeshSidecarCache::open(tile->filename, surface);
+
+        std::string annotationsFilename = getAnnotationsFilename(tile->filename);
+        if(access(annotationsFilename.c_str(), F_OK) == 0)
+        {
+            BinaryAnnotationFileManager manager;
+            manager.setMesh(mesh);
+            auto annotations = manager.readAnnotations(annotationsFilename);
+            if(!manager.getError().empty())
+                emit(loadingFailed(QString::fromStdString(manager.getError())));
+            else
+                mesh->setAnnotations(annotations);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(tilesMutex);
+            tile->mesh = mesh;
+            tile->idDataset = idDataset;
+            tile->meshCache = meshCache;
+            tile->state = TileState::RESIDENT;
+        }
+        emit(tileLoaded(tile->id));
+    } catch(const std::exception &e)
+    {
+        {
+            std::lock_guard<std::mutex> lock(tilesMutex);
+            tile->state = TileState::UNLOADED;
+        }
+        emit(loadingFailed("Unable to load the tile " + QString::fromStdString(tile->filename) + ": " + e.what()));
+    }
+}
+
+void TileManager::evictTile(const std::shared_ptr<Tile> &tile)
+{
+    writeAnnotations(tile);
+    std::lock_guard<std::mutex> lock(tilesMutex);
+    tile->mesh = nullptr;
+    tile->idDataset = nullptr;
+    tile->meshCache = nullptr;
+    tile->state = TileState::UNLOADED;
+}
+
+bool TileManager::readTileInfo(Tile &tile)
+{
+    auto file = MappedFile::open(tile.filename);
+    if(file == nullptr)
+        return false;
+    PLYHeader header;
+    if(!header.parse(file->getData(), file->getSize()))
+        return false;
+    const PLYHeader::Element* vertices = header.getElement("vertex");
+    const PLYHeader::Element* faces = header.getElement("face");
+    if(vertices == nullptr || vertices->count == 0)
+        return false;
+    tile.estimatedBytes = vertices->count * BYTES_PER_VERTEX + (faces != nullptr ? faces->count * BYTES_PER_TRIANGLE : 0);
+    PLYHeader::Format format = header.getFormat();
+    file.reset();
+
+    //The bounds only need the vertex block: the faces are not read. Big endian files are left to vtk
+    if(format == PLYHeader::Format::BINARY_LITTLE_ENDIAN && PLYMappedReader::canRead(tile.filename))
+        return PLYMappedReader::readBounds(tile.filename, tile.bounds);
+    if(format == PLYHeader::Format::ASCII)
+        return PLYAsciiReader::readBounds(tile.filename, tile.bounds);
+    auto reader = vtkSmartPointer<vtkPLYReader>::New();
+    reader->SetFileName(tile.filename.c_str());
+    reader->Update();
+    vtkSmartPointer<vtkPolyData> geometry = reader->GetOutput();
+    if(geometry == nullptr || geometry->GetNumberOfPoints() == 0)
+        return false;
+    geometry->GetBounds(tile.bounds);
+    return true;
+}
+
+void TileManager::writeAnnotations(const std::shared_ptr<Tile> &tile)
+{
+    if(tile->mesh == nullptr)
+        return;
+    std::string annotationsFilename = getAnnotationsFilename(tile->filename);
+    //A tile without annotations and without a file has nothing to persist
+    if(tile->mesh->getAnnotations().empty() && access(annotationsFilename.c_str(), F_OK) != 0)
+        return;
+    BinaryAnnotationFileManager manager;
+    manager.setMesh(tile->mesh);
+    if(!manager.writeAnnotations(annotationsFilename))
+        std::cout << "Unable to write the annotations of tile " << tile->id << ": " << manager.getError() << std::endl << std::flush;
+}
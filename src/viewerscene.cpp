@@ -0,0 +1,106 @@
+#include "viewerscene.hpp"
+
+#include <vtkDataSetMapper.h>
+#include <vtkNamedColors.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkProperty.h>
+#include <vtkUnstructuredGrid.h>
+
+using namespace std;
+using namespace Drawables;
+
+ViewerScene::ViewerScene()
+{
+    renderer = vtkSmartPointer<vtkRenderer>::New();
+    renderer->SetBackground(1, 1, 1);
+    canvas = vtkSmartPointer<vtkPropAssembly>::New();
+    renderer->AddActor(canvas);
+    sceneCache = std::make_shared<SceneCache>();
+    sceneCache->setAssembly(canvas);
+    sceneCache->setRenderer(renderer);
+
+    vtkNew<vtkNamedColors> colors;
+    vtkNew<vtkPoints> points;
+    points->InsertNextPoint(1, 0, 0);
+    points->InsertNextPoint(0, 1, 0);
+    points->InsertNextPoint(0, 0, 1);
+    points->InsertNextPoint(-1, -1, 0);
+    vtkNew<vtkUnstructuredGrid> unstructuredGrid;
+    unstructuredGrid->SetPoints(points);
+    vtkIdType ptIds[] = {0, 1, 2, 3};
+    unstructuredGrid->InsertNextCell(VTK_TETRA, 4, ptIds);
+    vtkNew<vtkDataSetMapper> mapper;
+    mapper->SetInputData(unstructuredGrid);
+    placeholder = vtkSmartPointer<vtkActor>::New();
+    placeholder->SetMapper(mapper);
+    placeholder->GetProperty()->SetColor(colors->GetColor3d("Cyan").GetData());
+    placeholderVisible = false;
+    framingPending = false;
+}
+
+void ViewerScene::attach(vtkRenderWindow *window)
+{
+    if(!window->HasRenderer(renderer))
+        window->AddRenderer(renderer);
+}
+
+void ViewerScene::setContent(const std::shared_ptr<DrawableTriangleMesh> &mesh)
+{
+    if(mesh == sceneCache->getMesh())
+        return;
+    sceneCache->setMesh(mesh);
+    if(mesh != nullptr)
+        framingPending = true;
+}
+
+void ViewerScene::update()
+{
+    sceneCache->update();
+    //Bounds are known only once the content has been drawn
+    if(framingPending)
+        resetCamera();
+}
+
+void ViewerScene::resetCamera()
+{
+    renderer->ResetCamera();
+    framingPending = false;
+}
+
+void ViewerScene::resetCamera(const double bounds[6])
+{
+    renderer->ResetCamera(bounds);
+    framingPending = false;
+}
+
+bool ViewerScene::getPlaceholderVisible() const
+{
+    return placeholderVisible;
+}
+
+void ViewerScene::setPlaceholderVisible(bool newPlaceholderVisible)
+{
+    if(newPlaceholderVisible == placeholderVisible)
+        return;
+    placeholderVisible = newPlaceholderVisible;
+    if(placeholderVisible)
+        canvas->AddPart(placeholder);
+    else
+        canvas->RemovePart(placeholder);
+}
+
+vtkSmartPointer<vtkRenderer> ViewerScene::getRenderer() const
+{
+    return renderer;
+}
+
+vtkSmartPointer<vtkPropAssembly> ViewerScene::getCanvas() const
+{
+    return canvas;
+}
+
+std::shared_ptr<SceneCache> ViewerScene::getSceneCache() const
+{
+    return sceneCache;
+}
@@ -0,0 +1,141 @@
+#include <idbuffer.hpp>
+
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/**
+ * Checks IdBuffer::render on known occlusion cases, without any window or GPU (run by ctest).
+ * The matrix is the identity: x and y are already normalised device coordinates and the depth grows with z.
+ * The program exits with 1 if a check fails.
+ */
+
+static const double IDENTITY[16] = {1, 0, 0, 0,
+                                    0, 1, 0, 0,
+                                    0, 0, 1, 0,
+                                    0, 0, 0, 1};
+
+static vtkIdType addPoint(vtkPoints* points, double x, double y, double z)
+{
+    return points->InsertNextPoint(x, y, z);
+}
+
+static void addTriangle(vtkCellArray* polys, vtkIdType v0, vtkIdType v1, vtkIdType v2)
+{
+    vtkIdType ids[3] = {v0, v1, v2};
+    polys->InsertNextCell(3, ids);
+}
+
+//Square of side 2 * half centred in (x, y), split in two triangles
+static void addQuad(vtkPoints* points, vtkCellArray* polys, double x, double y, double z, double half)
+{
+    vtkIdType v0 = addPoint(points, x - half, y - half, z);
+    vtkIdType v1 = addPoint(points, x + half, y - half, z);
+    vtkIdType v2 = addPoint(points, x + half, y + half, z);
+    vtkIdType v3 = addPoint(points, x - half, y + half, z);
+    addTriangle(polys, v0, v1, v2);
+    addTriangle(polys, v0, v2, v3);
+}
+
+static vtkSmartPointer<vtkPolyData> makeSurface(vtkPoints* points, vtkCellArray* polys)
+{
+    auto surface = vtkSmartPointer<vtkPolyData>::New();
+    surface->SetPoints(points);
+    surface->SetPolys(polys);
+    return surface;
+}
+
+static bool check(bool condition, const std::string &description)
+{
+    std::cout << (condition ? "  ok    " : "  FAIL  ") << description << std::endl;
+    return condition;
+}
+
+static bool checkStackedQuads()
+{
+    std::cout << "Two stacked quads" << std::endl;
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    auto polys = vtkSmartPointer<vtkCellArray>::New();
+    addQuad(points, polys, 0, 0, -0.5, 0.5);        //Triangles 0 and 1, in front
+    addQuad(points, polys, 0, 0, 0.5, 0.5);         //Triangles 2 and 3, behind
+    auto surface = makeSurface(points, polys);
+
+    IdBuffer buffer;
+    buffer.render(surface, IDENTITY, 64, 64);
+    bool passed = true;
+    passed &= check(buffer.isTriangleVisible(0) && buffer.isTriangleVisible(1), "the front quad is visible");
+    passed &= check(!buffer.isTriangleVisible(2) && !buffer.isTriangleVisible(3), "the back quad is hidden");
+    passed &= check(buffer.getId(32, 32) <= 1, "the centre shows the front quad");
+    passed &= check(buffer.getId(2, 2) == IdBuffer::NO_ID, "the corner shows nothing");
+    return passed;
+}
+
+static bool checkHiddenVertices()
+{
+    std::cout << "Triangle with hidden vertices and a visible interior" << std::endl;
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    auto polys = vtkSmartPointer<vtkCellArray>::New();
+    vtkIdType v0 = addPoint(points, -0.8, -0.8, 0.5);
+    vtkIdType v1 = addPoint(points, 0.8, -0.8, 0.5);
+    vtkIdType v2 = addPoint(points, 0, 0.8, 0.5);
+    addTriangle(polys, v0, v1, v2);                 //Triangle 0, behind
+    addQuad(points, polys, -0.8, -0.8, -0.5, 0.2);  //One occluder around each vertex
+    addQuad(points, polys, 0.8, -0.8, -0.5, 0.2);
+    addQuad(points, polys, 0, 0.8, -0.5, 0.2);
+    auto surface = makeSurface(points, polys);
+
+    IdBuffer buffer;
+    buffer.render(surface, IDENTITY, 64, 64);
+    bool passed = true;
+    passed &= check(!buffer.isPointVisible(v0) && !buffer.isPointVisible(v1) && !buffer.isPointVisible(v2), "its vertices are hidden");
+    passed &= check(buffer.isTriangleVisible(0), "the triangle is visible");
+    passed &= check(buffer.getId(32, 28) == 0, "the centre shows the triangle");
+    return passed;
+}
+
+static bool checkSubPixelTriangles()
+{
+    std::cout << "Triangles smaller than a pixel" << std::endl;
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    auto polys = vtkSmartPointer<vtkCellArray>::New();
+    addQuad(points, polys, 0, 0, 0, 0.5);           //Triangles 0 and 1, from pixel 16 to 48
+    double d = 0.01;                                //A third of a pixel at 64 pixels
+    //Triangle 2 shares the corner of the quad and covers no pixel centre
+    vtkIdType corner = 2;
+    addTriangle(polys, corner, addPoint(points, 0.5 + d, 0.5, 0), addPoint(points, 0.5, 0.5 + d, 0));
+    //Triangle 3 is as small, just behind the quad
+    vtkIdType v = addPoint(points, 0.1, 0.1, 0.5);
+    addTriangle(polys, v, addPoint(points, 0.1 + d, 0.1, 0.5), addPoint(points, 0.1, 0.1 + d, 0.5));
+    //Triangle 4 is as small, alone in the empty part of the view
+    v = addPoint(points, -0.8, 0.8, 0);
+    addTriangle(polys, v, addPoint(points, -0.8 + d, 0.8, 0), addPoint(points, -0.8, 0.8 + d, 0));
+    auto surface = makeSurface(points, polys);
+
+    IdBuffer buffer;
+    buffer.render(surface, IDENTITY, 64, 64);
+    bool passed = true;
+    passed &= check(buffer.isTriangleVisible(2), "a triangle next to a visible neighbour is visible");
+    passed &= check(!buffer.isTriangleVisible(3), "a triangle behind the quad is hidden");
+    passed &= check(!buffer.isTriangleVisible(4), "a triangle with nothing drawn around it is not visible");
+    return passed;
+}
+
+int main()
+{
+    bool passed = true;
+    passed &= checkStackedQuads();
+    passed &= checkHiddenVertices();
+    passed &= checkSubPixelTriangles();
+    if(!passed)
+    {
+        std::cerr << "Some checks failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}